@@ -0,0 +1,44 @@
+'use strict';
+const common = require('../common');
+
+const bench = common.createBenchmark(main, {
+  content: ['ascii', 'latin1', 'two-bytes', 'three-bytes', 'four-bytes'],
+  op: ['byteLength', 'from', 'write'],
+  len: [16, 1024],
+  n: [1e6]
+});
+
+// 16 chars each
+const chars = {
+  'ascii': 'hello brendan!!!',
+  'latin1': 'café crème brûlé',
+  'two-bytes': 'ΰαβγδεζηθικλμνξο',
+  'three-bytes': '挰挱挲挳挴挵挶挷挸挹挺挻挼挽挾挿',
+  'four-bytes': '𠜎𠜱𠝹𠱓𠱸𠲖𠳏𠳕',
+};
+
+function main({ n, len, content, op }) {
+  const chunk = chars[content];
+  const string = chunk.repeat(Math.ceil(len / chunk.length));
+  const expected = Buffer.byteLength(string, 'utf8');
+  const buf = Buffer.allocUnsafe(expected);
+
+  bench.start();
+  for (let i = 0; i < n; i++) {
+    let r;
+    switch (op) {
+      case 'byteLength':
+        r = Buffer.byteLength(string, 'utf8');
+        break;
+      case 'from':
+        r = Buffer.from(string, 'utf8').length;
+        break;
+      case 'write':
+        r = buf.write(string, 0, 'utf8');
+        break;
+    }
+    if (r !== expected)
+      throw new Error('incorrect return value');
+  }
+  bench.end(n);
+}
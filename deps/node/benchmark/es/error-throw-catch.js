@@ -0,0 +1,42 @@
+'use strict';
+const common = require('../common.js');
+const fs = require('fs');
+
+const bench = common.createBenchmark(main, {
+  method: ['throw', 'fs-enoent'],
+  stack: ['ignored', 'read'],
+  depth: [1, 20],
+  n: [1e5]
+});
+
+function throwAt(depth) {
+  if (depth > 1)
+    return throwAt(depth - 1);
+  throw new TypeError('invalid value');
+}
+
+function statAt(depth) {
+  if (depth > 1)
+    return statAt(depth - 1);
+  fs.statSync('/nonexistent/path/for/benchmark');
+}
+
+function main({ method, stack, depth, n }) {
+  const fn = method === 'throw' ? throwAt : statAt;
+  const readStack = stack === 'read';
+  let length = 0;
+
+  bench.start();
+  for (let i = 0; i < n; i++) {
+    try {
+      fn(depth);
+    } catch (e) {
+      if (readStack)
+        length += e.stack.length;
+    }
+  }
+  bench.end(n);
+
+  if (readStack && length === 0)
+    throw new Error('stack was not created');
+}
@@ -339,7 +339,7 @@ class MemWatcher extends EventEmitter {
   }
 
   #hasListener() {
-    return ['stats', 'max', 'limit'].some(
+    return ['stats', 'max', 'limit', 'pressure'].some(
       (event) => this.listeners(event).length > 0,
     );
   }
@@ -349,6 +349,7 @@ class MemWatcher extends EventEmitter {
       case 'max':
       case 'stats':
       case 'limit':
+      case 'pressure':
         if (this.#hasListener() == false) {
           this.#statsTimerId = setInterval(() => {
             let result = this.#diff.check();
@@ -361,6 +362,10 @@ class MemWatcher extends EventEmitter {
             if (this.listeners('max').length) {
               this.#maxTracker?.update(result.max[this.#memType][1]);
             }
+
+            if (this.listeners('pressure').length) {
+              this.#emitPressureEvents();
+            }
           }, this.#delay);
         }
         break;
@@ -369,6 +374,20 @@ class MemWatcher extends EventEmitter {
     }
   }
 
+  #emitPressureEvents() {
+    const events = rawMethods.getMemoryPressureEvents?.() ?? [];
+    for (const { level, usedBefore, usedAfter, time } of events) {
+      const freed = usedBefore - usedAfter;
+      this.emit('pressure', {
+        level,
+        time: new Date(time),
+        usedBefore: formatMemStats(usedBefore),
+        usedAfter: formatMemStats(usedAfter),
+        freed: formatMemStats(freed, { signed: true }),
+      });
+    }
+  }
+
   #onremoveListener(event) {
     switch (event) {
       case 'max':
@@ -378,6 +397,7 @@ class MemWatcher extends EventEmitter {
         this.#limitTracker?.reset();
       // fall-through
       case 'stats':
+      case 'pressure':
         if (this.#hasListener() == false) {
           this.end();
         }
@@ -89,6 +89,31 @@ function wrapLWNodeMethods(binding) {
       _internalLog(`feature '${name}': ${enabled}`);
       return enabled;
     },
+    notifyMemoryPressure: (...args) => {
+      if (binding.notifyMemoryPressure) {
+        return binding.notifyMemoryPressure.apply(null, args);
+      }
+    },
+    setMemoryPressureThresholds: (...args) => {
+      if (binding.setMemoryPressureThresholds) {
+        return binding.setMemoryPressureThresholds.apply(null, args);
+      }
+    },
+    getApiSymbolStats: (...args) => {
+      if (binding.getApiSymbolStats) {
+        return binding.getApiSymbolStats.apply(null, args);
+      }
+    },
+    getArrayBufferStats: (...args) => {
+      if (binding.getArrayBufferStats) {
+        return binding.getArrayBufferStats.apply(null, args);
+      }
+    },
+    getGCPauseStats: (...args) => {
+      if (binding.getGCPauseStats) {
+        return binding.getGCPauseStats.apply(null, args);
+      }
+    },
     hasSystemInfo: (...args) => {
       if (binding.hasSystemInfo) {
         return binding.hasSystemInfo.apply(null, args);
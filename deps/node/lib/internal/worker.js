@@ -79,14 +79,10 @@ let debug = require('internal/util/debuglog').debuglog('worker', (fn) => {
 let cwdCounter;
 
 if (isMainThread) {
-  // @lwnode
-  // cwdCounter = new Uint32Array(new SharedArrayBuffer(4));
-  cwdCounter = new Uint32Array(new ArrayBuffer(4));
+  cwdCounter = new Uint32Array(new SharedArrayBuffer(4));
   const originalChdir = process.chdir;
   process.chdir = function(path) {
-    // @lwnode
-    // Atomics.add(cwdCounter, 0, 1);
-    cwdCounter[0] = 1;
+    Atomics.add(cwdCounter, 0, 1);
     originalChdir(path);
   };
 }
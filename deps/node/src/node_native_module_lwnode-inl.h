@@ -16,10 +16,16 @@
 
 #pragma once
 
-#include <unzip.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
 #include <codecvt>
+#include <list>
 #include <locale>
-#include <map>
+#include <mutex>
+#include <unordered_map>
 #include "lwnode-loader.h"
 #include "lwnode.h"
 #include "node_native_module.h"
@@ -34,46 +40,13 @@ using v8::Local;
 using v8::MaybeLocal;
 using v8::String;
 
-class ArchiveFileScope {
- public:
-  ArchiveFileScope() = default;
-  ArchiveFileScope(const char* path) { open(path); }
-  ~ArchiveFileScope() {
-    if (file_) {
-      unzClose(file_);
-    }
-  }
-
-  void open(const char* path) {
-    if (file_ == nullptr) {
-      file_ = unzOpen(path);
-    }
-  }
-
-  bool isFileOpened() { return (file_ != nullptr) ? true : false; }
-  unzFile file() { return file_; }
-
- private:
-  unzFile file_{nullptr};
-};
-
-struct UnzFileCachedInfo {
-  unz_file_pos position{0, 0};
-  uLong uncompressedSize{0};
-};
-
 enum class ReaderError {
   NO_ERROR = 0,
-  UNZ_OPEN_CURRENTFILE,
-  UNZ_GOTO_FIRSTFILE,
-  UNZ_GET_CURRENTFILEINFO,
-  READ_CURRENTFILE_FROMARCHIVE,
+  OPEN_ARCHIVE,
+  READ_CENTRAL_DIRECTORY,
   READ_FILE_FROMARCHIVE
 };
 
-static thread_local ArchiveFileScope s_archiveFileScope;
-static thread_local std::map<std::string, UnzFileCachedInfo>
-    s_unzFileInfoDictionary;
 static thread_local ReaderError s_lastError = ReaderError::NO_ERROR;
 
 std::string getSelfProcPath() {
@@ -91,132 +64,222 @@ void setError(ReaderError error) {
   ERROR_AND_ABORT(s_lastError);
 }
 
-bool readCurrentFileFromArchive(const unzFile file,
-                                uLong uncompressedSize,
-                                char** buffer,
-                                size_t* fileSize) {
-  if (unzOpenCurrentFile(file) < 0) {
-    setError(ReaderError::UNZ_OPEN_CURRENTFILE);
-    return false;
+// The builtins archive is mapped, and its central directory is indexed once
+// per process. Both are read-only afterwards, so all threads (e.g. workers)
+// share them without locking. The archive stores its files uncompressed (see
+// node.gyp), so reading a file is a copy out of the mapping. Deflated files
+// are inflated once and kept in a bounded LRU cache.
+class BuiltinArchive {
+ public:
+  static constexpr size_t kInflatedCacheCapacity = 1024 * 1024;
+
+  struct Entry {
+    size_t dataOffset{0};
+    size_t compressedSize{0};
+    size_t uncompressedSize{0};
+    uint16_t method{0};
+  };
+
+  static BuiltinArchive* getInstance() {
+    static BuiltinArchive* s_archive = []() {
+      std::string path = getSelfProcPath();
+      path = path.substr(0, path.rfind('/') + 1);
+      return new BuiltinArchive(path + LWNODE_EXTERNAL_BUILTINS_FILENAME);
+    }();
+    return s_archive;
   }
 
-  *fileSize = uncompressedSize;
-  *buffer = (char*)allocateStringBuffer(uncompressedSize + 1);
+  // Returns the content of the file in a new string buffer terminated by
+  // '\0', or nullptr if it isn't found. Files in the mapping aren't
+  // terminated, so even a stored file is copied.
+  char* read(const std::string& filename, size_t* size) {
+    auto it = entries_.find(filename);
+    if (it == entries_.end()) {
+      return nullptr;
+    }
 
-  bool result = true;
+    const Entry& entry = it->second;
+    *size = entry.uncompressedSize;
+    auto buffer = reinterpret_cast<char*>(allocateStringBuffer(*size + 1));
+    buffer[*size] = '\0';
+    if (entry.method == kStored) {
+      memcpy(buffer, base_ + entry.dataOffset, *size);
+      return buffer;
+    }
 
-  if (unzReadCurrentFile(file, *buffer, *fileSize) < 0) {
-    freeStringBuffer(buffer);
-    buffer = nullptr;
-    result = false;
-  } else {
-    (*buffer)[*fileSize] = '\0';
+    if (readInflatedFromCache(filename, buffer, *size)) {
+      return buffer;
+    }
+    if (!inflateEntry(entry, buffer)) {
+      freeStringBuffer(buffer);
+      return nullptr;
+    }
+    addInflatedToCache(filename, buffer, *size);
+    return buffer;
   }
 
-  unzCloseCurrentFile(file);
-  return result;
-}
+ private:
+  static constexpr uint32_t kEndOfCentralDirectorySignature = 0x06054b50;
+  static constexpr uint32_t kCentralDirectorySignature = 0x02014b50;
+  static constexpr uint32_t kLocalFileHeaderSignature = 0x04034b50;
+  static constexpr size_t kEndOfCentralDirectorySize = 22;
+  static constexpr size_t kCentralDirectoryHeaderSize = 46;
+  static constexpr size_t kLocalFileHeaderSize = 30;
+  static constexpr uint16_t kStored = 0;
+  static constexpr uint16_t kDeflated = 8;
+
+  explicit BuiltinArchive(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      setError(ReaderError::OPEN_ARCHIVE);
+      return;
+    }
 
-bool readFileFromArchive(const std::string& archiveFilename,
-                         const std::string& filename,
-                         char** buffer,
-                         size_t* fileSize) {
-  DCHECK_NOT_NULL(buffer);
-  DCHECK_NOT_NULL(fileSize);
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void* memory =
+          mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (memory != MAP_FAILED) {
+        base_ = reinterpret_cast<const char*>(memory);
+        length_ = st.st_size;
+      }
+    }
+    close(fd);
 
-  if (s_archiveFileScope.isFileOpened() == false) {
-    s_archiveFileScope.open(archiveFilename.c_str());
+    if (!base_ || !indexCentralDirectory()) {
+      setError(ReaderError::READ_CENTRAL_DIRECTORY);
+    }
   }
 
-  const unzFile file = s_archiveFileScope.file();
-  CHECK_NOT_NULL(file);
-
-  // 1.1 check if the cache on this filename exists
-  const auto& it = s_unzFileInfoDictionary.find(filename);
-  if (it != s_unzFileInfoDictionary.end()) {
-    UnzFileCachedInfo cache = it->second;
-
-    // 1.2 move the file position using the cached info and read the data
-    unzGoToFilePos(file, &cache.position);
-    return readCurrentFileFromArchive(
-        file, cache.uncompressedSize, buffer, fileSize);
+  uint16_t read16(size_t offset) const {
+    auto p = reinterpret_cast<const uint8_t*>(base_ + offset);
+    return p[0] | (p[1] << 8);
   }
 
-  // 2. read the data by searching the file position from the first one.
-  if (unzGoToFirstFile(file) < 0) {
-    setError(ReaderError::UNZ_OPEN_CURRENTFILE);
-    return false;
+  uint32_t read32(size_t offset) const {
+    return read16(offset) | (static_cast<uint32_t>(read16(offset + 2)) << 16);
   }
 
-  bool isFileFound = false;
-  do {
-    unz_file_info fileInfo;
-    char currentFileName[PATH_MAX];
-
-    if (unzGetCurrentFileInfo(file,
-                              &fileInfo,
-                              currentFileName,
-                              sizeof(currentFileName),
-                              nullptr,
-                              0,
-                              nullptr,
-                              0) < 0) {
-      setError(ReaderError::UNZ_GET_CURRENTFILEINFO);
+  bool indexCentralDirectory() {
+    if (length_ < kEndOfCentralDirectorySize) {
       return false;
     }
 
-    if (filename.compare(currentFileName) == 0) {
-      isFileFound = true;
-
-      // 2.1 read the data from the current file poistion
-      if (readCurrentFileFromArchive(
-              file, fileInfo.uncompressed_size, buffer, fileSize) == false) {
-        setError(ReaderError::READ_CURRENTFILE_FROMARCHIVE);
+    // the end record is followed by a comment of up to 64KB
+    size_t end = length_ - kEndOfCentralDirectorySize;
+    size_t last = (end > 0xffff) ? end - 0xffff : 0;
+    while (read32(end) != kEndOfCentralDirectorySignature) {
+      if (end == last) {
         return false;
       }
-
-      // 2.2 create the cache for this file and register it to the dictionary
-      UnzFileCachedInfo cache;
-      auto result = unzGetFilePos(file, &cache.position);
-      CHECK(result == UNZ_OK);
-      cache.uncompressedSize = fileInfo.uncompressed_size;
-
-      s_unzFileInfoDictionary[filename] = cache;
-      break;
+      end--;
     }
 
-  } while (unzGoToNextFile(file) != UNZ_END_OF_LIST_OF_FILE);
+    size_t count = read16(end + 10);
+    size_t offset = read32(end + 16);
+    entries_.reserve(count);
 
-  return isFileFound;
-}
+    for (size_t i = 0; i < count; i++) {
+      if (offset + kCentralDirectoryHeaderSize > length_ ||
+          read32(offset) != kCentralDirectorySignature) {
+        return false;
+      }
+
+      Entry entry;
+      entry.method = read16(offset + 10);
+      entry.compressedSize = read32(offset + 20);
+      entry.uncompressedSize = read32(offset + 24);
+      size_t nameLength = read16(offset + 28);
+      size_t extraLength = read16(offset + 30);
+      size_t commentLength = read16(offset + 32);
+      size_t header = read32(offset + 42);
+
+      if (header + kLocalFileHeaderSize > length_ ||
+          read32(header) != kLocalFileHeaderSignature) {
+        return false;
+      }
+      entry.dataOffset = header + kLocalFileHeaderSize + read16(header + 26) +
+                         read16(header + 28);
+      if (entry.dataOffset + entry.compressedSize > length_) {
+        return false;
+      }
 
-FileData readFileFromArchive(std::string filename,
-                             const Encoding encodingHint) {
-  CHECK(encodingHint != Encoding::kUnknown);
+      entries_.emplace(
+          std::string(base_ + offset + kCentralDirectoryHeaderSize,
+                      nameLength),
+          entry);
+      offset += kCentralDirectoryHeaderSize + nameLength + extraLength +
+                commentLength;
+    }
+    return true;
+  }
 
-  size_t bufferSize = 0;
-  char* buffer = nullptr;
+  bool inflateEntry(const Entry& entry, char* buffer) {
+    if (entry.method != kDeflated) {
+      return false;
+    }
 
-  static std::string s_externalBuiltinsPath;
+    z_stream stream = {};
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+      return false;
+    }
+    stream.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(base_ + entry.dataOffset));
+    stream.avail_in = entry.compressedSize;
+    stream.next_out = reinterpret_cast<Bytef*>(buffer);
+    stream.avail_out = entry.uncompressedSize;
+
+    int result = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+    return result == Z_STREAM_END &&
+           stream.total_out == entry.uncompressedSize;
+  }
 
-  if (s_externalBuiltinsPath.empty()) {
-    std::string executablePath = getSelfProcPath();
-    executablePath = executablePath.substr(0, executablePath.rfind('/') + 1);
-    s_externalBuiltinsPath = executablePath + LWNODE_EXTERNAL_BUILTINS_FILENAME;
+  bool readInflatedFromCache(const std::string& filename,
+                             char* buffer,
+                             size_t size) {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    auto it = inflatedCacheIndex_.find(filename);
+    if (it == inflatedCacheIndex_.end()) {
+      return false;
+    }
+    inflatedCache_.splice(inflatedCache_.begin(), inflatedCache_, it->second);
+    memcpy(buffer, it->second->second.data(), size);
+    return true;
   }
 
-  if (readFileFromArchive(
-          s_externalBuiltinsPath, filename, &buffer, &bufferSize) == false) {
-    setError(ReaderError::READ_FILE_FROMARCHIVE);
-    return FileData();
+  void addInflatedToCache(const std::string& filename,
+                          const char* buffer,
+                          size_t size) {
+    if (size > kInflatedCacheCapacity) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    if (inflatedCacheIndex_.count(filename)) {
+      return;
+    }
+    while (inflatedCacheSize_ + size > kInflatedCacheCapacity) {
+      auto& last = inflatedCache_.back();
+      inflatedCacheSize_ -= last.second.size();
+      inflatedCacheIndex_.erase(last.first);
+      inflatedCache_.pop_back();
+    }
+    inflatedCache_.emplace_front(filename, std::string(buffer, size));
+    inflatedCacheIndex_[filename] = inflatedCache_.begin();
+    inflatedCacheSize_ += size;
   }
 
-  std::unique_ptr<void, std::function<void(void*)>> bufferHolder(
-      buffer, freeStringBuffer);
+  const char* base_{nullptr};
+  size_t length_{0};
+  std::unordered_map<std::string, Entry> entries_;
 
-  return Loader::createFileDataForReloadableString(
-      filename, std::move(bufferHolder), bufferSize, encodingHint);
-}
+  typedef std::list<std::pair<std::string, std::string>> InflatedCache;
+  std::mutex cacheMutex_;
+  InflatedCache inflatedCache_;
+  std::unordered_map<std::string, InflatedCache::iterator> inflatedCacheIndex_;
+  size_t inflatedCacheSize_{0};
+};
 
 bool NativeModuleLoader::IsOneByte(const char* id) {
   const auto& it = source_.find(id);
@@ -245,23 +308,14 @@ class SourceReaderOnArchive : public SourceReaderInterface {
     return &s_singleton;
   }
 
-  FileData read(std::string filename, const Encoding encodingHint) {
+  FileData read(std::string filename, const Encoding encodingHint) override {
     CHECK(encodingHint != Encoding::kUnknown);
 
+    auto archive = BuiltinArchive::getInstance();
     size_t bufferSize = 0;
-    char* buffer = nullptr;
-
-    static std::string s_externalBuiltinsPath;
-
-    if (s_externalBuiltinsPath.empty()) {
-      std::string executablePath = getSelfProcPath();
-      executablePath = executablePath.substr(0, executablePath.rfind('/') + 1);
-      s_externalBuiltinsPath =
-          executablePath + LWNODE_EXTERNAL_BUILTINS_FILENAME;
-    }
+    char* buffer = archive->read(filename, &bufferSize);
 
-    if (readFileFromArchive(
-            s_externalBuiltinsPath, filename, &buffer, &bufferSize) == false) {
+    if (buffer == nullptr) {
       LWNODE_LOG_ERROR("readFileFromArchive (%s) failed:", filename);
       setError(ReaderError::READ_FILE_FROMARCHIVE);
       return FileData();
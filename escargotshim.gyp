@@ -56,10 +56,13 @@
         'src/api/utils/logger/logger.cc',
         'src/api/arraybuffer-allocator.cc',
         'src/api/arraybuffer-deleter.cc',
+        'src/api/code-cache.cc',
         'src/api/es-helper.cc',
         'src/api/es-v8-helper.cc',
         'src/api/engine.cc',
         'src/api/extra-data.cc',
+        'src/api/external-string.cc',
+        'src/api/gc-event-tracker.cc',
         'src/api/handle.cc',
         'src/api/handlescope.cc',
         'src/api/isolate.cc',
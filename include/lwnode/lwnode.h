@@ -40,6 +40,8 @@ void IdleGC(v8::Isolate* isolate = nullptr);
 void initDebugger();
 bool dumpSelfMemorySnapshot();
 
+class PressureAwareGC;
+
 class MessageLoop {
   using WakeupMainloopHandler = std::function<void()>;
 
@@ -56,6 +58,11 @@ class MessageLoop {
   void wakeupMainloopOnce();
   void setWakeupMainloopOnceHandler(PlatformHandler handler);
 
+  // A GC runs on the next iteration of the main loop under memory pressure.
+  // This can be called from any thread.
+  void notifyMemoryPressure(v8::MemoryPressureLevel level);
+  PressureAwareGC* pressureAwareGC();
+
  private:
   MessageLoop();
 
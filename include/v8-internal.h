@@ -169,6 +169,13 @@ class Internals {
   static const int kEmbedderDataArrayHeaderSize = 2 * kApiTaggedSize;
   static const int kEmbedderDataSlotSize = kApiSystemPointerSize;
   static const int kNativeContextEmbedderDataOffset = 6 * kApiTaggedSize;
+  // @lwnode
+  // ContextWrap keeps its embedder data slots right after the fields of
+  // ValueWrap (see src/api/context.h).
+  static const int kContextEmbedderDataOffset = 2 * kApiSystemPointerSize;
+  static const int kContextEmbedderDataLengthOffset =
+      3 * kApiSystemPointerSize;
+  // end @lwnode
   static const int kFullStringRepresentationMask = 0x0f;
   static const int kStringEncodingMask = 0x8;
   static const int kExternalTwoByteRepresentationTag = 0x02;
@@ -3075,11 +3075,6 @@ class V8_EXPORT String : public Name {
 
   class V8_EXPORT ExternalStringResourceBase {  // NOLINT
    public:
-    // @lwnode
-    static void* operator new(size_t size);
-    static void operator delete(void* ptr);
-    // end of @lwnode
-
     virtual ~ExternalStringResourceBase() = default;
 
     /**
@@ -12155,8 +12150,6 @@ MaybeLocal<T> Isolate::GetDataFromSnapshotOnce(size_t index) {
 
 int64_t Isolate::AdjustAmountOfExternalAllocatedMemory(
     int64_t change_in_bytes) {
-// @lwnode
-#if 0
   typedef internal::Internals I;
   int64_t* external_memory = reinterpret_cast<int64_t*>(
       reinterpret_cast<uint8_t*>(this) + I::kExternalMemoryOffset);
@@ -12184,8 +12177,6 @@ int64_t Isolate::AdjustAmountOfExternalAllocatedMemory(
     ReportExternalAllocationLimitReached();
   }
   return *external_memory;
-#endif
-  return 0;
 }
 
 Local<Value> Context::GetEmbedderData(int index) {
@@ -12236,6 +12227,19 @@ void* Context::GetAlignedPointerFromEmbedderData(int index) {
 #else
   return SlowGetAlignedPointerFromEmbedderData(index);
 #endif
+#endif
+#ifndef V8_ENABLE_CHECKS
+  // a context handle points to the ContextWrap itself, whose fields aren't
+  // tagged
+  typedef internal::Internals I;
+  const char* ctx = reinterpret_cast<const char*>(this);
+  size_t length = *reinterpret_cast<const size_t*>(
+      ctx + I::kContextEmbedderDataLengthOffset);
+  if (V8_LIKELY(static_cast<size_t>(index) < length)) {
+    void* const* slots = *reinterpret_cast<void* const* const*>(
+        ctx + I::kContextEmbedderDataOffset);
+    return slots[index];
+  }
 #endif
   return SlowGetAlignedPointerFromEmbedderData(index);
 // end @lwnode
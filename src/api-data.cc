@@ -263,7 +263,7 @@ MaybeLocal<String> Value::ToString(Local<Context> context) const {
     return Utils::NewLocal<String>(lwIsolate->toV8(), esSelf);
   }
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* state, ValueRef* esSelf) -> ValueRef* {
         return esSelf->toString(state);
@@ -291,7 +291,7 @@ MaybeLocal<Object> Value::ToObject(Local<Context> context) const {
   API_ENTER_WITH_CONTEXT(context, MaybeLocal<Object>());
   auto esContext = VAL(*context)->context()->get();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* state, ValueRef* esSelf) -> ValueRef* {
         return esSelf->toObject(state);
@@ -314,7 +314,7 @@ Local<Boolean> Value::ToBoolean(Isolate* v8_isolate) const {
   API_ENTER(v8_isolate, Local<Boolean>());
   auto esContext = lwIsolate->GetCurrentContext()->get();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState, ValueRef* esSelf) -> ValueRef* {
         return ValueRef::create(esSelf->toBoolean(esState));
@@ -330,7 +330,7 @@ MaybeLocal<Number> Value::ToNumber(Local<Context> context) const {
   API_ENTER_WITH_CONTEXT(context, MaybeLocal<Number>());
   auto esContext = lwIsolate->GetCurrentContext()->get();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState, ValueRef* esSelf) -> ValueRef* {
         return ValueRef::create(esSelf->toNumber(esState));
@@ -346,7 +346,7 @@ MaybeLocal<Integer> Value::ToInteger(Local<Context> context) const {
   API_ENTER_WITH_CONTEXT(context, MaybeLocal<Integer>());
   auto esContext = lwIsolate->GetCurrentContext()->get();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState, ValueRef* esSelf) -> ValueRef* {
         return ValueRef::create(esSelf->toInteger(esState));
@@ -362,7 +362,7 @@ MaybeLocal<Int32> Value::ToInt32(Local<Context> context) const {
   API_ENTER_WITH_CONTEXT(context, MaybeLocal<Int32>());
   auto esContext = lwIsolate->GetCurrentContext()->get();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState, ValueRef* esSelf) -> ValueRef* {
         return ValueRef::create(esSelf->toInt32(esState));
@@ -378,7 +378,7 @@ MaybeLocal<Uint32> Value::ToUint32(Local<Context> context) const {
   API_ENTER_WITH_CONTEXT(context, MaybeLocal<Uint32>());
   auto esContext = lwIsolate->GetCurrentContext()->get();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState, ValueRef* esSelf) -> ValueRef* {
         return ValueRef::create(esSelf->toUint32(esState));
@@ -488,9 +488,17 @@ void v8::WasmModuleObject::CheckCast(Value* that) {
 // void v8::debug::WasmValue::CheckCast(Value* that) {}
 
 v8::BackingStore::~BackingStore() {
+  auto esBackingStore = reinterpret_cast<BackingStoreRef*>(this);
+  // the last holder of a shared backing store may be released on a thread
+  // without an isolate (e.g. a message dropped by a worker)
+  if (esBackingStore->isShared()) {
+    IsolateWrap::removeSharedBackingStore(esBackingStore);
+    return;
+  }
+
   auto lwIsolate = IsolateWrap::GetCurrent();
   LWNODE_CHECK(lwIsolate != nullptr);
-  lwIsolate->removeBackingStore(reinterpret_cast<BackingStoreRef*>(this));
+  lwIsolate->removeBackingStore(esBackingStore);
 }
 
 void v8::BackingStore::operator delete(void* p) {
@@ -592,7 +600,7 @@ void v8::DataView::CheckCast(Value* that) {
 }
 
 void v8::SharedArrayBuffer::CheckCast(Value* that) {
-  LWNODE_RETURN_VOID;
+  LWNODE_CHECK(that->IsSharedArrayBuffer());
 }
 
 void v8::Date::CheckCast(v8::Value* that) {
@@ -631,7 +639,7 @@ Maybe<double> Value::NumberValue(Local<Context> context) const {
 
   API_ENTER_WITH_CONTEXT(context, Nothing<double>());
   auto lwContext = lwIsolate->GetCurrentContext();
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* esState, ValueRef* self) {
         return ValueRef::create(self->toNumber(esState));
@@ -650,7 +658,7 @@ Maybe<int64_t> Value::IntegerValue(Local<Context> context) const {
 
   API_ENTER_WITH_CONTEXT(context, Nothing<int64_t>());
   auto lwContext = lwIsolate->GetCurrentContext();
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* esState, ValueRef* self) {
         return ValueRef::create(self->toInteger(esState));
@@ -670,7 +678,7 @@ Maybe<int32_t> Value::Int32Value(Local<Context> context) const {
   API_ENTER_WITH_CONTEXT(context, Nothing<int32_t>());
   auto lwContext = lwIsolate->GetCurrentContext();
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* esState, ValueRef* self) {
         return ValueRef::create(self->toInt32(esState));
@@ -691,7 +699,7 @@ Maybe<uint32_t> Value::Uint32Value(Local<Context> context) const {
   auto lwContext = lwIsolate->GetCurrentContext();
 
   uint32_t value = 0;
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* esState, ValueRef* self, uint32_t* value) {
         *value = self->toUint32(esState);
@@ -709,7 +717,7 @@ MaybeLocal<Uint32> Value::ToArrayIndex(Local<Context> context) const {
   auto lwContext = lwIsolate->GetCurrentContext();
 
   uint32_t index = ValueRef::InvalidIndex32Value;
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* esState, ValueRef* self, uint32_t* index) {
         *index = self->toIndex32(esState);
@@ -730,7 +738,7 @@ Maybe<bool> Value::Equals(Local<Context> context, Local<Value> that) const {
   API_ENTER_WITH_CONTEXT(context, Nothing<bool>());
   auto lwContext = lwIsolate->GetCurrentContext();
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* esState,
          ValueRef* self,
@@ -749,7 +757,7 @@ bool Value::StrictEquals(Local<Value> that) const {
   auto lwIsolate = IsolateWrap::GetCurrent();
   auto lwContext = lwIsolate->GetCurrentContext();
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* esState,
          ValueRef* self,
@@ -791,7 +799,7 @@ Local<String> Value::TypeOf(v8::Isolate* external_isolate) {
   API_ENTER_NO_EXCEPTION(external_isolate);
   auto lwContext = lwIsolate->GetCurrentContext();
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* esState, ValueRef* self) -> ValueRef* {
         std::string type;
@@ -827,7 +835,7 @@ Maybe<bool> Value::InstanceOf(v8::Local<v8::Context> context,
   API_ENTER_WITH_CONTEXT(context, Nothing<bool>());
   auto lwContext = lwIsolate->GetCurrentContext();
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* esState,
          ValueRef* self,
@@ -1266,7 +1274,7 @@ MaybeLocal<Array> v8::Object::GetPropertyNames(
   API_ENTER_WITH_CONTEXT(context, MaybeLocal<Array>());
   auto esContext = lwIsolate->GetCurrentContext()->get();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* state,
          ObjectRef* esObject,
@@ -1423,7 +1431,7 @@ Maybe<bool> v8::Object::SetIntegrityLevel(Local<Context> context,
   API_ENTER_WITH_CONTEXT(context, Nothing<bool>());
   auto esContext = lwIsolate->GetCurrentContext()->get();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState,
          ObjectRef* esSelf,
@@ -1677,7 +1685,7 @@ Local<v8::Object> v8::Object::Clone() {
   auto esContext = lwIsolate->GetCurrentContext()->get();
   auto esSelf = CVAL(this)->value()->asObject();
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState, ObjectRef* esSelf) -> ValueRef* {
         auto constructor =
@@ -1728,7 +1736,7 @@ Local<v8::Context> v8::Object::CreationContext() {
 }
 
 int v8::Object::GetIdentityHash() {
-  LWNODE_RETURN_0;
+  return IdentityHashHelper::fromAddress(CVAL(this)->value()->asObject());
 }
 
 bool v8::Object::IsCallable() {
@@ -1800,7 +1808,7 @@ MaybeLocal<Object> Function::NewInstance(Local<Context> context,
     arguments.push_back(VAL(*argv[i])->value());
   }
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* state,
          ObjectRef* self,
@@ -1892,7 +1900,7 @@ MaybeLocal<v8::Value> Function::Call(Local<Context> context,
   }
 
   lwIsolate->increaseCallDepth();
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* state,
          IsolateWrap* lwIsolate,
@@ -1963,7 +1971,7 @@ MaybeLocal<v8::Value> Function::Call(Local<Context> context,
 }
 
 void Function::SetName(v8::Local<v8::String> name) {
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       IsolateWrap::GetCurrent()->GetCurrentContext()->get(),
       [](ExecutionStateRef* esState,
          FunctionObjectRef* esFunction,
@@ -1980,7 +1988,7 @@ void Function::SetName(v8::Local<v8::String> name) {
 Local<Value> Function::GetName() const {
   auto lwIsolate = IsolateWrap::GetCurrent();
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwIsolate->GetCurrentContext()->get(),
       [](ExecutionStateRef* esState,
          FunctionObjectRef* esFunction) -> ValueRef* {
@@ -2029,7 +2037,13 @@ Local<v8::Value> Function::GetBoundFunction() const {
 }
 
 int Name::GetIdentityHash() {
-  LWNODE_RETURN_0;
+  auto esSelf = CVAL(this)->value();
+  if (esSelf->isString()) {
+    // equal strings have the same hash, as in V8
+    return IdentityHashHelper::fromHash(
+        StringRefHelper::hash(esSelf->asString()));
+  }
+  return IdentityHashHelper::fromAddress(esSelf);
 }
 
 int String::Length() const {
@@ -2048,64 +2062,7 @@ bool String::ContainsOnlyOneByte() const {
 
 int String::Utf8Length(Isolate* isolate) const {
   auto esString = CVAL(this)->value()->asString();
-  if (StringRefHelper::isAsciiString(esString)) {
-    return esString->length();
-  } else {
-    return esString->toStdUTF8String().length();
-  }
-}
-
-static int readAUtf8Sequence(char* start, const char* end) {
-  char byte1 = *start;
-  if ((byte1 & 0x80) == 0) {
-    return 1;
-  }
-
-  char byte2 = 0;
-  char byte3 = 0;
-  char byte4 = 0;
-  for (int i = 1; i < 4 && start + i < end; i++) {
-    if (i == 1) {
-      byte2 = *(start + 1);
-      if (((byte1 & 0xE0) == 0xC0) && ((byte2 & 0xC0) == 0x80)) {
-        return 2;
-      }
-    } else if (i == 2) {
-      byte3 = *(start + 2);
-      if ((byte1 & 0xF0) == 0xE0 && (byte2 & 0xC0) == 0x80 &&
-          (byte3 & 0xC0) == 0x80) {
-        return 3;
-      }
-    } else if (i == 3) {
-      byte4 = *(start + 3);
-      if ((byte1 & 0xF8) == 0xF0 && (byte2 & 0xC0) == 0x80 &&
-          (byte3 & 0xC0) == 0x80 && (byte4 & 0xC0) == 0x80) {
-        return 4;
-      }
-    }
-  }
-
-  return -1;
-}
-
-static void copyUtf8Sequences(
-    char* dest, const char* source, int maxBytes, int* nchars, int* nbytes) {
-  char* s = const_cast<char*>(source);
-  char* d = dest;
-  for (int i = 0; i < maxBytes;) {
-    int utf8CharLength = readAUtf8Sequence(s, source + maxBytes);
-    if (utf8CharLength > 0) {
-      memcpy(d, s, utf8CharLength);
-      s += utf8CharLength;
-      d += utf8CharLength;
-      *nchars += 1;
-      *nbytes += utf8CharLength;
-      i += utf8CharLength;
-    } else {
-      // invalid char
-      break;
-    }
-  }
+  return StringRefHelper::utf8Length(esString);
 }
 
 int String::WriteUtf8(Isolate* v8_isolate,
@@ -2113,34 +2070,44 @@ int String::WriteUtf8(Isolate* v8_isolate,
                       int capacity,  // nbytes
                       int* nchars_ref,
                       int options) const {
-  int nchars = 0;
-  int nbytes = 0;
   int bufferCapacity = capacity >= 0 ? capacity : v8::String::kMaxLength;
-  int byteLength = 0;
 
   auto esString = CVAL(this)->value()->asString();
   auto bufferData = esString->stringBufferAccessData();
-
-  if (StringRefHelper::isAsciiString(esString)) {
-    byteLength = bufferData.length;
-    int maxBytes = std::min(bufferCapacity, byteLength);
-    memcpy(buffer, bufferData.buffer, maxBytes);
-    nchars = nbytes = maxBytes;
+  auto dest = reinterpret_cast<uint8_t*>(buffer);
+
+  UTF8Encoder::Result result;
+  if (bufferData.has8BitContent &&
+      StringRefHelper::encoding(esString) == StringEncoding::kAscii) {
+    result.read = std::min(bufferData.length,
+                           static_cast<size_t>(bufferCapacity));
+    result.written = result.characters = result.read;
+    memcpy(dest, bufferData.buffer, result.read);
+  } else if (bufferData.has8BitContent) {
+    result =
+        UTF8Encoder::encode(reinterpret_cast<const uint8_t*>(bufferData.buffer),
+                            bufferData.length,
+                            dest,
+                            bufferCapacity);
   } else {
-    std::string utf8Str = esString->toStdUTF8String(options);
-    byteLength = utf8Str.length();
-    int maxBytes = std::min(bufferCapacity, byteLength);
-    copyUtf8Sequences(buffer, utf8Str.data(), maxBytes, &nchars, &nbytes);
+    result = UTF8Encoder::encode(
+        reinterpret_cast<const char16_t*>(bufferData.buffer),
+        bufferData.length,
+        dest,
+        bufferCapacity,
+        options & String::REPLACE_INVALID_UTF8);
   }
 
+  int nbytes = result.written;
   bool writeNull = !(options & String::NO_NULL_TERMINATION);
-  if (writeNull && (nbytes == byteLength) && (nbytes < bufferCapacity)) {
+  if (writeNull && (result.read == bufferData.length) &&
+      (nbytes < bufferCapacity)) {
     buffer[nbytes] = '\0';
     nbytes++;
   }
 
   if (nchars_ref) {
-    *nchars_ref = nchars;
+    *nchars_ref = result.characters;
   }
 
   return nbytes;
@@ -2258,6 +2225,16 @@ int String::Write(Isolate* isolate,
   return nchars;
 }
 
+static String::ExternalStringResourceBase* externalStringResource(
+    const String* string) {
+  auto lwString = CVAL(string);
+  if (!lwString->isExternalString()) {
+    return nullptr;
+  }
+  return ExternalStringRegistry::instance()->find(
+      lwString->value()->asString());
+}
+
 bool v8::String::IsExternal() const {
   return CVAL(this)->isExternalString();
 }
@@ -2279,37 +2256,30 @@ void v8::String::VerifyExternalStringResourceBase(
 }
 
 String::ExternalStringResource* String::GetExternalStringResourceSlow() const {
-  return reinterpret_cast<ExternalStringResource*>(
-      CVAL(this)->asExternalString()->resource());
+  if (CVAL(this)->value()->asString()->has8BitContent()) {
+    return nullptr;
+  }
+  return static_cast<ExternalStringResource*>(externalStringResource(this));
 }
 
 String::ExternalStringResourceBase* String::GetExternalStringResourceBaseSlow(
     String::Encoding* encoding_out) const {
-  auto lwSelf = CVAL(this);
-  auto esSelf = lwSelf->value()->asString();
+  auto esSelf = CVAL(this)->value()->asString();
   if (esSelf->has8BitContent()) {
     *encoding_out = String::Encoding::ONE_BYTE_ENCODING;
   } else {
     *encoding_out = String::Encoding::TWO_BYTE_ENCODING;
   }
-  return lwSelf->asExternalString()->resource();
+  return externalStringResource(this);
 }
 
 const v8::String::ExternalOneByteStringResource*
 v8::String::GetExternalOneByteStringResource() const {
-  auto lwSelf = CVAL(this)->asExternalString();
-  return reinterpret_cast<ExternalOneByteStringResource*>(lwSelf->resource());
-}
-
-void* String::ExternalStringResourceBase::operator new(size_t size) {
-  ExternalStringResourceBase* buf = (ExternalStringResourceBase*)malloc(size);
-  Engine::current()->registerExternalString(buf);
-  return buf;
-}
-
-void String::ExternalStringResourceBase::operator delete(void* ptr) {
-  Engine::current()->unregisterExternalString((ExternalStringResourceBase*)ptr);
-  free(ptr);
+  if (!CVAL(this)->value()->asString()->has8BitContent()) {
+    return nullptr;
+  }
+  return static_cast<ExternalOneByteStringResource*>(
+      externalStringResource(this));
 }
 
 Local<Value> Symbol::Description() const {
@@ -2329,7 +2299,7 @@ static T getValue(ValueRef* esValue, F toValue) {
   auto lwContext = IsolateWrap::GetCurrent()->GetCurrentContext();
   LWNODE_CHECK(lwContext != nullptr);
   T outValue = 0;
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* esState, ValueRef* esValue, T* outValue, F toValue)
           -> ValueRef* {
@@ -2418,8 +2388,9 @@ void v8::Object::SetInternalField(int index, v8::Local<Value> value) {
   LWNODE_CALL_TRACE_ID(
       OBJDATA, "%s", toExtraDataString(this, index, *value).c_str());
 
-  ObjectRefHelper::setInternalField(
-      CVAL(this)->value()->asObject(), index, VAL(*value));
+  ObjectRefHelper::setInternalField(CVAL(this)->value()->asObject(),
+                                    index,
+                                    ValueWrap::detach(VAL(*value)));
 }
 
 void* v8::Object::SlowGetAlignedPointerFromInternalField(int index) {
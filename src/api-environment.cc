@@ -14,12 +14,14 @@
  * limitations under the License.
  */
 
+#include <unistd.h>  // for sysconf
 #include <memory>
 #include "api.h"
 #include "api/engine.h"
 #include "api/utils/cast.h"
 #include "base.h"
 #include "init/v8.h"
+#include "lwnode/lwnode.h"
 
 using namespace Escargot;
 using namespace EscargotShim;
@@ -475,6 +477,17 @@ Local<String> v8::String::Concat(Isolate* v8_isolate,
   return result;
 }
 
+// The handle is marked, so that IsExternal() is answered without looking the
+// resource up. Other handles to the string, e.g. the ones read back from JS,
+// are treated as the handles to heap strings.
+static Local<String> newExternalStringLocal(Isolate* isolate,
+                                            StringRef* esString) {
+  StackValueWrap lwValue(esString,
+                         HandleWrap::Type::JsValue,
+                         HandleWrap::ValueType::ExternalString);
+  return Local<String>::New(isolate, reinterpret_cast<String*>(&lwValue));
+}
+
 MaybeLocal<String> v8::String::NewExternalTwoByte(
     Isolate* isolate, v8::String::ExternalStringResource* resource) {
   LWNODE_CHECK_NOT_NULL(resource);
@@ -492,9 +505,13 @@ MaybeLocal<String> v8::String::NewExternalTwoByte(
 
   auto esString = StringRef::createExternalFromUTF16(
       reinterpret_cast<const char16_t*>(resource->data()), resource->length());
+  ExternalStringRegistry::instance()->add(
+      IsolateWrap::fromV8(isolate),
+      esString,
+      resource,
+      resource->length() * sizeof(uint16_t));
 
-  return Utils::NewLocal<String>(
-      isolate, ExternalStringWrap::create(esString, resource));
+  return newExternalStringLocal(isolate, esString);
 }
 
 MaybeLocal<String> v8::String::NewExternalOneByte(
@@ -513,24 +530,29 @@ MaybeLocal<String> v8::String::NewExternalOneByte(
 
   LWNODE_CHECK_NOT_NULL(resource->data());
 
-  auto externalString = StringRef::createExternalFromLatin1(
+  auto esString = StringRef::createExternalFromLatin1(
       (const unsigned char*)(resource->data()), resource->length());
+  ExternalStringRegistry::instance()->add(
+      IsolateWrap::fromV8(isolate), esString, resource, resource->length());
 
-  return Utils::NewLocal<String>(
-      isolate, ExternalStringWrap::create(externalString, resource));
+  return newExternalStringLocal(isolate, esString);
 }
 
+// Escargot strings are immutable and can't be moved onto a resource. A copy
+// made on the resource would be seen only through the caller's handle while
+// JS keeps the heap string, so no string is externalized. The caller keeps
+// the resource as with V8 when this fails.
 bool v8::String::MakeExternal(v8::String::ExternalStringResource* resource) {
-  LWNODE_RETURN_FALSE;
+  return false;
 }
 
 bool v8::String::MakeExternal(
     v8::String::ExternalOneByteStringResource* resource) {
-  LWNODE_RETURN_FALSE;
+  return false;
 }
 
 bool v8::String::CanMakeExternal() {
-  LWNODE_RETURN_FALSE;
+  return false;
 }
 
 bool v8::String::StringEquals(Local<String> that) {
@@ -565,7 +587,7 @@ Local<v8::Value> v8::NumberObject::New(Isolate* isolate, double value) {
   API_ENTER_NO_EXCEPTION(isolate);
   auto esContext = lwIsolate->GetCurrentContext()->get();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState, double value) -> ValueRef* {
         auto object = NumberObjectRef::create(esState);
@@ -596,7 +618,7 @@ Local<v8::Value> v8::BooleanObject::New(Isolate* isolate, bool value) {
   API_ENTER_NO_EXCEPTION(isolate);
   auto esContext = lwIsolate->GetCurrentContext()->get();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState, bool value) -> ValueRef* {
         auto object = BooleanObjectRef::create(esState);
@@ -621,7 +643,7 @@ Local<v8::Value> v8::StringObject::New(Isolate* v8_isolate,
   auto esContext = lwIsolate->GetCurrentContext()->get();
   auto esValue = CVAL(*value)->value()->asString();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState, StringRef* esValue) -> ValueRef* {
         auto object = StringObjectRef::create(esState);
@@ -647,7 +669,7 @@ Local<v8::Value> v8::SymbolObject::New(Isolate* isolate, Local<Symbol> value) {
   auto esContext = lwIsolate->GetCurrentContext()->get();
   auto esValue = CVAL(*value)->value()->asSymbol();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState, SymbolRef* esValue) -> ValueRef* {
         auto object = SymbolObjectRef::create(esState);
@@ -672,7 +694,7 @@ Local<v8::Symbol> v8::SymbolObject::ValueOf() const {
 MaybeLocal<v8::Value> v8::Date::New(Local<Context> context, double time) {
   EsScope scope(context);
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       scope.context(),
       [](ExecutionStateRef* state, double time) -> ValueRef* {
         auto date = DateObjectRef::create(state);
@@ -699,7 +721,7 @@ MaybeLocal<v8::RegExp> v8::RegExp::New(Local<Context> context,
   auto lwPattern = CVAL(*pattern)->value();
   int flagsValue = (int)flags;
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* esState, ValueRef* source, int flags) -> ValueRef* {
         return RegExpObjectRef::create(
@@ -725,7 +747,7 @@ Local<v8::String> v8::RegExp::GetSource() const {
   auto lwContext = lwIsolate->GetCurrentContext();
   auto self = CVAL(this)->value();
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* esState, RegExpObjectRef* self) -> ValueRef* {
         return self->source();
@@ -742,7 +764,7 @@ v8::RegExp::Flags v8::RegExp::GetFlags() const {
   auto self = CVAL(this)->value();
 
   int flags = RegExp::Flags::kNone;
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* esState,
          RegExpObjectRef* self,
@@ -764,7 +786,7 @@ MaybeLocal<v8::Object> v8::RegExp::Exec(Local<Context> context,
   auto self = CVAL(this)->value();
   auto esSubject = CVAL(*subject)->value()->asString();
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* state,
          RegExpObjectRef* self,
@@ -826,7 +848,7 @@ uint32_t v8::Array::Length() const {
 Local<v8::Map> v8::Map::New(Isolate* isolate) {
   EsScope scope(isolate);
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       scope.context(), [](ExecutionStateRef* esState) -> ValueRef* {
         return MapObjectRef::create(esState);
       });
@@ -838,7 +860,7 @@ Local<v8::Map> v8::Map::New(Isolate* isolate) {
 size_t v8::Map::Size() const {
   API_ENTER_NO_TERMINATION_CHECK(EsScope, nullptr);
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       scope.context(),
       [](ExecutionStateRef* esState, MapObjectRef* esSelf) -> ValueRef* {
         return ValueRef::create(esSelf->size(esState));
@@ -852,7 +874,7 @@ size_t v8::Map::Size() const {
 void Map::Clear() {
   API_ENTER_NO_TERMINATION_CHECK(EsScope, nullptr);
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       scope.context(),
       [](ExecutionStateRef* esState, MapObjectRef* esSelf) -> ValueRef* {
         esSelf->clear(esState);
@@ -865,7 +887,7 @@ void Map::Clear() {
 MaybeLocal<Value> Map::Get(Local<Context> context, Local<Value> key) {
   API_ENTER_AND_EXIT_IF_TERMINATING(EsScope, context, MaybeLocal<Value>());
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       scope.context(),
       [](ExecutionStateRef* esState,
          MapObjectRef* esSelf,
@@ -882,7 +904,7 @@ MaybeLocal<Map> Map::Set(Local<Context> context,
                          Local<Value> value) {
   API_ENTER_AND_EXIT_IF_TERMINATING(EsScope, context, MaybeLocal<Map>());
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       scope.context(),
       [](ExecutionStateRef* esState,
          MapObjectRef* esSelf,
@@ -902,7 +924,7 @@ MaybeLocal<Map> Map::Set(Local<Context> context,
 Maybe<bool> Map::Has(Local<Context> context, Local<Value> key) {
   API_ENTER_AND_EXIT_IF_TERMINATING(EsScope, context, Nothing<bool>());
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       scope.context(),
       [](ExecutionStateRef* esState,
          MapObjectRef* esSelf,
@@ -919,7 +941,7 @@ Maybe<bool> Map::Has(Local<Context> context, Local<Value> key) {
 Maybe<bool> Map::Delete(Local<Context> context, Local<Value> key) {
   API_ENTER_AND_EXIT_IF_TERMINATING(EsScope, context, Nothing<bool>());
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       scope.context(),
       [](ExecutionStateRef* esState,
          MapObjectRef* esSelf,
@@ -936,7 +958,7 @@ Maybe<bool> Map::Delete(Local<Context> context, Local<Value> key) {
 Local<Array> Map::AsArray() const {
   API_ENTER_NO_TERMINATION_CHECK(EsScope, nullptr);
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       scope.context(),
       [](ExecutionStateRef* esState, MapObjectRef* esSelf) -> ValueRef* {
         auto done = StringRef::createFromASCII("done");
@@ -970,7 +992,7 @@ Local<v8::Set> v8::Set::New(Isolate* isolate) {
   API_ENTER_NO_EXCEPTION(isolate);
   auto esContext = lwIsolate->GetCurrentContext()->get();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext, [](ExecutionStateRef* esState) -> ValueRef* {
         return SetObjectRef::create(esState);
       });
@@ -984,7 +1006,7 @@ size_t v8::Set::Size() const {
   auto esContext = lwIsolate->GetCurrentContext()->get();
   auto esSelf = CVAL(this)->value()->asSetObject();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState, SetObjectRef* esSelf) -> ValueRef* {
         return ValueRef::create(esSelf->size(esState));
@@ -1000,7 +1022,7 @@ void Set::Clear() {
   auto esContext = lwIsolate->GetCurrentContext()->get();
   auto esSelf = CVAL(this)->value()->asSetObject();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState, SetObjectRef* esSelf) -> ValueRef* {
         esSelf->clear(esState);
@@ -1016,7 +1038,7 @@ MaybeLocal<Set> Set::Add(Local<Context> context, Local<Value> key) {
   auto esSelf = CVAL(this)->value()->asSetObject();
   auto esKey = CVAL(*key)->value();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState,
          SetObjectRef* esSelf,
@@ -1037,7 +1059,7 @@ Maybe<bool> Set::Has(Local<Context> context, Local<Value> key) {
   auto esSelf = CVAL(this)->value()->asSetObject();
   auto esKey = CVAL(*key)->value();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState,
          SetObjectRef* esSelf,
@@ -1057,7 +1079,7 @@ Maybe<bool> Set::Delete(Local<Context> context, Local<Value> key) {
   auto esSelf = CVAL(this)->value()->asSetObject();
   auto esKey = CVAL(*key)->value();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState,
          SetObjectRef* esSelf,
@@ -1076,7 +1098,7 @@ Local<Array> Set::AsArray() const {
   auto esContext = lwIsolate->GetCurrentContext()->get();
   auto esSelf = CVAL(this)->value()->asSetObject();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState, SetObjectRef* esSelf) -> ValueRef* {
         auto done = StringRef::createFromASCII("done");
@@ -1102,7 +1124,7 @@ MaybeLocal<Promise::Resolver> Promise::Resolver::New(Local<Context> context) {
   API_ENTER_WITH_CONTEXT(context, MaybeLocal<Promise::Resolver>());
   auto esContext = lwIsolate->GetCurrentContext()->get();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* state,
          EscargotShim::IsolateWrap* lwIsolate) -> ValueRef* {
@@ -1133,7 +1155,7 @@ Maybe<bool> Promise::Resolver::Resolve(Local<Context> context,
     esValueTofulfill = esValueTofulfill->asPromiseObject()->promiseResult();
   }
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       scope.context(),
       [](ExecutionStateRef* state,
          PromiseObjectRef* promise,
@@ -1163,7 +1185,7 @@ Maybe<bool> Promise::Resolver::Reject(Local<Context> context,
     esValueToReject = esValueToReject->asPromiseObject()->promiseResult();
   }
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       scope.context(),
       [](ExecutionStateRef* state,
          PromiseObjectRef* promise,
@@ -1185,7 +1207,7 @@ MaybeLocal<Promise> Promise::Catch(Local<Context> context,
   API_ENTER_WITH_CONTEXT(context, MaybeLocal<Promise>());
   auto esContext = lwIsolate->GetCurrentContext()->get();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* state,
          PromiseObjectRef* promise,
@@ -1204,7 +1226,7 @@ MaybeLocal<Promise> Promise::Then(Local<Context> context,
   API_ENTER_WITH_CONTEXT(context, MaybeLocal<Promise>());
   auto esContext = lwIsolate->GetCurrentContext()->get();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* state,
          PromiseObjectRef* promise,
@@ -1224,7 +1246,7 @@ MaybeLocal<Promise> Promise::Then(Local<Context> context,
   API_ENTER_WITH_CONTEXT(context, MaybeLocal<Promise>());
   auto esContext = lwIsolate->GetCurrentContext()->get();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* state,
          PromiseObjectRef* promise,
@@ -1311,7 +1333,7 @@ MaybeLocal<Proxy> Proxy::New(Local<Context> context,
   API_ENTER_WITH_CONTEXT(context, MaybeLocal<Proxy>());
   auto lwContext = lwIsolate->GetCurrentContext();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* state,
          ValueRef* target,
@@ -1435,7 +1457,7 @@ Local<ArrayBuffer> v8::ArrayBuffer::New(Isolate* isolate, size_t byte_length) {
   API_ENTER_NO_EXCEPTION(isolate);
   auto lwContext = lwIsolate->GetCurrentContext();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* esState, size_t byteLength) -> ValueRef* {
         auto arrayBuffer = ArrayBufferObjectRef::create(esState);
@@ -1461,7 +1483,7 @@ Local<ArrayBuffer> v8::ArrayBuffer::New(
   auto lwContext = lwIsolate->GetCurrentContext();
   auto esBackingStore = reinterpret_cast<BackingStoreRef*>(backing_store.get());
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* esState,
          BackingStoreRef* backingStore) -> ValueRef* {
@@ -1595,7 +1617,22 @@ size_t v8::TypedArray::Length() {
       Local<SharedArrayBuffer> shared_array_buffer,                            \
       size_t byte_offset,                                                      \
       size_t length) {                                                         \
-    LWNODE_RETURN_LOCAL(Type##Array);                                          \
+    auto lwIsolate = IsolateWrap::GetCurrent();                                \
+    auto esContext = lwIsolate->GetCurrentContext()->get();                    \
+    auto esSharedArrayBuffer =                                                 \
+        VAL(*shared_array_buffer)->value()->asSharedArrayBufferObject();       \
+                                                                               \
+    auto esArrayBufferView =                                                   \
+        ArrayBufferHelper::createView<Type##ArrayObjectRef>(                   \
+            esContext,                                                         \
+            esSharedArrayBuffer,                                               \
+            byte_offset,                                                       \
+            length,                                                            \
+            ArrayBufferHelper::ArrayType::kExternal##Type##Array);             \
+                                                                               \
+    LWNODE_CHECK(esArrayBufferView->is##Type##ArrayObject());                  \
+                                                                               \
+    return Utils::NewLocal<Type##Array>(lwIsolate->toV8(), esArrayBufferView); \
   }
 
 TYPED_ARRAYS(TYPED_ARRAY_NEW)
@@ -1663,7 +1700,7 @@ Local<SharedArrayBuffer> v8::SharedArrayBuffer::New(Isolate* isolate,
   API_ENTER_NO_EXCEPTION(isolate);
   auto lwContext = lwIsolate->GetCurrentContext();
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* state, size_t byteLength) -> ValueRef* {
         return SharedArrayBufferObjectRef::create(state, byteLength);
@@ -1689,7 +1726,7 @@ Local<SharedArrayBuffer> v8::SharedArrayBuffer::New(
   auto lwContext = lwIsolate->GetCurrentContext();
 
   auto esBackingStore = reinterpret_cast<BackingStoreRef*>(backing_store.get());
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* state, BackingStoreRef* bs) -> ValueRef* {
         return SharedArrayBufferObjectRef::create(state, bs);
@@ -1726,27 +1763,13 @@ std::unique_ptr<v8::BackingStore> v8::SharedArrayBuffer::NewBackingStore(
     void* deleter_data) {
   auto lwIsolate = IsolateWrap::GetCurrent();
 
-  struct Params {
-    BackingStore::DeleterCallback deleter{nullptr};
-    void* deleterData{nullptr};
-  };
-
-  Params* callbackData = new Params();
-  callbackData->deleter = deleter;
-  callbackData->deleterData = deleter_data;
-
-  auto callback = [](void* data, size_t length, void* callbackData) {
-    Params* params = reinterpret_cast<Params*>(callbackData);
-    if (data) {
-      params->deleter(data, length, params->deleterData);
-    }
-    delete params;
-  };
+  // Escargot can't wrap external memory in a shared backing store. A copy
+  // would no longer be shared with the embedder, so refuse it loudly.
+  LWNODE_CHECK_MSG(data == nullptr,
+                   "external memory can't back a SharedArrayBuffer");
 
-  // TODO: change to shared type.
-  LWNODE_UNIMPLEMENT;
-  auto esBackingStore = BackingStoreRef::createNonSharedBackingStore(
-      data, byte_length, callback, callbackData);
+  BackingStoreRef* esBackingStore =
+      BackingStoreRef::createDefaultSharedBackingStore(byte_length);
   lwIsolate->addBackingStore(esBackingStore);
 
   return std::unique_ptr<v8::BackingStore>(
@@ -1772,7 +1795,7 @@ Local<Symbol> v8::Symbol::For(Isolate* isolate, Local<String> name) {
   auto lwContext = lwIsolate->GetCurrentContext();
   auto esName = VAL(*name)->value()->asString();
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* esState,
          VMInstanceRef* esVmInstance,
@@ -1813,7 +1836,7 @@ Local<Symbol> v8::Symbol::ForApi(Isolate* isolate, Local<String> name) {
     IsolateWrap* lwIsolate = IsolateWrap::fromV8(isolate);                     \
     auto lwContext = lwIsolate->GetCurrentContext();                           \
                                                                                \
-    auto r = Evaluator::execute(                                               \
+    auto r = EvalHelper::execute(                                              \
         lwContext->get(),                                                      \
         [](ExecutionStateRef* state, VMInstanceRef* vmInstance) -> ValueRef* { \
           return vmInstance->esName##Symbol();                                 \
@@ -1903,8 +1926,15 @@ void BigInt::ToWordsArray(int* sign_bit,
   LWNODE_RETURN_VOID;
 }
 
+// The native memory held by JS objects is invisible to the collector, so
+// the main loop is asked to collect garbage, which may finalize the objects.
+// The limit is raised at once to nudge only once per soft limit until the
+// next collection resets it.
 void Isolate::ReportExternalAllocationLimitReached() {
-  LWNODE_RETURN_VOID;
+  auto lwIsolate = IsolateWrap::fromV8(this);
+  lwIsolate->ResetExternalMemoryLimit();
+  LWNode::MessageLoop::GetInstance()->notifyMemoryPressure(
+      MemoryPressureLevel::kModerate);
 }
 
 // Node v14.x ABI compat dummy.
@@ -1960,42 +1990,55 @@ v8::Local<Value> Isolate::ThrowException(v8::Local<v8::Value> value) {
   return Utils::NewLocal<Value>(lwIsolate->toV8(), esValue);
 }
 
+// The GC callbacks run inside the collection, while the collector holds its
+// allocation lock (see GCEventTracker). They must not allocate on the GC
+// heap, e.g. create handles; such work should be queued and run afterwards.
 void Isolate::AddGCPrologueCallback(GCCallbackWithData callback,
                                     void* data,
                                     GCType gc_type) {
-  LWNODE_RETURN_VOID;
+  IsolateWrap::fromV8(this)->gcEventTracker()->addPrologueCallback(
+      callback, data, gc_type);
 }
 
 void Isolate::RemoveGCPrologueCallback(GCCallbackWithData callback,
                                        void* data) {
-  LWNODE_RETURN_VOID;
+  IsolateWrap::fromV8(this)->gcEventTracker()->removePrologueCallback(callback,
+                                                                      data);
 }
 
 void Isolate::AddGCEpilogueCallback(GCCallbackWithData callback,
                                     void* data,
                                     GCType gc_type) {
-  LWNODE_RETURN_VOID;
+  IsolateWrap::fromV8(this)->gcEventTracker()->addEpilogueCallback(
+      callback, data, gc_type);
 }
 
 void Isolate::RemoveGCEpilogueCallback(GCCallbackWithData callback,
                                        void* data) {
-  LWNODE_RETURN_VOID;
+  IsolateWrap::fromV8(this)->gcEventTracker()->removeEpilogueCallback(callback,
+                                                                      data);
 }
 
 void Isolate::AddGCPrologueCallback(GCCallback callback, GCType gc_type) {
-  LWNODE_RETURN_VOID;
+  void* data = reinterpret_cast<void*>(callback);
+  AddGCPrologueCallback(
+      GCEventTracker::invokeCallbackWithoutData, data, gc_type);
 }
 
 void Isolate::RemoveGCPrologueCallback(GCCallback callback) {
-  LWNODE_RETURN_VOID;
+  void* data = reinterpret_cast<void*>(callback);
+  RemoveGCPrologueCallback(GCEventTracker::invokeCallbackWithoutData, data);
 }
 
 void Isolate::AddGCEpilogueCallback(GCCallback callback, GCType gc_type) {
-  LWNODE_RETURN_VOID;
+  void* data = reinterpret_cast<void*>(callback);
+  AddGCEpilogueCallback(
+      GCEventTracker::invokeCallbackWithoutData, data, gc_type);
 }
 
 void Isolate::RemoveGCEpilogueCallback(GCCallback callback) {
-  LWNODE_RETURN_VOID;
+  void* data = reinterpret_cast<void*>(callback);
+  RemoveGCEpilogueCallback(GCEventTracker::invokeCallbackWithoutData, data);
 }
 
 void Isolate::SetEmbedderHeapTracer(EmbedderHeapTracer* tracer) {
@@ -2149,17 +2192,113 @@ i::Address* Isolate::GetDataFromSnapshotOnce(size_t index) {
   LWNODE_RETURN_NULLPTR;
 }
 
+// The heap statistics are made from the counters of the collector, and from
+// the memory held by ArrayBuffers and external strings, which lives outside
+// of the GC heap. Each of them is reported as a pseudo heap space.
+enum PseudoHeapSpace {
+  kGCHeapSpace = 0,
+  kArrayBufferSpace,
+  kExternalStringSpace,
+  kNumberOfPseudoHeapSpaces,
+};
+
+static const char* const kPseudoHeapSpaceNames[] = {
+    "gc_heap_space",
+    "array_buffer_space",
+    "external_string_space",
+};
+
+static size_t arrayBufferBytes(IsolateWrap* lwIsolate) {
+  auto decorator = lwIsolate->arrayBufferDecorator_;
+  return decorator ? decorator->currentMemorySize() : 0;
+}
+
+static size_t heapSizeLimit() {
+  // the collector can grow the heap up to the physical memory
+  static const size_t s_limit = []() -> size_t {
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || pageSize <= 0) {
+      return std::numeric_limits<uint32_t>::max();
+    }
+    return static_cast<size_t>(pages) * static_cast<size_t>(pageSize);
+  }();
+  return s_limit;
+}
+
 void Isolate::GetHeapStatistics(HeapStatistics* heap_statistics) {
-  LWNODE_RETURN_VOID;
+  auto lwIsolate = IsolateWrap::fromV8(this);
+  auto usage = MemoryUtil::gcHeapUsage();
+  size_t used = usage.heapSize - usage.freeBytes;
+  size_t limit = std::max(heapSizeLimit(), usage.heapSize);
+
+  heap_statistics->total_heap_size_ = usage.heapSize;
+  heap_statistics->total_heap_size_executable_ = 0;
+  heap_statistics->total_physical_size_ = usage.heapSize;
+  heap_statistics->total_available_size_ = limit - used;
+  heap_statistics->used_heap_size_ = used;
+  heap_statistics->heap_size_limit_ = limit;
+  heap_statistics->malloced_memory_ = 0;
+  heap_statistics->external_memory_ =
+      arrayBufferBytes(lwIsolate) +
+      ExternalStringRegistry::instance()->bytes(lwIsolate) +
+      std::max<int64_t>(lwIsolate->external_memory(), 0);
+  heap_statistics->peak_malloced_memory_ = 0;
+  heap_statistics->total_global_handles_size_ =
+      lwIsolate->global_handles()->totalSize();
+  heap_statistics->used_global_handles_size_ =
+      lwIsolate->global_handles()->usedSize();
+  heap_statistics->does_zap_garbage_ = false;
+  heap_statistics->number_of_native_contexts_ = 0;
+  heap_statistics->number_of_detached_contexts_ = 0;
 }
 
 size_t Isolate::NumberOfHeapSpaces() {
-  LWNODE_RETURN_0;
+  return kNumberOfPseudoHeapSpaces;
 }
 
 bool Isolate::GetHeapSpaceStatistics(HeapSpaceStatistics* space_statistics,
                                      size_t index) {
-  LWNODE_RETURN_FALSE;
+  if (!space_statistics || index >= kNumberOfPseudoHeapSpaces) {
+    return false;
+  }
+
+  auto lwIsolate = IsolateWrap::fromV8(this);
+  space_statistics->space_name_ = kPseudoHeapSpaceNames[index];
+
+  switch (index) {
+    case kGCHeapSpace: {
+      auto usage = MemoryUtil::gcHeapUsage();
+      space_statistics->space_size_ = usage.heapSize;
+      space_statistics->space_used_size_ = usage.heapSize - usage.freeBytes;
+      space_statistics->space_available_size_ = usage.freeBytes;
+      space_statistics->physical_space_size_ = usage.heapSize;
+      break;
+    }
+    case kArrayBufferSpace: {
+      // pooled buffers are carved out of slabs, which are committed as a whole
+      size_t used = arrayBufferBytes(lwIsolate);
+      size_t available = 0;
+      if (auto pool = ArrayBufferPool::instance()) {
+        auto statistics = pool->statistics();
+        available = statistics.slabBytes - statistics.inUseBytes;
+      }
+      space_statistics->space_size_ = used + available;
+      space_statistics->space_used_size_ = used;
+      space_statistics->space_available_size_ = available;
+      space_statistics->physical_space_size_ = used + available;
+      break;
+    }
+    case kExternalStringSpace: {
+      size_t bytes = ExternalStringRegistry::instance()->bytes(lwIsolate);
+      space_statistics->space_size_ = bytes;
+      space_statistics->space_used_size_ = bytes;
+      space_statistics->space_available_size_ = 0;
+      space_statistics->physical_space_size_ = bytes;
+      break;
+    }
+  }
+  return true;
 }
 
 size_t Isolate::NumberOfTrackedHeapObjectTypes() {
@@ -2305,11 +2444,17 @@ void Isolate::SetAddCrashKeyCallback(AddCrashKeyCallback callback) {
 }
 
 bool Isolate::IdleNotificationDeadline(double deadline_in_seconds) {
-  LWNODE_RETURN_FALSE;
+  auto platform = i::V8::GetCurrentPlatform();
+  if (platform &&
+      platform->MonotonicallyIncreasingTime() >= deadline_in_seconds) {
+    return false;
+  }
+  LWNode::IdleGC(this);
+  return true;
 }
 
 void Isolate::LowMemoryNotification() {
-  LWNODE_RETURN_VOID;
+  LWNode::IdleGC(this);
 }
 
 int Isolate::ContextDisposedNotification(bool dependant_context) {
@@ -2325,7 +2470,7 @@ void Isolate::IsolateInBackgroundNotification() {
 }
 
 void Isolate::MemoryPressureNotification(MemoryPressureLevel level) {
-  LWNODE_RETURN_VOID;
+  LWNode::MessageLoop::GetInstance()->notifyMemoryPressure(level);
 }
 
 void Isolate::EnableMemorySavingsMode() {
@@ -2526,7 +2671,7 @@ void MicrotasksScope::PerformCheckpoint(Isolate* v8_isolate) {
   auto lwIsolate = IsolateWrap::fromV8(v8_isolate);
   auto vmInstance = lwIsolate->vmInstance();
 
-  GCHeap::ProcessingHoldScope scope;
+  GlobalHandles::ProcessingHoldScope scope;
 
   while (vmInstance->hasPendingJob()) {
     auto r = vmInstance->executePendingJob();
@@ -2553,7 +2698,7 @@ String::Utf8Value::Utf8Value(v8::Isolate* isolate, v8::Local<v8::Value> obj)
 
   TryCatch try_catch(isolate);
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* state, ValueRef* value) -> ValueRef* {
         return value->toString(state);
@@ -2643,7 +2788,7 @@ Local<Message> Exception::CreateMessage(Isolate* isolate,
     messageString = esException->asString();
   }
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState, StringRef* messageString) -> ValueRef* {
         auto object = StringObjectRef::create(esState);
@@ -78,15 +78,10 @@ i::Address* HandleScope::CreateHandle(i::Isolate* isolate, i::Address value) {
 
   switch (handle->location()) {
     case HandleWrap::Location::Local:
-      lwIsolate->addHandleToCurrentScope(handle);
-      return reinterpret_cast<i::Address*>(handle);
-
     case HandleWrap::Location::Strong:
-    case HandleWrap::Location::Weak: {
-      auto cloned = handle->clone(HandleWrap::Location::Local);
-      lwIsolate->addHandleToCurrentScope(cloned);
-      return reinterpret_cast<i::Address*>(cloned);
-    }
+    case HandleWrap::Location::Weak:
+      return reinterpret_cast<i::Address*>(
+          lwIsolate->addHandleToCurrentScope(handle));
 
     default:
       break;
@@ -103,17 +98,22 @@ EscapableHandleScope::EscapableHandleScope(Isolate* v8_isolate) {
 
   Initialize(v8_isolate);
 
-  IsolateWrap::fromV8(v8_isolate)
-      ->pushHandleScope(
-          new HandleScopeWrap(this, HandleScopeWrap::Type::Escapable));
+  auto lwIsolate = IsolateWrap::fromV8(v8_isolate);
+  // the slot belongs to the outer scope, so it should be reserved before this
+  // scope is pushed
+  escape_slot_ =
+      reinterpret_cast<i::Address*>(lwIsolate->reserveEscapeSlot());
+  lwIsolate->pushHandleScope(
+      new HandleScopeWrap(this, HandleScopeWrap::Type::Escapable));
 }
 
 i::Address* EscapableHandleScope::Escape(i::Address* escape_value) {
   LWNODE_CALL_TRACE("%p", escape_value);
 
-  IsolateWrap::fromV8(GetIsolate())->escapeHandle(VAL(escape_value));
-
-  return escape_value;
+  return reinterpret_cast<i::Address*>(
+      IsolateWrap::fromV8(GetIsolate())
+          ->escapeHandle(reinterpret_cast<HandleWrap*>(escape_value),
+                         reinterpret_cast<HandleWrap*>(escape_slot_)));
 }
 
 void* EscapableHandleScope::operator new(size_t) {
@@ -185,7 +185,8 @@ v8::Local<v8::Value> Context::SlowGetEmbedderData(int index) {
 }
 
 void Context::SetEmbedderData(int index, v8::Local<Value> value) {
-  VAL(this)->context()->SetEmbedderData(index, VAL(*value));
+  VAL(this)->context()->SetEmbedderData(index,
+                                        ValueWrap::detach(VAL(*value)));
 }
 
 void* Context::SlowGetAlignedPointerFromEmbedderData(int index) {
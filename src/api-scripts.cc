@@ -48,7 +48,11 @@ ScriptCompiler::CachedData::CachedData(const uint8_t* data_,
       rejected(false),
       buffer_policy(buffer_policy_) {}
 
-ScriptCompiler::CachedData::~CachedData() {}
+ScriptCompiler::CachedData::~CachedData() {
+  if (buffer_policy == BufferOwned) {
+    delete[] data;
+  }
+}
 
 bool ScriptCompiler::ExternalSourceStream::SetBookmark() {
   LWNODE_RETURN_FALSE;
@@ -123,7 +127,7 @@ MaybeLocal<Value> Script::Run(Local<Context> context) {
     return MaybeLocal<Value>();
   }
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       esScript->context(),
       [](ExecutionStateRef* state, ScriptRef* script) -> ValueRef* {
         return script->execute(state);
@@ -213,8 +217,7 @@ Local<UnboundModuleScript> Module::GetUnboundModuleScript() {
 }
 
 int Module::GetIdentityHash() const {
-  LWNODE_ONCE(LWNODE_UNIMPLEMENT);
-  return 0;
+  return IdentityHashHelper::fromAddress(CVAL(this)->module());
 }
 
 Maybe<bool> Module::InstantiateModule(Local<Context> context,
@@ -271,14 +274,6 @@ MaybeLocal<UnboundScript> ScriptCompiler::CompileUnboundInternal(
     NoCacheReason no_cache_reason) {
   API_ENTER(v8_isolate, MaybeLocal<UnboundScript>());
 
-  if (options == kConsumeCodeCache) {
-    LWNODE_UNIMPLEMENT;
-    // @todo @feature
-    // CodeCache feature seemingly requires finding a cache, which is the same
-    // script compiled, based on the given source string. Escargot doesn't
-    // provide such a feature. Do we need to handle it here?
-  }
-
   // @todo @escargot
   // Escargot::NativeCodeBlock associates a Context to get access to
   // AtomicStrings. Why not a VmInstance instead of a Context? Context isn't
@@ -287,6 +282,11 @@ MaybeLocal<UnboundScript> ScriptCompiler::CompileUnboundInternal(
   auto esSource = VAL(*source->source_string)->value()->asString();
   auto esResourceName = StringRef::emptyString();
 
+  if (options == kConsumeCodeCache) {
+    source->cached_data->rejected =
+        !CodeCache::accepts(source->cached_data, esSource);
+  }
+
   if (!source->resource_name.IsEmpty()) {
     esResourceName = VAL(*source->resource_name)->value()->asString();
   }
@@ -371,27 +371,18 @@ MaybeLocal<Function> ScriptCompiler::CompileFunctionInContext(
 
   Isolate* isolate = v8_context->GetIsolate();
 
-  if (options == CompileOptions::kConsumeCodeCache) {
-    CachedData* cached_data = source->cached_data;
-    LWNODE_DCHECK(cached_data->length == 0);
-
-    // @note node_contextify.cc:783 is related.
-    cached_data->rejected = true;
-
-    LWNODE_DLOG_INFO("ignored: CachedData (%s)",
-                     VAL(*source->resource_name)
-                         ->value()
-                         ->asString()
-                         ->toStdUTF8String()
-                         .c_str());
-  }
-
   if (context_extension_count > 0) {
     LWNODE_UNIMPLEMENT;
   }
 
   auto esContext = VAL(*v8_context)->context()->get();
   auto esSource = VAL(*source->source_string)->value()->asString();
+
+  if (options == CompileOptions::kConsumeCodeCache) {
+    // @note node_contextify.cc:783 is related.
+    source->cached_data->rejected =
+        !CodeCache::accepts(source->cached_data, esSource);
+  }
   StringRef* esSourceName = nullptr;
   if (*source->resource_name) {
     esSourceName = VAL(*source->resource_name)->value()->asString();
@@ -456,7 +447,7 @@ MaybeLocal<Script> ScriptCompiler::Compile(Local<Context> context,
 }
 
 uint32_t ScriptCompiler::CachedDataVersionTag() {
-  LWNODE_RETURN_0;
+  return CodeCache::versionTag();
 }
 
 #ifndef NDEBUG
@@ -467,11 +458,13 @@ static size_t s_track_data_size;
 
 ScriptCompiler::CachedData* ScriptCompiler::CreateCodeCache(
     Local<UnboundScript> unbound_script) {
+  auto cachedData =
+      CodeCache::create(VAL(*unbound_script)->script()->sourceCode());
 #ifndef NDEBUG
-  s_track_data_size += sizeof(CachedData);
+  s_track_data_size += sizeof(CachedData) + cachedData->length;
   LWNODE_CALL_TRACE(TRACK_MSG_FMT, s_track_data_size);
 #endif
-  return new CachedData();
+  return cachedData;
 }
 
 // static
@@ -109,22 +109,35 @@ void FunctionTemplate::Inherit(v8::Local<FunctionTemplate> value) {
       ExtraDataHelper::getFunctionTemplateExtraData(esThatFunctionTemplate));
 }
 
+// Replaces the FunctionTemplateData that a function instantiated from
+// |functionTemplate| shares with its template by the function's own
+// FunctionData, so that its dispatch data is resolved only once.
+static FunctionData* createFunctionData(FunctionObjectRef* esFunction,
+                                        FunctionTemplateRef* functionTemplate) {
+  auto functionData = new FunctionData(functionTemplate);
+  LWNODE_CALL_TRACE_ID_LOG(EXTRADATA,
+                           "FunctionTemplate(%p): %p: New functionData: %p",
+                           functionTemplate,
+                           esFunction,
+                           functionData);
+  ExtraDataHelper::setExtraData(esFunction, functionData, true);
+  return functionData;
+}
+
 static FunctionData* getFunctionDataFromCallee(FunctionObjectRef* callee) {
   auto calleeExtraData = ExtraDataHelper::getExtraData(callee);
   LWNODE_DCHECK_NOT_NULL(calleeExtraData);
 
-  FunctionData* functionData = nullptr;
   // callee->extraData() is one of two types below
-  if (calleeExtraData->isFunctionData()) {
-    functionData = calleeExtraData->asFunctionData();
-  } else if (calleeExtraData->isFunctionTemplateData()) {
-    functionData = new FunctionData(
-        calleeExtraData->asFunctionTemplateData()->functionTemplate());
-  } else {
-    LWNODE_CHECK(false);
+  if (LWNODE_LIKELY(calleeExtraData->isFunctionData())) {
+    return calleeExtraData->asFunctionData();
   }
 
-  return functionData;
+  // The callee was instantiated without FunctionTemplate::GetFunction(),
+  // e.g. as a property of an ObjectTemplate.
+  LWNODE_CHECK(calleeExtraData->isFunctionTemplateData());
+  return createFunctionData(
+      callee, calleeExtraData->asFunctionTemplateData()->functionTemplate());
 }
 
 static void setExtraDataToNewObjectInstance(ValueRef* thisValue,
@@ -186,9 +199,12 @@ static ValueRef* runNativeFunctionCallback(ExecutionStateRef* state,
     return nullptr;
   }
 
-  Local<Value> result;
   if (functionData->callback()) {
     LWNODE_CALL_TRACE_ID(TEMPLATE, "> Call JS callback");
+    // Like V8, run the callback in its own handle scope so that the handles
+    // it creates are released when it returns.
+    HandleScopeWrapGuard handleScope(lwIsolate);
+    ExecutionStateScope stateScope(lwIsolate, state);
     lwIsolate->increaseCallDepth();
     FunctionCallbackInfoWrap info(functionData->isolate(),
                                   thisValue,
@@ -201,11 +217,10 @@ static ValueRef* runNativeFunctionCallback(ExecutionStateRef* state,
     lwIsolate->decreaseCallDepth();
 
     lwIsolate->ThrowErrorIfHasException(state);
-    result = info.GetReturnValue().Get();
-  }
-
-  if (!result.IsEmpty()) {
-    return VAL(*result)->value();
+    Local<Value> result = info.GetReturnValue().Get();
+    if (!result.IsEmpty()) {
+      return VAL(*result)->value();
+    }
   }
 
   return ValueRef::createUndefined();
@@ -280,7 +295,11 @@ Local<FunctionTemplate> FunctionTemplate::New(Isolate* isolate,
   // FunctionTemplateNative callback will receive "functionTemplateData"
   // in s as in "var s = new A();"
   auto functionTemplateData = new FunctionTemplateData(
-      esFunctionTemplate, isolate, *callback, *data, *signature);
+      esFunctionTemplate,
+      isolate,
+      *callback,
+      reinterpret_cast<Value*>(ValueWrap::detach(VAL(*data))),
+      reinterpret_cast<Signature*>(ValueWrap::detach(VAL(*signature))));
 
   LWNODE_CALL_TRACE_ID_LOG(EXTRADATA,
                            "FunctionTemplate(%p)::New(): New ExtraData: %p",
@@ -326,7 +345,8 @@ void FunctionTemplate::SetCallHandler(FunctionCallback callback,
   auto functionTemplateData =
       ExtraDataHelper::getFunctionTemplateExtraData(scope.self());
   functionTemplateData->setCallback(callback);
-  functionTemplateData->setCallbackData(*data);
+  functionTemplateData->setCallbackData(
+      reinterpret_cast<Value*>(ValueWrap::detach(VAL(*data))));
 }
 
 Local<ObjectTemplate> FunctionTemplate::InstanceTemplate() {
@@ -370,7 +390,7 @@ void FunctionTemplate::SetClassName(Local<String> name) {
   EsScopeFunctionTemplate scope(this);
   auto esName = CVAL(*name)->value()->asString();
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       scope.context(),
       [](ExecutionStateRef* esState,
          FunctionTemplateRef* esFunctionTemplate,
@@ -421,15 +441,7 @@ MaybeLocal<v8::Function> FunctionTemplate::GetFunction(Local<Context> context) {
       // This functionData was created by FunctionTemplate::New(), and
       // FunctionTemplateData was set in esFunction. We need to replace it with
       // a new FunctionData
-      auto newFunctionData = new FunctionData(scope.self());
-      LWNODE_CALL_TRACE_ID_LOG(
-          EXTRADATA,
-          "FunctionTemplate(%p)::GetFunction(%p): New functionData: %p",
-          scope.self(),
-          esFunction,
-          newFunctionData);
-      ExtraDataHelper::setExtraData(
-          esFunction->asFunctionObject(), newFunctionData, true);
+      createFunctionData(esFunction->asFunctionObject(), scope.self());
     } else if (functionData->isFunctionData()) {
       // this functionData was created previously by the above line.
       // Use it as it is.
@@ -606,7 +618,7 @@ class NamePropertyPolicy {
  public:
   static Local<Name> getPropertyName(ExecutionStateRef* state,
                                      ValueRef* value) {
-    return Utils::ToLocal<Name>(value);
+    return Utils::NewLocal<Name>(IsolateWrap::GetCurrent()->toV8(), value);
   }
 };
 
@@ -624,7 +636,11 @@ struct ObjectTemplateLocalData : public gc {
  public:
   ObjectTemplateLocalData(v8::Isolate* isolate,
                           const T& propertyHandlerConfiguration)
-      : isolate(isolate), config(propertyHandlerConfiguration) {}
+      : isolate(isolate), config(propertyHandlerConfiguration) {
+    // the data handle is kept beyond the scope it was created in
+    config.data =
+        v8::Utils::ToLocal<v8::Value>(ValueWrap::detach(VAL(*config.data)));
+  }
 
   v8::Isolate* isolate{nullptr};
   T config;
@@ -655,6 +671,7 @@ class ObjectTemplateSetHandlerCallbackHelper {
                                               void* data,
                                               ValueRef* propertyName) {
     auto helperData = getHelperData(data);
+    ExecutionStateScope stateScope(helperData->isolate, state);
 
     PropertyCallbackInfoWrap<v8::Value> info(
         helperData->isolate, esSelf, esReceiver, VAL(*helperData->config.data));
@@ -677,6 +694,7 @@ class ObjectTemplateSetHandlerCallbackHelper {
                                               ValueRef* propertyName,
                                               ValueRef* esValue) {
     auto helperData = getHelperData(data);
+    ExecutionStateScope stateScope(helperData->isolate, state);
 
     PropertyCallbackInfoWrap<v8::Value> info(
         helperData->isolate, esSelf, esReceiver, VAL(*helperData->config.data));
@@ -684,7 +702,7 @@ class ObjectTemplateSetHandlerCallbackHelper {
     LWNODE_DCHECK_NOT_NULL(helperData->config.setter);
     helperData->config.setter(
         GetPropertyNamePolicy::getPropertyName(state, propertyName),
-        v8::Utils::ToLocal<Value>(esValue),
+        v8::Utils::NewLocal<Value>(helperData->isolate, esValue),
         info);
 
     if (info.hasReturnValue()) {
@@ -703,6 +721,7 @@ class ObjectTemplateSetHandlerCallbackHelper {
                                                        void* data,
                                                        ValueRef* propertyName) {
     auto helperData = getHelperData(data);
+    ExecutionStateScope stateScope(helperData->isolate, state);
 
     PropertyCallbackInfoWrap<v8::Integer> info(
         helperData->isolate, esSelf, esReceiver, VAL(*helperData->config.data));
@@ -736,6 +755,7 @@ class ObjectTemplateSetHandlerCallbackHelper {
                                                void* data,
                                                ValueRef* propertyName) {
     auto helperData = getHelperData(data);
+    ExecutionStateScope stateScope(helperData->isolate, state);
 
     PropertyCallbackInfoWrap<v8::Boolean> info(
         helperData->isolate, esSelf, esReceiver, VAL(*helperData->config.data));
@@ -756,6 +776,7 @@ class ObjectTemplateSetHandlerCallbackHelper {
                                             ValueRef* esReceiver,
                                             void* data) {
     auto helperData = getHelperData(data);
+    ExecutionStateScope stateScope(helperData->isolate, state);
 
     PropertyCallbackInfoWrap<v8::Array> info(
         helperData->isolate, esSelf, esReceiver, VAL(*helperData->config.data));
@@ -787,6 +808,7 @@ class ObjectTemplateSetHandlerCallbackHelper {
       ValueRef* propertyName,
       const ObjectPropertyDescriptorRef& esDescriptor) {
     auto helperData = getHelperData(data);
+    ExecutionStateScope stateScope(helperData->isolate, state);
 
     PropertyCallbackInfoWrap<v8::Value> info(
         helperData->isolate, esSelf, esReceiver, VAL(*helperData->config.data));
@@ -813,6 +835,7 @@ class ObjectTemplateSetHandlerCallbackHelper {
                                                   void* data,
                                                   ValueRef* propertyName) {
     auto helperData = getHelperData(data);
+    ExecutionStateScope stateScope(helperData->isolate, state);
 
     PropertyCallbackInfoWrap<v8::Value> info(
         helperData->isolate, esSelf, esReceiver, VAL(*helperData->config.data));
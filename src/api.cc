@@ -325,7 +325,7 @@ void RegisteredExtension::applyV8Extension(ContextRef* context,
 
   auto esFunctionTemplate = CVAL(*v8FunctionTemplate)->ftpl();
 
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       context,
       [](ExecutionStateRef* state,
          std::string* name,
@@ -545,7 +545,11 @@ ValueRef* ExternalizeGcExtension::gcCallback(ExecutionStateRef* state,
     isolate->CollectGarbage();  // should release weak values
   }
 
-  Escargot::Memory::gc();
+  {
+    GCEventTracker::ReasonScope scope(isolate ? isolate->toV8() : nullptr,
+                                      GCEventTracker::Reason::kForced);
+    Escargot::Memory::gc();
+  }
   malloc_trim(0);
 
   return ValueRef::createUndefined();
@@ -589,14 +593,9 @@ void ResourceConstraints::set_max_semi_space_size_in_kb(size_t limit_in_kb) {
 i::Address* V8::GlobalizeReference(i::Isolate* isolate, i::Address* obj) {
   LWNODE_CALL_TRACE();
   LWNODE_CHECK(isolate);
-#if defined(GC_HEAP_TRACE_ONLY)
-  auto persistent = PersistentWrap::GlobalizeReference(
-      reinterpret_cast<Isolate*>(isolate), obj);
-  return reinterpret_cast<i::Address*>(persistent);
-#endif
-
-  IsolateWrap::fromV8(isolate)->global_handles()->create(VAL(obj));
-  return obj;
+  auto location =
+      IsolateWrap::fromV8(isolate)->global_handles()->create(VAL(obj));
+  return reinterpret_cast<i::Address*>(location);
 }
 
 i::Address* V8::GlobalizeTracedReference(i::Isolate* isolate,
@@ -629,40 +628,29 @@ void V8::MakeWeak(i::Address* location,
                   WeakCallbackInfo<void>::Callback weak_callback,
                   WeakCallbackType type) {
   LWNODE_CALL_TRACE();
-
-#if defined(GC_HEAP_TRACE_ONLY)
-  PersistentWrap::MakeWeak(location, parameter, weak_callback);
-  return;
-#endif
-
-#if defined(LWNODE_ENABLE_EXPERIMENTAL)
+  if (!GlobalHandles::IsWeakHandleEnabled()) {
+    return;
+  }
   if (type != WeakCallbackType::kParameter) {
     LWNODE_RETURN_VOID;  // TODO
   }
   GlobalHandles::MakeWeak(VAL(location), parameter, weak_callback);
-#endif
 }
 
 void V8::MakeWeak(i::Address** location_addr) {
-#if defined(LWNODE_ENABLE_EXPERIMENTAL)
-  GlobalHandles::MakeWeak(
-      VAL(*location_addr), reinterpret_cast<void*>(location_addr), nullptr);
-#endif
-  LWNODE_RETURN_VOID;
+  if (!GlobalHandles::IsWeakHandleEnabled()) {
+    LWNODE_RETURN_VOID;
+  }
+  GlobalHandles::MakeWeak(reinterpret_cast<HandleWrap**>(location_addr));
 }
 
 void* V8::ClearWeak(i::Address* location) {
   LWNODE_CALL_TRACE();
-#if defined(GC_HEAP_TRACE_ONLY)
-  return PersistentWrap::ClearWeak(location);
-#endif
-
-#if defined(LWNODE_ENABLE_EXPERIMENTAL)
+  if (!GlobalHandles::IsWeakHandleEnabled()) {
+    LWNODE_ONCE(LWNODE_UNIMPLEMENT);
+    return nullptr;
+  }
   return GlobalHandles::ClearWeakness(VAL(location));
-#else
-  LWNODE_ONCE(LWNODE_UNIMPLEMENT);
-  return nullptr;
-#endif
 }
 
 void V8::AnnotateStrongRetainer(i::Address* location, const char* label) {
@@ -671,11 +659,6 @@ void V8::AnnotateStrongRetainer(i::Address* location, const char* label) {
 
 void V8::DisposeGlobal(i::Address* location) {
   LWNODE_CALL_TRACE();
-#if defined(GC_HEAP_TRACE_ONLY)
-  PersistentWrap::DisposeGlobal(location);
-  return;
-#endif
-
   GlobalHandles::Destroy(VAL(location));
 }
 
@@ -692,8 +675,9 @@ void V8::SetFinalizationCallbackTraced(
 
 Value* V8::Eternalize(Isolate* v8_isolate, Value* value) {
   API_ENTER_NO_EXCEPTION(v8_isolate);
-  lwIsolate->addEternal(VAL(value));
-  return value;
+  auto lwValue = ValueWrap::detach(VAL(value));
+  lwIsolate->addEternal(lwValue);
+  return reinterpret_cast<Value*>(lwValue);
 }
 
 void V8::FromJustIsNothing() {
@@ -713,7 +697,7 @@ MaybeLocal<Value> JSON::Parse(Local<Context> context,
   API_ENTER_WITH_CONTEXT(context, MaybeLocal<Value>());
   auto lwContext = lwIsolate->GetCurrentContext();
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* state, ValueRef* jsonString) -> ValueRef* {
         auto fn = state->context()->globalObject()->jsonParse();
@@ -735,7 +719,7 @@ MaybeLocal<String> JSON::Stringify(Local<Context> context,
 
   StringRef* esGap = gap.IsEmpty() ? StringRef::emptyString()
                                    : CVAL(*gap)->value()->asString();
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwContext->get(),
       [](ExecutionStateRef* state,
          ValueRef* jsonObject,
@@ -28,13 +28,14 @@
 #include "v8-profiler.h"
 #include "v8-util.h"
 
+#include "api/code-cache.h"
 #include "api/context.h"
 #include "api/error-message.h"
 #include "api/es-helper.h"
 #include "api/es-v8-helper.h"
 #include "api/extra-data.h"
 #include "api/function.h"
-#include "api/handle-external-string.h"
+#include "api/external-string.h"
 #include "api/handle.h"
 #include "api/isolate.h"
 #include "api/module.h"
@@ -68,34 +69,36 @@ class Utils {
     return v8::Local<T>::New(isolate, reinterpret_cast<T*>(ptr));
   }
 
+  // The following wraps live on the stack; CreateHandle copies them into the
+  // handle arena of the current scope.
   template <typename T>
   static v8::Local<T> NewLocal(Isolate* isolate, Escargot::ValueRef* ptr) {
-    return v8::Local<T>::New(
-        isolate,
-        reinterpret_cast<T*>(EscargotShim::ValueWrap::createValue(ptr)));
+    EscargotShim::StackValueWrap lwValue(
+        ptr, EscargotShim::HandleWrap::Type::JsValue);
+    return v8::Local<T>::New(isolate, reinterpret_cast<T*>(&lwValue));
   }
 
   template <typename T>
   static v8::Local<T> NewLocal(Isolate* isolate, Escargot::ScriptRef* ptr) {
-    return v8::Local<T>::New(
-        isolate,
-        reinterpret_cast<T*>(EscargotShim::ValueWrap::createScript(ptr)));
+    EscargotShim::StackValueWrap lwValue(
+        ptr, EscargotShim::HandleWrap::Type::Script);
+    return v8::Local<T>::New(isolate, reinterpret_cast<T*>(&lwValue));
   }
 
   static v8::Local<v8::ObjectTemplate> NewLocal(
       Isolate* isolate, Escargot::ObjectTemplateRef* ptr) {
+    EscargotShim::StackValueWrap lwValue(
+        ptr, EscargotShim::HandleWrap::Type::ObjectTemplate);
     return v8::Local<v8::ObjectTemplate>::New(
-        isolate,
-        reinterpret_cast<v8::ObjectTemplate*>(
-            EscargotShim::ValueWrap::createObjectTemplate(ptr)));
+        isolate, reinterpret_cast<v8::ObjectTemplate*>(&lwValue));
   }
 
   static v8::Local<v8::FunctionTemplate> NewLocal(
       Isolate* isolate, Escargot::FunctionTemplateRef* ptr) {
+    EscargotShim::StackValueWrap lwValue(
+        ptr, EscargotShim::HandleWrap::Type::FunctionTemplate);
     return v8::Local<v8::FunctionTemplate>::New(
-        isolate,
-        reinterpret_cast<v8::FunctionTemplate*>(
-            EscargotShim::ValueWrap::createFunctionTemplate(ptr)));
+        isolate, reinterpret_cast<v8::FunctionTemplate*>(&lwValue));
   }
 
   static v8::Local<v8::Signature> NewLocalSignature(
@@ -15,70 +15,338 @@
  */
 
 #include "arraybuffer-allocator.h"
+#include "api/global.h"
 #include "utils/misc.h"
 
+#include <sys/mman.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
 namespace EscargotShim {
 
+// --- ArrayBufferPool ---
+
+// A slab is aligned to its size, so the slab of a block is found by masking
+// the address of the block. The header is followed by the blocks.
+struct ArrayBufferPool::Slab {
+  Slab* prev;
+  Slab* next;
+  void* freeList;     // blocks freed, linked through their first word
+  size_t bumpOffset;  // offset of the first block never handed out
+  size_t blockSize;
+  size_t used;
+
+  static constexpr size_t kHeaderSize = 64;
+
+  static Slab* of(void* block) {
+    return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(block) &
+                                   ~(kSlabSize - 1));
+  }
+
+  void init(size_t size) {
+    prev = next = nullptr;
+    freeList = nullptr;
+    bumpOffset = kHeaderSize;
+    blockSize = size;
+    used = 0;
+  }
+
+  bool isFull() const {
+    return !freeList && bumpOffset + blockSize > kSlabSize;
+  }
+
+  void* take() {
+    void* block = freeList;
+    if (block) {
+      freeList = *reinterpret_cast<void**>(block);
+    } else {
+      block = reinterpret_cast<char*>(this) + bumpOffset;
+      bumpOffset += blockSize;
+    }
+    used++;
+    return block;
+  }
+
+  void put(void* block) {
+    *reinterpret_cast<void**>(block) = freeList;
+    freeList = block;
+    used--;
+  }
+
+  static void unlink(Slab*& list, Slab* slab) {
+    if (slab->prev) {
+      slab->prev->next = slab->next;
+    } else {
+      list = slab->next;
+    }
+    if (slab->next) {
+      slab->next->prev = slab->prev;
+    }
+    slab->prev = slab->next = nullptr;
+  }
+
+  static void push(Slab*& list, Slab* slab) {
+    slab->prev = nullptr;
+    slab->next = list;
+    if (list) {
+      list->prev = slab;
+    }
+    list = slab;
+  }
+};
+
+static constexpr size_t kNumberOfSizeClasses = 10;  // 16B to 8KB
+static_assert((ArrayBufferPool::kMinBlockSize << (kNumberOfSizeClasses - 1)) ==
+                  ArrayBufferPool::kMaxBlockSize,
+              "a size class is needed for each power of two");
+
+ArrayBufferPool* ArrayBufferPool::instance() {
+  static ArrayBufferPool* s_pool = []() -> ArrayBufferPool* {
+    auto flags = Global::flags();
+    if (!flags->isOn(Flag::Type::ArrayBufferPool)) {
+      return nullptr;
+    }
+
+    // --arraybuffer-pool[=<max pooled size in bytes>]
+    size_t maxPooledSize = kDefaultMaxPooledSize;
+    for (const auto& value : flags->values(Flag::Type::ArrayBufferPool)) {
+      maxPooledSize = std::strtoull(value.c_str(), nullptr, 10);
+    }
+    return new ArrayBufferPool(maxPooledSize);
+  }();
+  return s_pool;
+}
+
+ArrayBufferPool::ArrayBufferPool(size_t maxPooledSize)
+    : maxPooledSize_(std::min(maxPooledSize, kMaxBlockSize)),
+      availableSlabs_(new Slab*[kNumberOfSizeClasses]()) {
+  static_assert(sizeof(Slab) <= Slab::kHeaderSize,
+                "the slab header must fit its reserved space");
+}
+
+ArrayBufferPool::~ArrayBufferPool() {
+  // the blocks in use are leaked with their slabs
+  trim();
+  delete[] availableSlabs_;
+}
+
+size_t ArrayBufferPool::sizeClassOf(size_t length) {
+  size_t sizeClass = 0;
+  while ((kMinBlockSize << sizeClass) < length) {
+    sizeClass++;
+  }
+  return sizeClass;
+}
+
+ArrayBufferPool::Slab* ArrayBufferPool::mapSlab() {
+  // map twice the size to cut out an aligned slab
+  size_t length = kSlabSize * 2;
+  void* memory = mmap(nullptr,
+                      length,
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS,
+                      -1,
+                      0);
+  if (memory == MAP_FAILED) {
+    return nullptr;
+  }
+
+  auto start = reinterpret_cast<uintptr_t>(memory);
+  auto aligned = (start + kSlabSize - 1) & ~(kSlabSize - 1);
+  if (aligned > start) {
+    munmap(memory, aligned - start);
+  }
+  if (aligned + kSlabSize < start + length) {
+    munmap(reinterpret_cast<void*>(aligned + kSlabSize),
+           start + length - aligned - kSlabSize);
+  }
+
+  slabBytes_ += kSlabSize;
+  return reinterpret_cast<Slab*>(aligned);
+}
+
+void ArrayBufferPool::unmapSlab(Slab* slab) {
+  munmap(slab, kSlabSize);
+  slabBytes_ -= kSlabSize;
+}
+
+void* ArrayBufferPool::allocate(size_t length) {
+  LWNODE_DCHECK(isPooledSize(length));
+  size_t sizeClass = sizeClassOf(length);
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  Slab*& available = availableSlabs_[sizeClass];
+  Slab* slab = available;
+  if (!slab) {
+    if (emptySlabs_) {
+      slab = emptySlabs_;
+      Slab::unlink(emptySlabs_, slab);
+      emptySlabCount_--;
+    } else {
+      slab = mapSlab();
+      if (!slab) {
+        return nullptr;
+      }
+    }
+    slab->init(kMinBlockSize << sizeClass);
+    Slab::push(available, slab);
+  }
+
+  void* block = slab->take();
+  if (slab->isFull()) {
+    Slab::unlink(available, slab);
+  }
+  inUseBytes_ += slab->blockSize;
+  return block;
+}
+
+void ArrayBufferPool::free(void* data, size_t length) {
+  LWNODE_DCHECK(isPooledSize(length));
+  size_t sizeClass = sizeClassOf(length);
+  Slab* slab = Slab::of(data);
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  LWNODE_CHECK(slab->blockSize == (kMinBlockSize << sizeClass));
+  Slab*& available = availableSlabs_[sizeClass];
+  bool wasFull = slab->isFull();
+  slab->put(data);
+  inUseBytes_ -= slab->blockSize;
+
+  if (slab->used == 0) {
+    if (!wasFull) {
+      Slab::unlink(available, slab);
+    }
+    if (emptySlabCount_ < kMaxEmptySlabs) {
+      Slab::push(emptySlabs_, slab);
+      emptySlabCount_++;
+    } else {
+      unmapSlab(slab);
+    }
+  } else if (wasFull) {
+    Slab::push(available, slab);
+  }
+}
+
+size_t ArrayBufferPool::trim() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  size_t released = 0;
+  while (emptySlabs_) {
+    Slab* slab = emptySlabs_;
+    Slab::unlink(emptySlabs_, slab);
+    unmapSlab(slab);
+    released += kSlabSize;
+  }
+  emptySlabCount_ = 0;
+  return released;
+}
+
+ArrayBufferPool::Statistics ArrayBufferPool::statistics() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  Statistics statistics;
+  statistics.maxPooledSize = maxPooledSize_;
+  statistics.inUseBytes = inUseBytes_;
+  statistics.slabBytes = slabBytes_;
+  return statistics;
+}
+
+// --- ArrayBufferAllocatorDecorator ---
+
+std::atomic<size_t> ArrayBufferAllocatorDecorator::s_currentMemorySize{0};
+std::atomic<size_t> ArrayBufferAllocatorDecorator::s_peakMemorySize{0};
+
 void ArrayBufferAllocatorDecorator::set_array_buffer_allocator(
     v8::ArrayBuffer::Allocator* allocate) {
   array_buffer_allocator_ = allocate;
+  pool_ = ArrayBufferPool::instance();
+}
+
+void ArrayBufferAllocatorDecorator::didAllocate(size_t length) {
+  size_t current = s_currentMemorySize.fetch_add(length) + length;
+  size_t peak = s_peakMemorySize.load(std::memory_order_relaxed);
+  while (current > peak &&
+         !s_peakMemorySize.compare_exchange_weak(peak, current)) {
+  }
+}
+
+void ArrayBufferAllocatorDecorator::didFree(size_t length) {
+  s_currentMemorySize.fetch_sub(length);
 }
 
 void* ArrayBufferAllocatorDecorator::Allocate(size_t length) {
   LWNODE_CHECK_NOT_NULL(array_buffer_allocator_);
-  currentMemorySize_ += length;
-  if (currentMemorySize_ > peakMemorySize_) {
-    peakMemorySize_ = currentMemorySize_;
+  if (pool_ && pool_->isPooledSize(length)) {
+    if (void* data = pool_->allocate(length)) {
+      memset(data, 0, length);
+      didAllocate(length);
+      return data;
+    }
+    return nullptr;
   }
 
-  LWNODE_DLOG_INFO(
-      "malc: ab=%zuB | peak=%zuB", currentMemorySize_, peakMemorySize_);
-
-  return array_buffer_allocator_->Allocate(length);
+  void* data = array_buffer_allocator_->Allocate(length);
+  if (data) {
+    didAllocate(length);
+  }
+  return data;
 }
 
 void* ArrayBufferAllocatorDecorator::AllocateUninitialized(size_t length) {
   LWNODE_CHECK_NOT_NULL(array_buffer_allocator_);
-  currentMemorySize_ += length;
-  if (currentMemorySize_ > peakMemorySize_) {
-    peakMemorySize_ = currentMemorySize_;
+  void* data = (pool_ && pool_->isPooledSize(length))
+                   ? pool_->allocate(length)
+                   : array_buffer_allocator_->AllocateUninitialized(length);
+  if (data) {
+    didAllocate(length);
   }
-
-  LWNODE_DLOG_INFO(
-      "malc: ab=%zuB | peak=%zuB", currentMemorySize_, peakMemorySize_);
-
-  return array_buffer_allocator_->AllocateUninitialized(length);
+  return data;
 }
 
 void* ArrayBufferAllocatorDecorator::Reallocate(void* data,
                                                 size_t old_length,
                                                 size_t new_length) {
   LWNODE_CHECK_NOT_NULL(array_buffer_allocator_);
-  currentMemorySize_ -= old_length;
-  currentMemorySize_ += new_length;
-  if (currentMemorySize_ > peakMemorySize_) {
-    peakMemorySize_ = currentMemorySize_;
+  if (!pool_ ||
+      (!pool_->isPooledSize(old_length) && !pool_->isPooledSize(new_length))) {
+    void* newData =
+        array_buffer_allocator_->Reallocate(data, old_length, new_length);
+    if (newData) {
+      didFree(old_length);
+      didAllocate(new_length);
+    }
+    return newData;
   }
 
-  LWNODE_DLOG_INFO(
-      "malc: ab=%zuB | peak=%zuB", currentMemorySize_, peakMemorySize_);
-
-  return array_buffer_allocator_->Reallocate(data, old_length, new_length);
+  // a buffer moves in or out of the pool
+  void* newData = Allocate(new_length);
+  if (!newData) {
+    return nullptr;
+  }
+  memcpy(newData, data, std::min(old_length, new_length));
+  Free(data, old_length);
+  return newData;
 }
 
 void ArrayBufferAllocatorDecorator::Free(void* data, size_t length) {
   LWNODE_CHECK_NOT_NULL(array_buffer_allocator_);
-  currentMemorySize_ -= length;
-
-  LWNODE_DLOG_INFO(
-      "free: ab=%zuB | peak=%zuB", currentMemorySize_, peakMemorySize_);
+  if (!data) {
+    return;
+  }
+  didFree(length);
 
-  return array_buffer_allocator_->Free(data, length);
+  if (pool_ && pool_->isPooledSize(length)) {
+    pool_->free(data, length);
+    return;
+  }
+  array_buffer_allocator_->Free(data, length);
 }
 
 void ArrayBufferAllocatorDecorator::printState() {
-  LWNODE_DLOG_INFO(
-      "stat: ab=%zuB | peak: %zuB", currentMemorySize_, peakMemorySize_);
+  LWNODE_DLOG_INFO("stat: ab=%zuB | peak: %zuB",
+                   currentMemorySize(),
+                   peakMemorySize());
 }
 
 }  // namespace EscargotShim
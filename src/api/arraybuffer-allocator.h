@@ -17,10 +17,69 @@
 #pragma once
 
 #include <v8.h>
+#include <atomic>
+#include <mutex>
 #include "utils/gc-util.h"
 
 namespace EscargotShim {
 
+// Serves the backing stores of small ArrayBuffers from slabs split into
+// blocks of power-of-two size classes, so that short-lived small buffers
+// don't churn malloc. Slabs are mapped from the OS, and empty ones are
+// unmapped by trim(), which is called when the isolate is idle.
+//
+// Escargot allocates ArrayBuffer data through a single platform allocator,
+// so a block may be freed by a thread other than the one that allocated it;
+// the pool is process-wide and thread-safe.
+class ArrayBufferPool {
+ public:
+  struct Statistics {
+    size_t maxPooledSize = 0;
+    size_t inUseBytes = 0;  // bytes of the blocks handed out
+    size_t slabBytes = 0;   // bytes of the slabs mapped
+  };
+
+  static constexpr size_t kSlabSize = 64 * 1024;
+  static constexpr size_t kMinBlockSize = 16;
+  static constexpr size_t kMaxBlockSize = kSlabSize / 8;
+  static constexpr size_t kDefaultMaxPooledSize = 4 * 1024;
+  // empty slabs kept for reuse until the next trim
+  static constexpr size_t kMaxEmptySlabs = 8;
+
+  // Returns nullptr unless the pool is enabled with --arraybuffer-pool.
+  static ArrayBufferPool* instance();
+
+  explicit ArrayBufferPool(size_t maxPooledSize);
+  ~ArrayBufferPool();
+
+  bool isPooledSize(size_t length) const {
+    return length > 0 && length <= maxPooledSize_;
+  }
+
+  // The memory returned isn't initialized.
+  void* allocate(size_t length);
+  void free(void* data, size_t length);
+
+  // Unmaps the empty slabs and returns the number of bytes released.
+  size_t trim();
+  Statistics statistics();
+
+ private:
+  struct Slab;
+
+  static size_t sizeClassOf(size_t length);
+  Slab* mapSlab();
+  void unmapSlab(Slab* slab);
+
+  const size_t maxPooledSize_;
+  std::mutex mutex_;
+  Slab** availableSlabs_;  // per size class, slabs with a free block
+  Slab* emptySlabs_ = nullptr;
+  size_t emptySlabCount_ = 0;
+  size_t inUseBytes_ = 0;
+  size_t slabBytes_ = 0;
+};
+
 class ArrayBufferAllocatorDecorator : public v8::ArrayBuffer::Allocator,
                                       public gc {
  public:
@@ -35,10 +94,20 @@ class ArrayBufferAllocatorDecorator : public v8::ArrayBuffer::Allocator,
   }
   void printState();
 
+  // NOTE: A buffer may be freed through the decorator of another isolate
+  // (see ArrayBufferPool), so the sizes are counted for the process.
+  size_t currentMemorySize() const { return s_currentMemorySize; }
+  size_t peakMemorySize() const { return s_peakMemorySize; }
+
  private:
-  size_t currentMemorySize_ = 0;
-  size_t peakMemorySize_ = 0;
+  void didAllocate(size_t length);
+  void didFree(size_t length);
+
+  static std::atomic<size_t> s_currentMemorySize;
+  static std::atomic<size_t> s_peakMemorySize;
+
   v8::ArrayBuffer::Allocator* array_buffer_allocator_ = nullptr;
+  ArrayBufferPool* pool_ = nullptr;
 };
 
 }  // namespace EscargotShim
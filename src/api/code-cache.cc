@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2021-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "code-cache.h"
+#include <cstring>
+#include "es-helper.h"
+
+using namespace Escargot;
+using namespace v8;
+
+namespace EscargotShim {
+
+static uint32_t hashBytes(uint32_t hash, const void* bytes, size_t length) {
+  auto p = reinterpret_cast<const uint8_t*>(bytes);
+  for (size_t i = 0; i < length; i++) {
+    hash = (hash ^ p[i]) * 16777619u;
+  }
+  return hash;
+}
+
+uint32_t CodeCache::versionTag() {
+  // A cache is accepted by the same engine version with the same cache
+  // format only. The tag doesn't depend on when the engine was built, so
+  // rebuilding the same sources keeps the caches valid.
+  static const uint32_t s_versionTag = []() {
+    const char* engineVersion = Globals::version();
+    const uint32_t formatVersion = kFormatVersion;
+    const uint32_t pointerSize = sizeof(void*);
+    uint32_t hash = 2166136261u;
+    hash = hashBytes(hash, engineVersion, strlen(engineVersion));
+    hash = hashBytes(hash, &formatVersion, sizeof(formatVersion));
+    return hashBytes(hash, &pointerSize, sizeof(pointerSize));
+  }();
+  return s_versionTag;
+}
+
+ScriptCompiler::CachedData* CodeCache::create(StringRef* source) {
+  Header header;
+  header.magic = kMagic;
+  header.versionTag = versionTag();
+  header.sourceLength = source->length();
+  header.reserved = 0;
+  header.sourceHash = StringRefHelper::hash(source);
+
+  uint8_t* data = new uint8_t[sizeof(Header)];
+  memcpy(data, &header, sizeof(Header));
+
+  return new ScriptCompiler::CachedData(
+      data, sizeof(Header), ScriptCompiler::CachedData::BufferOwned);
+}
+
+bool CodeCache::accepts(const ScriptCompiler::CachedData* cachedData,
+                        StringRef* source) {
+  if (cachedData == nullptr || cachedData->data == nullptr ||
+      cachedData->length != static_cast<int>(sizeof(Header))) {
+    return false;
+  }
+
+  Header header;
+  memcpy(&header, cachedData->data, sizeof(Header));
+
+  return header.magic == kMagic && header.versionTag == versionTag() &&
+         header.sourceLength == source->length() &&
+         header.sourceHash == StringRefHelper::hash(source);
+}
+
+}  // namespace EscargotShim
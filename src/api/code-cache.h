@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2021-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <EscargotPublic.h>
+#include <v8.h>
+
+namespace EscargotShim {
+
+// Produces and checks ScriptCompiler::CachedData.
+// Escargot doesn't provide a way to serialize the bytecode of a script, so the
+// cached data only identifies the source, and the engine version and cache
+// format it was created for. It's accepted only if both match, and rejected
+// otherwise, as V8 does for a stale cache.
+class CodeCache {
+ public:
+  static uint32_t versionTag();
+
+  static v8::ScriptCompiler::CachedData* create(Escargot::StringRef* source);
+  static bool accepts(const v8::ScriptCompiler::CachedData* cachedData,
+                      Escargot::StringRef* source);
+
+ private:
+  struct Header {
+    uint32_t magic;
+    uint32_t versionTag;
+    uint32_t sourceLength;
+    uint32_t reserved;
+    uint64_t sourceHash;
+  };
+
+  static constexpr uint32_t kMagic = 0x43434c57;  // "LWCC"
+  // Bump this whenever Header or the data following it changes.
+  static constexpr uint32_t kFormatVersion = 1;
+};
+
+}  // namespace EscargotShim
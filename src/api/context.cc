@@ -44,7 +44,7 @@ static void evalJavaScript(ContextRef* context,
                    name,
                    scriptResult.parseErrorMessage->toStdUTF8String().data());
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       context,
       [](ExecutionStateRef* state, ScriptRef* script) -> ValueRef* {
         return script->execute(state);
@@ -62,6 +62,11 @@ ContextWrap::ContextWrap(IsolateWrap* isolate,
   val_ = context_;
   type_ = Type::Context;
 
+  LWNODE_CHECK(reinterpret_cast<uintptr_t>(&embedderData_) -
+                   reinterpret_cast<uintptr_t>(this) ==
+               static_cast<uintptr_t>(
+                   v8::internal::Internals::kContextEmbedderDataOffset));
+
   // NOTE: Not tested with multi initialization
   initDebugger();
 
@@ -141,23 +146,30 @@ ObjectRef* ContextWrap::GetExtrasBindingObject() {
 }
 
 void ContextWrap::setEmbedderData(int index, void* value) {
-  if (embedder_data_ == nullptr) {
-    embedder_data_ = new EmbedderDataMap();
-  }
+  LWNODE_CHECK(index >= 0);
   LWNODE_DLOG_INFO("set: EmbedderData: idx %d", index);
-  embedder_data_->insert(std::make_pair(index, value));
+
+  size_t slot = static_cast<size_t>(index);
+  if (slot >= embedderDataCapacity_) {
+    size_t capacity = std::max(slot + 1, embedderDataCapacity_ * 2);
+    capacity = std::max(capacity, kInitialEmbedderDataCapacity);
+    auto slots =
+        reinterpret_cast<void**>(Memory::gcMalloc(sizeof(void*) * capacity));
+    std::fill(slots, slots + capacity, nullptr);
+    std::copy(embedderData_, embedderData_ + embedderDataLength_, slots);
+    embedderData_ = slots;
+    embedderDataCapacity_ = capacity;
+  }
+
+  embedderData_[slot] = value;
+  embedderDataLength_ = std::max(embedderDataLength_, slot + 1);
 }
 
 void* ContextWrap::getEmbedderData(int index) {
-  if (!embedder_data_) {
+  if (index < 0 || static_cast<size_t>(index) >= embedderDataLength_) {
     return nullptr;
   }
-
-  auto iter = embedder_data_->find(index);
-  if (iter != embedder_data_->end()) {
-    return VAL(iter->second);
-  }
-  return nullptr;
+  return embedderData_[index];
 }
 
 void ContextWrap::SetEmbedderData(int index, ValueWrap* value) {
@@ -169,13 +181,7 @@ ValueWrap* ContextWrap::GetEmbedderData(int index) {
 }
 
 uint32_t ContextWrap::GetNumberOfEmbedderDataFields() {
-  int maxIndex = -1;
-  for (auto itr = embedder_data_->begin(); itr != embedder_data_->end();
-       ++itr) {
-    maxIndex = std::max(maxIndex, itr->first);
-  }
-
-  return maxIndex + 1;
+  return embedderDataLength_;
 }
 
 void ContextWrap::SetAlignedPointerInEmbedderData(int index, void* value) {
@@ -24,8 +24,6 @@ namespace EscargotShim {
 class IsolateWrap;
 class CallSite;
 
-typedef GCUnorderedMap<int, void*> EmbedderDataMap;
-
 class ContextWrap : public ValueWrap {
  public:
   static ContextWrap* New(
@@ -62,7 +60,14 @@ class ContextWrap : public ValueWrap {
   void initDebugger();
 
  private:
-  EmbedderDataMap* embedder_data_{nullptr};
+  // @important The embedder data slots are the first fields, as
+  // v8::Context::GetAlignedPointerFromEmbedderData reads them inline (see
+  // Internals::kContextEmbedderDataOffset). The length is the highest index
+  // set plus 1; slots up to the capacity are null.
+  void** embedderData_ = nullptr;
+  size_t embedderDataLength_ = 0;
+  size_t embedderDataCapacity_ = 0;
+  static constexpr size_t kInitialEmbedderDataCapacity = 16;
 
   ContextWrap(IsolateWrap* isolate,
               v8::ExtensionConfiguration* extensionConfiguration);
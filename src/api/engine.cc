@@ -16,11 +16,8 @@
 
 #include "engine.h"
 
-#include <iomanip>
-#include <sstream>
-
 #include "api/global.h"
-#include "handle.h"
+#include "external-string.h"
 #include "utils/misc.h"
 #include "utils/string-util.h"
 
@@ -92,240 +89,9 @@ void Platform::hostImportModuleDynamically(ContextRef* relatedContext,
   LWNODE_UNIMPLEMENT;
 }
 
-// --- G C H e a p ---
-
-#define GC_WRAP_PERSISTENT_POINTER(p) (GC_heap_pointer)(p)
-#define GC_UNWRAP_PERSISTENT_POINTER(p) ((void*)p)
-#define GC_WRAP_WEAK_POINTER(p) (GC_heap_pointer)(p)
-#define GC_UNWRAP_WEAK_POINTER(p) ((void*)p)
-
-/*
-  state diagram:
-  FREE -> STRONG <-> WEAK -> (Post GC Processing) -> { STRONG, WEAK, FREE }
-*/
-
-void GCHeap::acquire(void* address, Kind kind, void* data) {
-  LWNODE_CALL_TRACE_ID(
-      GCHEAP,
-      "%s kind %u data %p",
-      PersistentWrap::as(address)->getPersistentInfoString().c_str(),
-      kind,
-      data);
-
-  auto iter = persistents_.find(GC_WRAP_PERSISTENT_POINTER(address));
-  if (iter != persistents_.end()) {
-    if (kind == STRONG) iter->second.strong++;
-    if (kind == WEAK) iter->second.weak++;
-  } else {
-    auto iter = weakPhantoms_.find(GC_WRAP_WEAK_POINTER(address));
-    if (iter != weakPhantoms_.end()) {
-      AddressInfo info = iter->second;
-
-      LWNODE_CHECK(info.strong == 0);
-      LWNODE_CHECK(info.weak != 0);
-
-      if (kind == STRONG) iter->second.strong++;
-      if (kind == WEAK) iter->second.weak++;
-
-      persistents_.emplace(GC_WRAP_PERSISTENT_POINTER(address), info);
-      weakPhantoms_.erase(iter);
-    } else {
-      persistents_.emplace(GC_WRAP_PERSISTENT_POINTER(address),
-                           AddressInfo(1, 0, data));
-    }
-  }
-  postUpdate(address);
-}
-
-void GCHeap::release(void* address, Kind kind) {
-  LWNODE_CALL_TRACE_ID(
-      GCHEAP,
-      "%s kind %u",
-      PersistentWrap::as(address)->getPersistentInfoString().c_str(),
-      kind);
-
-  auto iter = persistents_.find(GC_WRAP_PERSISTENT_POINTER(address));
-  if (iter != persistents_.end()) {
-    if (kind == STRONG) iter->second.strong--;
-    if (kind == WEAK) iter->second.weak--;
-
-    iter->second.strong = std::max(iter->second.strong, 0);
-    iter->second.weak = std::max(iter->second.weak, 0);
-
-    // progress handling weak phantoms
-    if (iter->second.strong == 0) {
-      if (iter->second.weak > 0) {
-        weakPhantoms_.emplace(GC_WRAP_WEAK_POINTER(address), iter->second);
-      }
-      persistents_.erase(iter);
-    }
-  }
-  postUpdate(address);
-}
-
-void GCHeap::postGarbageCollectionProcessing() {
-  if (isOnPostGarbageCollectionProcessing_ ||
-      ProcessingHoldScope::isSkipProcessing()) {
-    return;
-  }
-
-  LWNODE_CALL_TRACE_ID(
-      GCHEAP, "last: %zu, current: %zu", stat_.weak, weakPhantoms_.size());
-  if (stat_.weak == weakPhantoms_.size()) {
-    return;
-  }
-  isOnPostGarbageCollectionProcessing_ = true;
-
-  // 1. move weaks to process post task.
-  GCVector<HeapSegment> weaks;
-  weaks.reserve(weakPhantoms_.size());
-  for (const HeapSegment& it : weakPhantoms_) {
-    weaks.push_back(it);
-  }
-  weakPhantoms_.clear();
-
-  // 2. invoke finalizers
-  for (const auto& iter : weaks) {
-    PersistentWrap* persistent =
-        PersistentWrap::as(GC_UNWRAP_PERSISTENT_POINTER(iter.first));
-    persistent->invokeFinalizer();
-  }
-
-  stat_.weak = weakPhantoms_.size();
-  isOnPostGarbageCollectionProcessing_ = false;
-}
-
-bool GCHeap::isTraced(void* address) {
-  if (persistents_.find(GC_WRAP_PERSISTENT_POINTER(address)) !=
-      persistents_.end()) {
-    return true;
-  }
-
-  if (weakPhantoms_.find(GC_WRAP_WEAK_POINTER(address)) !=
-      weakPhantoms_.end()) {
-    return true;
-  }
-
-  return false;
-}
-
-void GCHeap::disposePhantomWeak(void* address) {
-  LWNODE_CALL_TRACE_ID(
-      GCHEAP,
-      "%s",
-      PersistentWrap::as(address)->getPersistentInfoString().c_str());
-  stat_.freed++;
-  auto iter = weakPhantoms_.find(GC_WRAP_WEAK_POINTER(address));
-  if (iter != weakPhantoms_.end()) {
-    weakPhantoms_.erase(iter);
-  }
-  postUpdate(address);
-}
-
-typedef void (*formatterFunction)(std::stringstream& stream,
-                                  const GCHeap::HeapSegment& iter);
-
-static void printAddress(
-    const GCUnorderedMap<GCHeap::GC_heap_pointer, GCHeap::AddressInfo>& map,
-    formatterFunction formatter,
-    const int column = 4) {
-  std::stringstream ss;
-  std::vector<std::string> vector;
-  int count = 0;
-  for (const auto& iter : map) {
-    formatter(ss, iter);
-    if (++count % column == 0) {
-      vector.push_back(ss.str());
-      ss.str("");
-    }
-  }
-  if (count % column) {
-    vector.push_back(ss.str());
-  }
-  for (const auto& it : vector) {
-    LWNODE_LOG_INFO("%s", it.c_str());
-  }
-}
-
-void GCHeap::printStatus(bool forcePrint) {
-  if (!Global::flags()->isOn(Flag::Type::TraceCall, "GCHEAP")) {
-    return;
-  }
-
-  if (!forcePrint && isStatePrinted_) {
-    return;
-  }
-
-  isStatePrinted_ = true;
-
-  if (!forcePrint || (persistents_.size() == 0 && weakPhantoms_.size() == 0)) {
-    return;
-  }
-
-  LWNODE_DLOG_INFO(CLR_GREEN "----- GCHEAP -----" CLR_RESET);
-  LWNODE_DLOG_INFO("[STAT]");
-  LWNODE_DLOG_INFO("     freed: %zu", stat_.freed);
-  LWNODE_DLOG_INFO("    strong: %zu", persistents_.size());
-  LWNODE_DLOG_INFO("      weak: %zu", weakPhantoms_.size());
-  LWNODE_DLOG_INFO("[HOLD]");
-  printAddress(persistents_,
-               [](std::stringstream& stream, const HeapSegment& iter) {
-                 std::ios_base::fmtflags flags(stream.flags());
-                 stream << std::setw(15) << std::right
-                        << GC_UNWRAP_PERSISTENT_POINTER(iter.first) << " ("
-                        << "S" << std::setw(3) << iter.second.strong << " W"
-                        << std::setw(3) << iter.second.weak << ") ";
-                 stream.flags(flags);
-               });
-
-  LWNODE_DLOG_INFO(CLR_GREEN "------------------" CLR_RESET);
-  LWNODE_DLOG_INFO("[PHANTOM]");
-  printAddress(weakPhantoms_,
-               [](std::stringstream& stream, const HeapSegment& iter) {
-                 std::ios_base::fmtflags flags(stream.flags());
-                 stream << std::setw(15) << std::right
-                        << GC_UNWRAP_WEAK_POINTER(iter.first) << " ("
-                        << "S" << std::setw(3) << iter.second.strong << " W"
-                        << std::setw(3) << iter.second.weak << ") ";
-                 stream.flags(flags);
-               });
-
-  LWNODE_DLOG_INFO(CLR_GREEN "------------------" CLR_RESET);
-}
-
-void GCHeap::postUpdate(void* address) {
-  isStatePrinted_ = false;
-}
-
-void GCHeap::processGCEvent(void* data) {
-  auto gcHeap = Engine::current()->gcHeap();
-  gcHeap->printStatus();
-  gcHeap->postGarbageCollectionProcessing();
-}
-
-std::vector<GCHeap::ProcessingHoldScope*>
-    GCHeap::ProcessingHoldScope::s_processingHoldScopes_;
-
-GCHeap::ProcessingHoldScope::ProcessingHoldScope() {
-  s_processingHoldScopes_.push_back(this);
-}
-
-GCHeap::ProcessingHoldScope::~ProcessingHoldScope() {
-  s_processingHoldScopes_.pop_back();
-}
-
-bool GCHeap::ProcessingHoldScope::isSkipProcessing() {
-  if (s_processingHoldScopes_.empty()) {
-    return false;
-  }
-  return true;
-}
-
 // --- E n g i n e ---
 
 static Engine* s_engine;
-std::unordered_set<v8::String::ExternalStringResourceBase*>
-    Engine::s_externalStrings;
 static Engine::State s_state = Engine::Freed;
 
 bool Engine::Initialize() {
@@ -366,12 +132,6 @@ void Engine::initialize() {
 
   Globals::initialize(Platform::GetInstance());
   Memory::setGCFrequency(GC_FREE_SPACE_DIVISOR);
-  gcHeap_.reset(GCHeap::create());
-
-  if (Global::flags()->isOn(Flag::Type::TraceGC)) {
-    LWNODE_DLOG_WARN("temporary blocked for postGarbageCollectionProcessing");
-    registerGCEventListeners();
-  }
 
   mainThreadId_ = std::this_thread::get_id();
 }
@@ -380,13 +140,10 @@ void Engine::dispose() {
   LWNODE_CALL_TRACE_GC_START();
   s_state = OnDestroy;
 
-  unregisterGCEventListeners();
-
-  gcHeap_.release();
   GC_invoke_finalizers();
 
   Globals::finalize();
-  disposeExternalStrings();
+  ExternalStringRegistry::instance()->disposeAll();
   LWNODE_CALL_TRACE_GC_END();
 }
 
@@ -410,49 +167,4 @@ void Engine::finalizeThread() {
 Engine::State Engine::getState() {
   return s_state;
 }
-
-void Engine::registerExternalString(
-    v8::String::ExternalStringResourceBase* v8Str) {
-  s_externalStrings.emplace(v8Str);
-}
-
-void Engine::unregisterExternalString(
-    v8::String::ExternalStringResourceBase* v8Str) {
-  s_externalStrings.erase(v8Str);
-}
-
-void Engine::disposeExternalStrings() {
-  std::vector<v8::String::ExternalStringResourceBase*> strToDispose;
-
-  for (auto str : s_externalStrings) {
-    strToDispose.push_back(str);
-  }
-  for (auto str : strToDispose) {
-    str->Dispose();
-  }
-
-  s_externalStrings.clear();
-}
-
-void Engine::registerGCEventListeners() {
-#if defined(GC_HEAP_TRACE_ONLY)
-  Memory::addGCEventListener(
-      Memory::GCEventType::RECLAIM_END, GCHeap::processGCEvent, nullptr);
-#else
-  Memory::addGCEventListener(Memory::GCEventType::RECLAIM_END,
-                             MemoryUtil::gcPrintGCMemoryUsage,
-                             nullptr);
-#endif
-}
-
-void Engine::unregisterGCEventListeners() {
-#if defined(GC_HEAP_TRACE_ONLY)
-  Memory::removeGCEventListener(
-      Memory::GCEventType::RECLAIM_END, GCHeap::processGCEvent, nullptr);
-#else
-  Memory::removeGCEventListener(Memory::GCEventType::RECLAIM_END,
-                                MemoryUtil::gcPrintGCMemoryUsage,
-                                nullptr);
-#endif
-}
 }  // namespace EscargotShim
@@ -20,6 +20,7 @@
 #include <string.h>
 #include <v8.h>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "utils/gc-util.h"
@@ -72,79 +73,12 @@ class Platform : public PlatformRef {
   v8::ArrayBuffer::Allocator* allocator_ = nullptr;
 };
 
-class GCHeap : public gc {
- public:
-  enum Kind {
-    FREE = 0,
-    STRONG,
-    WEAK,
-  };
-
-  struct AddressInfo {
-    AddressInfo(int strong_, int weak_, void* data_ = nullptr) {
-      strong = strong_;
-      weak = weak_;
-      data = data_;
-    }
-    int strong = 0;
-    int weak = 0;
-    void* data = nullptr;
-  };
-  typedef GC_word GC_heap_pointer;
-  typedef std::pair<const GC_heap_pointer, AddressInfo> HeapSegment;
-
-  void acquire(void* address, Kind kind, void* data);
-  void release(void* address, Kind kind);
-  void disposePhantomWeak(void* address);
-  bool isTraced(void* address);
-  void printStatus(bool forcePrint = false);
-
-  class ProcessingHoldScope {
-   public:
-    ProcessingHoldScope();
-    ~ProcessingHoldScope();
-
-    static bool isSkipProcessing();
-
-   private:
-    static std::vector<ProcessingHoldScope*> s_processingHoldScopes_;
-  };
-
-  void postGarbageCollectionProcessing();
-  static void processGCEvent(void* data);
-
-  static GCHeap* create() { return new GCHeap(); }
-
- private:
-  void postUpdate(void* address);
-
-  GCUnorderedMap<GC_heap_pointer, AddressInfo> persistents_;
-  GCUnorderedMap<GC_heap_pointer, AddressInfo> weakPhantoms_;
-  bool isStatePrinted_ = false;
-  bool isOnPostGarbageCollectionProcessing_ = false;
-  struct Stat {
-    size_t freed = 0;
-    size_t weak = 0;
-  };
-
-  Stat stat_;
-};
-
 class Engine {
  public:
   static bool Initialize();
   static bool Dispose();
 
   static Engine* current();
-  static void registerExternalString(
-      v8::String::ExternalStringResourceBase* v8Str);
-  static void unregisterExternalString(
-      v8::String::ExternalStringResourceBase* v8Str);
-
-  GCHeap* gcHeap() { return gcHeap_.get(); }
-
-  void registerGCEventListeners();
-  void unregisterGCEventListeners();
 
   enum State {
     Freed,
@@ -161,12 +95,7 @@ class Engine {
   Engine() = default;
   void initialize();
   void dispose();
-  void disposeExternalStrings();
-
-  static std::unordered_set<v8::String::ExternalStringResourceBase*>
-      s_externalStrings;
 
-  PersistentRefHolder<GCHeap> gcHeap_;
   std::thread::id mainThreadId_;
 };
 }  // namespace EscargotShim
@@ -23,6 +23,9 @@ namespace EscargotShim {
   T(DataCloneErrorOutOfMemory,                                                 \
     RangeError,                                                                \
     "Data cannot be cloned, out of memory.")                                   \
+  T(DataCloneErrorSharedArrayBuffer,                                           \
+    TypeError,                                                                 \
+    "#<SharedArrayBuffer> could not be cloned.")                               \
   T(InternalFieldsOutOfRange, RangeError, "Internal field out of bounds.")     \
   T(NotReadValue, RangeError, "Cannot read value")                             \
   T(IllegalInvocation, TypeError, "Illegal invocation")                        \
@@ -40,11 +40,26 @@ EvalResult::EvalResult(const EvalResult& src)
 EvalResult::EvalResult(EvalResult&& src)
     : Evaluator::EvaluatorResult(std::move(src)) {}
 
+// --- EvalHelper ---
+
+ExecutionStateRef* EvalHelper::currentExecutionState(ContextRef* context) {
+  auto lwIsolate = IsolateWrap::GetCurrent();
+  if (lwIsolate == nullptr) {
+    return nullptr;
+  }
+
+  auto state = lwIsolate->currentExecutionState();
+  if (state == nullptr || state->context() != context) {
+    return nullptr;
+  }
+  return state;
+}
+
 // --- ObjectRefHelper ---
 
 ObjectRef* ObjectRefHelper::create(ContextRef* context) {
   EvalResult r =
-      Evaluator::execute(context, [](ExecutionStateRef* state) -> ValueRef* {
+      EvalHelper::execute(context, [](ExecutionStateRef* state) -> ValueRef* {
         return ObjectRef::create(state);
       });
 
@@ -61,7 +76,7 @@ EvalResult ObjectRefHelper::setProperty(ContextRef* context,
   LWNODE_DCHECK_NOT_NULL(key);
   LWNODE_DCHECK_NOT_NULL(value);
 
-  return Evaluator::execute(
+  return EvalHelper::execute(
       context,
       [](ExecutionStateRef* state,
          ObjectRef* object,
@@ -128,7 +143,7 @@ EvalResult ObjectRefHelper::getPropertyAttributes(
   LWNODE_DCHECK_NOT_NULL(object);
   LWNODE_DCHECK_NOT_NULL(key);
 
-  return Evaluator::execute(
+  return EvalHelper::execute(
       context,
       [](ExecutionStateRef* state,
          ObjectRef* object,
@@ -160,7 +175,7 @@ EvalResult ObjectRefHelper::getProperty(ContextRef* context,
   LWNODE_DCHECK_NOT_NULL(object);
   LWNODE_DCHECK_NOT_NULL(key);
 
-  return Evaluator::execute(
+  return EvalHelper::execute(
       context,
       [](ExecutionStateRef* esState,
          ObjectRef* object,
@@ -175,7 +190,7 @@ EvalResult ObjectRefHelper::getOwnProperty(ContextRef* context,
   LWNODE_DCHECK_NOT_NULL(object);
   LWNODE_DCHECK_NOT_NULL(key);
 
-  return Evaluator::execute(
+  return EvalHelper::execute(
       context,
       [](ExecutionStateRef* esState, ObjectRef* object, ValueRef* key)
           -> ValueRef* { return object->getOwnProperty(esState, key); },
@@ -189,7 +204,7 @@ EvalResult ObjectRefHelper::hasProperty(ContextRef* context,
   LWNODE_DCHECK_NOT_NULL(object);
   LWNODE_DCHECK_NOT_NULL(key);
 
-  return Evaluator::execute(
+  return EvalHelper::execute(
       context,
       [](ExecutionStateRef* state, ObjectRef* object, ValueRef* key)
           -> ValueRef* { return ValueRef::create(object->has(state, key)); },
@@ -203,7 +218,7 @@ EvalResult ObjectRefHelper::hasOwnProperty(ContextRef* context,
   LWNODE_DCHECK_NOT_NULL(object);
   LWNODE_DCHECK_NOT_NULL(key);
 
-  return Evaluator::execute(
+  return EvalHelper::execute(
       context,
       [](ExecutionStateRef* state,
          ObjectRef* object,
@@ -219,7 +234,7 @@ EvalResult ObjectRefHelper::getOwnIndexedProperty(ContextRef* context,
                                                   uint32_t index) {
   LWNODE_DCHECK_NOT_NULL(object);
 
-  return Evaluator::execute(
+  return EvalHelper::execute(
       context,
       [](ExecutionStateRef* state,
          ObjectRef* object,
@@ -244,7 +259,7 @@ EvalResult ObjectRefHelper::deleteProperty(ContextRef* context,
   LWNODE_DCHECK_NOT_NULL(object);
   LWNODE_DCHECK_NOT_NULL(key);
 
-  return Evaluator::execute(
+  return EvalHelper::execute(
       context,
       [](ExecutionStateRef* state,
          ObjectRef* object,
@@ -255,6 +270,25 @@ EvalResult ObjectRefHelper::deleteProperty(ContextRef* context,
       key);
 }
 
+// v8::Private values are kept in the extra data of an object if it has its
+// own one, so that accessing them is a direct lookup. Other objects keep them
+// in a hidden object stored under IsolateWrap::privateValuesSymbol().
+static ExtraData* getPrivateValuesHolder(ObjectRef* object) {
+  auto data = ExtraDataHelper::getExtraData(object);
+  if (data == nullptr || data->isFunctionTemplateData() ||
+      data->isObjectTemplateData()) {
+    // template data is shared by the objects created from the template
+    return nullptr;
+  }
+  return data;
+}
+
+static EvalResult toEvalResult(ValueRef* value) {
+  EvalResult r;
+  r.result = value;
+  return r;
+}
+
 EvalResult ObjectRefHelper::deletePrivateProperty(ContextRef* context,
                                                   SymbolRef* privateValueSymbol,
                                                   ObjectRef* object,
@@ -262,7 +296,12 @@ EvalResult ObjectRefHelper::deletePrivateProperty(ContextRef* context,
   LWNODE_DCHECK_NOT_NULL(object);
   LWNODE_DCHECK_NOT_NULL(key);
 
-  return Evaluator::execute(
+  auto holder = getPrivateValuesHolder(object);
+  if (holder) {
+    return toEvalResult(ValueRef::create(holder->deletePrivate(key)));
+  }
+
+  return EvalHelper::execute(
       context,
       [](ExecutionStateRef* state,
          SymbolRef* privateValueSymbol,
@@ -270,7 +309,10 @@ EvalResult ObjectRefHelper::deletePrivateProperty(ContextRef* context,
          ValueRef* key) -> ValueRef* {
         ValueRef* privateValuesObj = object->get(state, privateValueSymbol);
 
-        if (privateValuesObj->isUndefined()) {
+        // deleting a missing property succeeds in JS, but a missing private
+        // value is reported as false
+        if (privateValuesObj->isUndefined() ||
+            !privateValuesObj->asObject()->hasOwnProperty(state, key)) {
           return ValueRef::create(false);
         }
 
@@ -289,7 +331,7 @@ EvalResult ObjectRefHelper::defineAccessorProperty(
     const ObjectRef::AccessorPropertyDescriptor& descriptor) {
   LWNODE_DCHECK(propertyName->isSymbol() || propertyName->isString());
 
-  return Evaluator::execute(
+  return EvalHelper::execute(
       context,
       [](ExecutionStateRef* state,
          ObjectRef* object,
@@ -310,7 +352,7 @@ EvalResult ObjectRefHelper::defineDataProperty(
     const ObjectRef::DataPropertyDescriptor& descriptor) {
   LWNODE_DCHECK(propertyName->isSymbol() || propertyName->isString());
 
-  return Evaluator::execute(
+  return EvalHelper::execute(
       context,
       [](ExecutionStateRef* state,
          ObjectRef* object,
@@ -326,7 +368,7 @@ EvalResult ObjectRefHelper::defineDataProperty(
 
 ObjectRef* ObjectRefHelper::getPrototype(ContextRef* context,
                                          ObjectRef* object) {
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       context,
       [](ExecutionStateRef* state, ObjectRef* object) -> ValueRef* {
         return object->getPrototype(state);
@@ -340,7 +382,7 @@ ObjectRef* ObjectRefHelper::getPrototype(ContextRef* context,
 EvalResult ObjectRefHelper::setPrototype(ContextRef* context,
                                          ObjectRef* object,
                                          ValueRef* prototype) {
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       context,
       [](ExecutionStateRef* state,
          ObjectRef* object,
@@ -358,7 +400,13 @@ EvalResult ObjectRefHelper::getPrivate(ContextRef* context,
                                        SymbolRef* privateValueSymbol,
                                        ObjectRef* object,
                                        ValueRef* key) {
-  return Evaluator::execute(
+  auto holder = getPrivateValuesHolder(object);
+  if (holder) {
+    auto value = holder->getPrivate(key);
+    return toEvalResult(value ? value : ValueRef::createUndefined());
+  }
+
+  return EvalHelper::execute(
       context,
       [](ExecutionStateRef* state,
          SymbolRef* privateValueSymbol,
@@ -385,7 +433,13 @@ EvalResult ObjectRefHelper::setPrivate(ContextRef* context,
                                        ValueRef* value) {
   LWNODE_CHECK(key->isSymbol());
 
-  return Evaluator::execute(
+  auto holder = getPrivateValuesHolder(object);
+  if (holder) {
+    holder->setPrivate(key, value);
+    return toEvalResult(ValueRef::create(true));
+  }
+
+  return EvalHelper::execute(
       context,
       [](ExecutionStateRef* state,
          ContextRef* context,
@@ -437,13 +491,17 @@ bool ObjectRefHelper::hasExtraData(ObjectRef* object) {
   return false;
 }
 
+static void takePrivateValues(ObjectRef* object, ExtraData* data);
+
 void ObjectRefHelper::setExtraData(ObjectRef* object,
                                    ObjectData* data,
                                    bool isForceReplace) {
-  if (isForceReplace == false && object->extraData()) {
+  auto extraData = ExtraDataHelper::getExtraData(object);
+  if (extraData && isForceReplace == false) {
     LWNODE_DLOG_WARN(
         "Replacing already existing extra data. Is this intended?");
   }
+  takePrivateValues(object, data);
 
   object->setExtraData(data);
 }
@@ -454,7 +512,7 @@ ObjectData* ObjectRefHelper::getExtraData(ObjectRef* object) {
 }
 
 ObjectRef* ObjectRefHelper::toObject(ContextRef* context, ValueRef* value) {
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       context,
       [](ExecutionStateRef* state, ValueRef* value) -> ValueRef* {
         return value->toObject(state);
@@ -472,7 +530,7 @@ StringRef* ObjectRefHelper::getConstructorName(ContextRef* context,
     This function is buggy in some cases.
     Please check THREADED_TEST(ObjectGetConstructorName)
   */
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       context,
       [](ExecutionStateRef* state, ObjectRef* object) -> ValueRef* {
         OptionalRef<ObjectRef> maybeProto = object->getPrototypeObject(state);
@@ -502,7 +560,7 @@ void ObjectRefHelper::addNativeFunction(ContextRef* context,
                                         ObjectRef* object,
                                         StringRef* name,
                                         NativeFunctionPointer function) {
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       context,
       [](ExecutionStateRef* state,
          ObjectRef* target,
@@ -533,7 +591,7 @@ void ObjectRefHelper::addNativeFunction(ContextRef* context,
 
 ArrayObjectRef* ArrayObjectRefHelper::create(ContextRef* context,
                                              const uint64_t length) {
-  auto result = Evaluator::execute(
+  auto result = EvalHelper::execute(
       context,
       [](ExecutionStateRef* state, uint64_t length) -> ValueRef* {
         return ArrayObjectRef::create(state, length);
@@ -545,7 +603,7 @@ ArrayObjectRef* ArrayObjectRefHelper::create(ContextRef* context,
 
 ArrayObjectRef* ArrayObjectRefHelper::create(ContextRef* context,
                                              ValueVectorRef* elements) {
-  auto result = Evaluator::execute(
+  auto result = EvalHelper::execute(
       context,
       [](ExecutionStateRef* state, ValueVectorRef* elements) -> ValueRef* {
         return ArrayObjectRef::create(state, elements);
@@ -558,7 +616,7 @@ ArrayObjectRef* ArrayObjectRefHelper::create(ContextRef* context,
 uint64_t ArrayObjectRefHelper::length(ContextRef* context,
                                       ArrayObjectRef* object) {
   uint64_t output = 0;
-  auto result = Evaluator::execute(
+  auto result = EvalHelper::execute(
       context,
       [](ExecutionStateRef* state,
          ArrayObjectRef* object,
@@ -707,7 +765,7 @@ Evaluator::EvaluatorResult EvalResultHelper::compileRun(ContextRef* context,
     return result;
   }
 
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       context,
       [](ExecutionStateRef* state, ScriptRef* script) -> ValueRef* {
         return script->execute(state);
@@ -795,7 +853,7 @@ void EvalResultHelper::attachBuiltinPrint(ContextRef* context,
     return ValueRef::createUndefined();
   };
 
-  Evaluator::execute(
+  EvalHelper::execute(
       context,
       [](ExecutionStateRef* state, ObjectRef* target) -> ValueRef* {
         auto esPrint =
@@ -919,19 +977,64 @@ void ExtraDataHelper::setExtraData(FunctionTemplateRef* ftpl,
 void ExtraDataHelper::setExtraData(FunctionObjectRef* functionObject,
                                    FunctionData* data,
                                    bool force) {
-  auto extraData = functionObject->extraData();
+  auto extraData = ExtraDataHelper::getExtraData(functionObject);
   if (!force && extraData) {
     LWNODE_DLOG_WARN("Replacing ExtraData: Is this intended?");
   }
+  data->takePrivateValues(extraData);
   functionObject->setExtraData(data);
 }
 
+// Move the private values that were stored in the hidden object before the
+// object got its own extra data (see getPrivateValuesHolder).
+static void movePrivateValuesToExtraData(ObjectRef* object, ExtraData* data) {
+  auto lwIsolate = IsolateWrap::GetCurrent();
+  if (lwIsolate == nullptr || !lwIsolate->InContext()) {
+    return;
+  }
+
+  EvalHelper::execute(
+      lwIsolate->GetCurrentContext()->get(),
+      [](ExecutionStateRef* state,
+         SymbolRef* privateValueSymbol,
+         ObjectRef* object,
+         ExtraData* data) -> ValueRef* {
+        auto hiddenValuesRef =
+            object->getOwnProperty(state, privateValueSymbol);
+        if (!hiddenValuesRef->isObject()) {
+          return ValueRef::createUndefined();
+        }
+
+        auto hiddenValues = hiddenValuesRef->asObject();
+        auto keys = hiddenValues->ownPropertyKeys(state);
+        for (size_t i = 0; i < keys->size(); i++) {
+          data->setPrivate(keys->at(i),
+                           hiddenValues->getOwnProperty(state, keys->at(i)));
+        }
+        return ValueRef::createUndefined();
+      },
+      lwIsolate->privateValuesSymbol(),
+      object,
+      data);
+}
+
+// Gives |data|, which replaces the extra data of |object|, the private values
+// of the object wherever they are kept.
+static void takePrivateValues(ObjectRef* object, ExtraData* data) {
+  auto holder = getPrivateValuesHolder(object);
+  if (holder) {
+    data->takePrivateValues(holder);
+  } else {
+    movePrivateValuesToExtraData(object, data);
+  }
+}
+
 void ExtraDataHelper::setExtraData(ObjectRef* exceptionObject,
                                    ExceptionObjectData* data) {
-  auto extraData = exceptionObject->extraData();
-  if (extraData) {
-    LWNODE_DLOG_WARN("Replacing ExtraData: Is this intended?");
-  }
+  // an exception gets new extra data each time it is rethrown through the
+  // API, and any object can be thrown, so native code may have set private
+  // values on it already
+  takePrivateValues(exceptionObject, data);
   exceptionObject->setExtraData(data);
 }
 
@@ -940,14 +1043,16 @@ void ExtraDataHelper::setExtraData(ObjectRef* callSite, StackTraceData* data) {
   if (extraData) {
     LWNODE_DLOG_WARN("Replacing ExtraData: Is this intended?");
   }
+  takePrivateValues(callSite, data);
   callSite->setExtraData(data);
 }
 
 void ExtraDataHelper::setExtraData(ObjectRef* object, ObjectData* data) {
-  auto extraData = object->extraData();
+  auto extraData = ExtraDataHelper::getExtraData(object);
   if (extraData) {
     LWNODE_DLOG_WARN("Replacing ExtraData: Is this intended?");
   }
+  takePrivateValues(object, data);
   object->setExtraData(data);
 }
 
@@ -978,7 +1083,7 @@ ValueRef* ExceptionHelper::unwrapException(void* exception) {
 ErrorObjectRef* ExceptionHelper::createErrorObject(ContextRef* context,
                                                    ErrorObjectRef::Code code,
                                                    StringRef* errorMessage) {
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       context,
       [](ExecutionStateRef* state,
          ErrorObjectRef::Code code,
@@ -1009,42 +1114,158 @@ void ExceptionHelper::addStackPropertyCallback(ExecutionStateRef* state,
   }
 
   StackTrace stackTrace(state, error->asObject());
-  auto sites = stackTrace.genCallSites(state->computeStackTrace());
-  stackTrace.addStackProperty(sites);
+  stackTrace.addStackProperty(
+      stackTrace.collectFrames(state->computeStackTrace()));
 }
 
 // --- StringRefHelper ---
 
-bool StringRefHelper::isAsciiString(StringRef* string) {
-  auto bufferData = string->stringBufferAccessData();
+// Strings are immutable and aren't moved by the GC, so a classification
+// stays valid for as long as the string lives. Entries are keyed by the
+// address of the string and of its buffer, hidden from the collector so the
+// cache doesn't retain anything. An address can be reused only after a
+// collection, so entries made before the last one are stale.
+namespace {
+struct StringEncodingCacheEntry {
+  uintptr_t hiddenString = 0;
+  uintptr_t hiddenBuffer = 0;
+  size_t length = 0;
+  GC_word gcNumber = 0;
+  size_t utf8Length = 0;
+  StringEncoding::Type type = StringEncoding::kAscii;
+};
+
+constexpr size_t kStringEncodingCacheSize = 64;
+// shorter strings are cheaper to scan than to look up
+constexpr size_t kMinCachedStringLength = 256;
+
+thread_local StringEncodingCacheEntry
+    s_stringEncodingCache[kStringEncodingCacheSize];
+
+inline uintptr_t hidePointer(const void* pointer) {
+  return ~reinterpret_cast<uintptr_t>(pointer);
+}
 
-  if (!bufferData.has8BitContent) {
-    return false;
+StringEncodingCacheEntry* lookupStringEncoding(
+    StringRef* string, const StringRef::StringBufferAccessDataRef& bufferData) {
+  if (bufferData.length < kMinCachedStringLength) {
+    return nullptr;
   }
 
-  bool isAscii = true;
-  for (size_t i = 0; i < bufferData.length; i++) {
-    char16_t c = bufferData.charAt(i);
-    if (c > 127) {  // including all 7 bit code
-      isAscii = false;
-      break;
-    }
+  auto key = hidePointer(string);
+  auto index = (reinterpret_cast<uintptr_t>(string) >> 4) ^
+               (reinterpret_cast<uintptr_t>(string) >> 10);
+  auto entry = &s_stringEncodingCache[index % kStringEncodingCacheSize];
+  auto gcNumber = GC_get_gc_no();
+
+  if (entry->hiddenString == key &&
+      entry->hiddenBuffer == hidePointer(bufferData.buffer) &&
+      entry->length == bufferData.length && entry->gcNumber == gcNumber) {
+    return entry;
+  }
+
+  StringEncoding::Type type;
+  size_t utf8Length;
+  if (bufferData.has8BitContent) {
+    auto buffer = reinterpret_cast<const uint8_t*>(bufferData.buffer);
+    type = StringEncoding::classify(buffer, bufferData.length);
+    utf8Length = (type == StringEncoding::kAscii)
+                     ? bufferData.length
+                     : UTF8Encoder::length(buffer, bufferData.length);
+  } else {
+    auto buffer = reinterpret_cast<const char16_t*>(bufferData.buffer);
+    type = StringEncoding::classify(buffer, bufferData.length);
+    utf8Length = (type == StringEncoding::kAscii)
+                     ? bufferData.length
+                     : UTF8Encoder::length(buffer, bufferData.length);
+  }
+
+  entry->hiddenString = key;
+  entry->hiddenBuffer = hidePointer(bufferData.buffer);
+  entry->length = bufferData.length;
+  entry->gcNumber = gcNumber;
+  entry->utf8Length = utf8Length;
+  entry->type = type;
+  return entry;
+}
+}  // namespace
+
+StringEncoding::Type StringRefHelper::encoding(StringRef* str) {
+  auto bufferData = str->stringBufferAccessData();
+
+  if (auto entry = lookupStringEncoding(str, bufferData)) {
+    return entry->type;
+  }
+
+  if (bufferData.has8BitContent) {
+    return StringEncoding::classify(
+        reinterpret_cast<const uint8_t*>(bufferData.buffer), bufferData.length);
+  }
+  return StringEncoding::classify(
+      reinterpret_cast<const char16_t*>(bufferData.buffer), bufferData.length);
+}
+
+size_t StringRefHelper::utf8Length(StringRef* str) {
+  auto bufferData = str->stringBufferAccessData();
+
+  if (auto entry = lookupStringEncoding(str, bufferData)) {
+    return entry->utf8Length;
+  }
+
+  if (bufferData.has8BitContent) {
+    return UTF8Encoder::length(
+        reinterpret_cast<const uint8_t*>(bufferData.buffer), bufferData.length);
   }
+  return UTF8Encoder::length(
+      reinterpret_cast<const char16_t*>(bufferData.buffer), bufferData.length);
+}
 
-  return isAscii;
+bool StringRefHelper::isAsciiString(StringRef* string) {
+  // NOTE: a 16-bit string isn't regarded as ASCII whatever its content is
+  if (!string->has8BitContent()) {
+    return false;
+  }
+  return encoding(string) == StringEncoding::kAscii;
 }
 
 bool StringRefHelper::isOneByteString(StringRef* str) {
+  return StringEncoding::isOneByte(encoding(str));
+}
+
+// --- IdentityHashHelper ---
+
+int IdentityHashHelper::fromAddress(const void* address) {
+  // the finalizer of splitmix64 spreads the aligned address bits
+  uint64_t x = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(address));
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  x = x ^ (x >> 31);
+  return fromHash(static_cast<size_t>(x));
+}
+
+int IdentityHashHelper::fromHash(size_t hash) {
+  uint64_t x = static_cast<uint64_t>(hash);
+  uint32_t h = static_cast<uint32_t>(x ^ (x >> 32)) & kHashMask;
+  return (h == 0) ? 1 : static_cast<int>(h);
+}
+
+size_t StringRefHelper::hash(StringRef* str) {
   auto bufferData = str->stringBufferAccessData();
 
-  for (size_t i = 0; i < bufferData.length; i++) {
-    char16_t c = bufferData.charAt(i);
-    if (c > 255) {  // including all 8 bit code
-      return false;
+  // FNV-1a over code units
+  size_t hash = 2166136261u;
+  if (bufferData.has8BitContent) {
+    auto buffer = reinterpret_cast<const uint8_t*>(bufferData.buffer);
+    for (size_t i = 0; i < bufferData.length; i++) {
+      hash = (hash ^ buffer[i]) * 16777619u;
+    }
+  } else {
+    auto buffer = reinterpret_cast<const char16_t*>(bufferData.buffer);
+    for (size_t i = 0; i < bufferData.length; i++) {
+      hash = (hash ^ buffer[i]) * 16777619u;
     }
   }
-
-  return true;
+  return hash;
 }
 
 }  // namespace EscargotShim
@@ -17,8 +17,10 @@
 #pragma once
 
 #include <EscargotPublic.h>
+#include <utility>
 #include "extra-data.h"
 #include "utils/gc-util.h"
+#include "utils/string-util.h"
 
 using namespace Escargot;
 
@@ -52,6 +54,30 @@ typedef FunctionObjectRef::NativeFunctionPointer NativeFunctionPointer;
 typedef FunctionObjectRef::NativeFunctionInfo NativeFunctionInfo;
 typedef ValueWrap InternalField;
 
+// Evaluator::execute() runs a closure on a new root execution state in a
+// sandbox that catches the exceptions thrown in it. When the API is called
+// from a native callback, e.g. to read the properties of an argument, the
+// callback's state is still on the stack. execute() runs the closure on a
+// child of that state instead, so nested API calls don't set up a root state
+// per operation and the stack depth is checked against the whole call chain.
+// The closure still runs in a sandbox, so its exceptions are reported in the
+// result and reach a v8::TryCatch as before.
+class EvalHelper {
+ public:
+  template <typename F, typename... Args>
+  static EvalResult execute(ContextRef* context, F&& closure, Args... args) {
+    auto state = currentExecutionState(context);
+    if (state) {
+      return Evaluator::execute(state, std::forward<F>(closure), args...);
+    }
+    return Evaluator::execute(context, std::forward<F>(closure), args...);
+  }
+
+  // Returns the state of the innermost native callback if it runs on
+  // |context|.
+  static ExecutionStateRef* currentExecutionState(ContextRef* context);
+};
+
 class ObjectRefHelper {
  public:
   static ObjectRef* create(ContextRef* context);
@@ -262,11 +288,11 @@ class ArrayBufferHelper {
 
   template <class T>
   static ArrayBufferViewRef* createView(ContextRef* context,
-                                        ArrayBufferObjectRef* abo,
+                                        ArrayBufferRef* buffer,
                                         size_t byteOffset,
                                         size_t arrayLength,
                                         ArrayType type) {
-    EvalResult r = Evaluator::execute(
+    EvalResult r = EvalHelper::execute(
         context,
         [](ExecutionStateRef* state) -> ValueRef* { return T::create(state); });
 
@@ -303,7 +329,7 @@ class ArrayBufferHelper {
     auto arrayBufferView = r.result->asArrayBufferView();
 
     arrayBufferView->setBuffer(
-        abo, byteOffset, byteSize * arrayLength, arrayLength);
+        buffer, byteOffset, byteSize * arrayLength, arrayLength);
 
     return arrayBufferView;
   }
@@ -347,6 +373,26 @@ class StringRefHelper {
 
   static bool isAsciiString(StringRef* str);
   static bool isOneByteString(StringRef* str);
+  // Returns the narrowest encoding of the string content. The result for a
+  // long string is memoized along with its UTF-8 length, so a string that is
+  // measured and then written isn't scanned twice.
+  static StringEncoding::Type encoding(StringRef* str);
+  static size_t utf8Length(StringRef* str);
+  // Returns a hash of the string content. Strings that are equal have the
+  // same hash whether they are stored in 8-bit or 16-bit.
+  static size_t hash(StringRef* str);
+};
+
+// Identity hashes are positive and never 0, like V8's. GC objects don't move,
+// so a hash computed from the address of an object is stable for its
+// lifetime and needs no per-object storage.
+class IdentityHashHelper {
+ public:
+  static int fromAddress(const void* address);
+  static int fromHash(size_t hash);
+
+ private:
+  static constexpr uint32_t kHashMask = (1u << 30) - 1;
 };
 
 }  // namespace EscargotShim
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2021-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "external-string.h"
+
+#include <algorithm>
+
+#include "utils/gc-util.h"
+#include "utils/misc.h"
+
+using namespace Escargot;
+
+namespace EscargotShim {
+
+ExternalStringRegistry* ExternalStringRegistry::instance() {
+  // never freed since finalizers may run until the process exits
+  static ExternalStringRegistry* s_instance = new ExternalStringRegistry();
+  return s_instance;
+}
+
+void ExternalStringRegistry::add(IsolateWrap* isolate,
+                                 StringRef* string,
+                                 Resource* resource,
+                                 size_t bytes) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto result = entries_.emplace(string, Entry{isolate, resource, bytes});
+    LWNODE_CHECK(result.second);
+    bytesByIsolate_[isolate] += bytes;
+    totalBytes_ += bytes;
+  }
+
+  // Escargot doesn't bind a finalizer to a string.
+  MemoryUtil::gcRegisterFinalizer(
+      string, ExternalStringRegistry::onStringFinalized, this);
+}
+
+ExternalStringRegistry::Resource* ExternalStringRegistry::find(
+    StringRef* string) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr = entries_.find(string);
+  return (itr != entries_.end()) ? itr->second.resource : nullptr;
+}
+
+void ExternalStringRegistry::onStringFinalized(void* string, void* self) {
+  auto registry = reinterpret_cast<ExternalStringRegistry*>(self);
+  std::lock_guard<std::mutex> lock(registry->mutex_);
+  auto itr = registry->entries_.find(reinterpret_cast<StringRef*>(string));
+  // the resource was disposed with its isolate
+  if (itr == registry->entries_.end()) {
+    return;
+  }
+  registry->pendingEntries_.push_back(itr->second);
+  registry->pendingCount_++;
+  registry->entries_.erase(itr);
+}
+
+void ExternalStringRegistry::disposePending(IsolateWrap* isolate) {
+  // called on every iteration of the message loop
+  if (pendingCount_ == 0) {
+    return;
+  }
+
+  std::vector<Resource*> resources;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    takePendingIf(
+        [isolate](const Entry& entry) { return entry.isolate == isolate; },
+        resources);
+  }
+
+  for (auto resource : resources) {
+    resource->Dispose();
+  }
+}
+
+void ExternalStringRegistry::dispose(IsolateWrap* isolate) {
+  disposeIf([isolate](const Entry& entry) { return entry.isolate == isolate; });
+}
+
+void ExternalStringRegistry::disposeAll() {
+  disposeIf([](const Entry& entry) { return true; });
+}
+
+template <typename Predicate>
+void ExternalStringRegistry::takePendingIf(Predicate predicate,
+                                           std::vector<Resource*>& resources) {
+  auto end = std::remove_if(
+      pendingEntries_.begin(),
+      pendingEntries_.end(),
+      [&](const Entry& entry) {
+        if (!predicate(entry)) {
+          return false;
+        }
+        resources.push_back(entry.resource);
+        subtract(entry);
+        return true;
+      });
+  pendingCount_ -= pendingEntries_.end() - end;
+  pendingEntries_.erase(end, pendingEntries_.end());
+}
+
+template <typename Predicate>
+void ExternalStringRegistry::disposeIf(Predicate predicate) {
+  std::vector<Resource*> resources;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    takePendingIf(predicate, resources);
+    for (auto itr = entries_.begin(); itr != entries_.end();) {
+      if (predicate(itr->second)) {
+        resources.push_back(itr->second.resource);
+        subtract(itr->second);
+        itr = entries_.erase(itr);
+      } else {
+        ++itr;
+      }
+    }
+  }
+
+  // the resources may run the code of the embedder, so they are disposed
+  // without the lock
+  for (auto resource : resources) {
+    resource->Dispose();
+  }
+}
+
+size_t ExternalStringRegistry::bytes(IsolateWrap* isolate) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr = bytesByIsolate_.find(isolate);
+  return (itr != bytesByIsolate_.end()) ? itr->second : 0;
+}
+
+size_t ExternalStringRegistry::totalBytes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return totalBytes_;
+}
+
+void ExternalStringRegistry::subtract(const Entry& entry) {
+  auto itr = bytesByIsolate_.find(entry.isolate);
+  if (itr->second == entry.bytes) {
+    bytesByIsolate_.erase(itr);
+  } else {
+    itr->second -= entry.bytes;
+  }
+  totalBytes_ -= entry.bytes;
+}
+
+}  // namespace EscargotShim
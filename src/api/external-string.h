@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2021-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <EscargotPublic.h>
+#include <v8.h>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace EscargotShim {
+
+class IsolateWrap;
+
+// Keeps the resources of the external strings. When a string is collected,
+// its resource is queued by a GC finalizer and disposed later with the
+// pending finalizers of the isolate which created the string, since a
+// resource may run the code of the embedder, which can't be done inside the
+// collector. The resources left are disposed with the isolate.
+//
+// The collector may run finalizers on any thread, so the registry is shared
+// by the isolates and locked. Its maps live in malloc memory, which the
+// collector doesn't scan, so the strings are held weakly.
+class ExternalStringRegistry {
+ public:
+  typedef v8::String::ExternalStringResourceBase Resource;
+
+  static ExternalStringRegistry* instance();
+
+  // |string| should be an external string on the content of |resource|.
+  void add(IsolateWrap* isolate,
+           Escargot::StringRef* string,
+           Resource* resource,
+           size_t bytes);
+  Resource* find(Escargot::StringRef* string);
+
+  // Disposes the resources of the collected strings of |isolate|.
+  void disposePending(IsolateWrap* isolate);
+  // Disposes the resources of the strings created by |isolate|.
+  void dispose(IsolateWrap* isolate);
+  void disposeAll();
+
+  // The size of the contents of the external strings created by |isolate|.
+  size_t bytes(IsolateWrap* isolate);
+  size_t totalBytes();
+
+ private:
+  struct Entry {
+    IsolateWrap* isolate;
+    Resource* resource;
+    size_t bytes;
+  };
+
+  ExternalStringRegistry() = default;
+
+  static void onStringFinalized(void* string, void* self);
+
+  // Takes the resources of the pending entries which satisfy |predicate|.
+  // The lock should be held.
+  template <typename Predicate>
+  void takePendingIf(Predicate predicate, std::vector<Resource*>& resources);
+  template <typename Predicate>
+  void disposeIf(Predicate predicate);
+  void subtract(const Entry& entry);
+
+  std::mutex mutex_;
+  std::unordered_map<Escargot::StringRef*, Entry> entries_;
+  // the entries of the collected strings, whose resources aren't disposed
+  std::vector<Entry> pendingEntries_;
+  std::atomic<size_t> pendingCount_{0};
+  std::unordered_map<IsolateWrap*, size_t> bytesByIsolate_;
+  size_t totalBytes_ = 0;
+};
+
+}  // namespace EscargotShim
@@ -22,12 +22,58 @@
 #include "utils/misc.h"
 #include "v8.h"
 
+#include <algorithm>
+
 using namespace Escargot;
 
 namespace EscargotShim {
 
-bool InternalFieldData::isValidIndex(int idx) {
-  return 0 <= idx && idx < internalFieldCount();
+ValueRef* ExtraData::getPrivate(ValueRef* key) {
+  if (privateValues_ == nullptr) {
+    return nullptr;
+  }
+  for (const auto& it : *privateValues_) {
+    if (it.key == key) {
+      return it.value;
+    }
+  }
+  return nullptr;
+}
+
+void ExtraData::setPrivate(ValueRef* key, ValueRef* value) {
+  if (privateValues_ == nullptr) {
+    privateValues_ = new GCVector<PrivateValue>();
+  }
+  for (auto& it : *privateValues_) {
+    if (it.key == key) {
+      it.value = value;
+      return;
+    }
+  }
+  privateValues_->push_back(PrivateValue{key, value});
+}
+
+bool ExtraData::deletePrivate(ValueRef* key) {
+  if (privateValues_ == nullptr) {
+    return false;
+  }
+  for (size_t i = 0; i < privateValues_->size(); i++) {
+    if ((*privateValues_)[i].key == key) {
+      privateValues_->erase(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ExtraData::takePrivateValues(ExtraData* other) {
+  if (other == nullptr || other == this || other->privateValues_ == nullptr) {
+    return;
+  }
+  for (const auto& it : *other->privateValues_) {
+    setPrivate(it.key, it.value);
+  }
+  other->privateValues_ = nullptr;
 }
 
 static std::string toObjectDataString(const ObjectData* data,
@@ -49,13 +95,6 @@ static std::string toObjectDataString(const ObjectData* data,
 ObjectData::ObjectData(FunctionObjectRef* functionObject)
     : TemplateData(), functionObject_(functionObject) {}
 
-int InternalFieldData::internalFieldCount() {
-  if (internalFields_ == nullptr) {
-    return 0;
-  }
-  return internalFields_->size();
-}
-
 void InternalFieldData::setInternalFieldCount(int size) {
   LWNODE_CALL_TRACE_ID(OBJDATA, "%d", size);
 
@@ -66,45 +105,19 @@ void InternalFieldData::setInternalFieldCount(int size) {
     return;
   }
 
-  internalFields_ = new GCContainer<void*>(size);
-  for (int i = 0; i < size; i++) {
-    setInternalField(i, nullptr);
-  }
+  setInternalFieldStorage(
+      reinterpret_cast<void**>(Memory::gcMalloc(sizeof(void*) * size)), size);
 }
 
-void InternalFieldData::setInternalField(int idx, void* lwValue) {
-  LWNODE_CHECK_NOT_NULL(internalFields_);
-  if (!isValidIndex(idx)) {
-    auto lwIsolate = IsolateWrap::GetCurrent();
-    lwIsolate->onFatalError("InternalFieldData::setInternalField",
-                            "Internal field out of bounds");
-    return;
-  }
-
-  // TODO: Update type
-  // LWNODE_CALL_TRACE_ID(
-  //     OBJDATA, "%s", toObjectDataString(this, idx, lwValue).c_str());
-
-  internalFields_->set(idx, lwValue);
+void InternalFieldData::setInternalFieldStorage(void** fields, int count) {
+  std::fill(fields, fields + count, nullptr);
+  internalFields_ = fields;
+  internalFieldCount_ = count;
 }
 
-void* InternalFieldData::internalField(int idx) {
-  LWNODE_CHECK_NOT_NULL(internalFields_);
-  if (!isValidIndex(idx)) {
-    auto lwIsolate = IsolateWrap::GetCurrent();
-    lwIsolate->onFatalError("InternalFieldData::internalField",
-                            "Internal field out of bounds");
-    return nullptr;
-  }
-
-  void* field = internalFields_->get(idx);
-  if (field) {
-    // TODO: Update type
-    // LWNODE_CALL_TRACE_ID(
-    //     OBJDATA, "%s", toObjectDataString(this, idx, field).c_str());
-  }
-
-  return field;
+void InternalFieldData::onInvalidIndex(const char* location) {
+  auto lwIsolate = IsolateWrap::GetCurrent();
+  lwIsolate->onFatalError(location, "Internal field out of bounds");
 }
 
 ObjectData::ObjectData(ObjectTemplateRef* objectTemplate)
@@ -112,9 +125,24 @@ ObjectData::ObjectData(ObjectTemplateRef* objectTemplate)
                        ->functionTemplate()),
       objectTemplate_(objectTemplate) {}
 
+ObjectData* ObjectData::create(ObjectTemplateRef* objectTemplate,
+                               int internalFieldCount) {
+  if (internalFieldCount <= 0) {
+    return new ObjectData(objectTemplate);
+  }
+
+  auto memory = Memory::gcMalloc(sizeof(ObjectData) +
+                                 sizeof(void*) * internalFieldCount);
+  auto data = new (memory) ObjectData(objectTemplate);
+  data->setInternalFieldStorage(reinterpret_cast<void**>(data + 1),
+                                internalFieldCount);
+  return data;
+}
+
 ObjectData* ObjectTemplateData::createObjectData(
     ObjectTemplateRef* objectTemplate) {
-  auto newData = new ObjectData(objectTemplate);
+  auto count = internalFieldCount();
+  auto newData = ObjectData::create(objectTemplate, count);
 
   LWNODE_CALL_TRACE_ID_LOG(EXTRADATA,
                            "ObjectTemplateData(%p)::createObjectData: %p",
@@ -124,10 +152,6 @@ ObjectData* ObjectTemplateData::createObjectData(
   LWNODE_CALL_TRACE_ID(OBJDATA, "%p clone: %p", this, newData);
 
   // copy internalField
-  auto count = internalFieldCount();
-  if (count > 0) {
-    newData->setInternalFieldCount(count);
-  }
   for (int i = 0; i < count; i++) {
     LWNODE_DCHECK(internalField(i) == nullptr);
     newData->setInternalField(i, internalField(i));
@@ -136,41 +160,44 @@ ObjectData* ObjectTemplateData::createObjectData(
   return newData;
 }
 
-v8::Isolate* FunctionData::isolate() {
+FunctionData::FunctionData(FunctionTemplateRef* functionTemplate)
+    : ObjectData(functionTemplate) {
   if (functionTemplate_) {
-    auto functionTemplateData =
+    functionTemplateData_ =
         ExtraDataHelper::getFunctionTemplateExtraData(functionTemplate_);
-    return functionTemplateData->isolate();
+  }
+  if (functionTemplateData_ && functionTemplateData_->signature()) {
+    signatureTemplate_ = CVAL(functionTemplateData_->signature())->ftpl();
+  }
+}
+
+v8::Isolate* FunctionData::isolate() {
+  if (functionTemplateData_) {
+    return functionTemplateData_->isolate();
   }
 
   return nullptr;
 }
 
 v8::FunctionCallback FunctionData::callback() {
-  if (functionTemplate_) {
-    auto functionTemplateData =
-        ExtraDataHelper::getFunctionTemplateExtraData(functionTemplate_);
-    return functionTemplateData->callback();
+  if (functionTemplateData_) {
+    return functionTemplateData_->callback();
   }
 
   return v8::FunctionCallback();
 }
 
 v8::Value* FunctionData::callbackData() {
-  if (functionTemplate_) {
-    auto functionTemplateData =
-        ExtraDataHelper::getFunctionTemplateExtraData(functionTemplate_);
-    return functionTemplateData->callbackData();
+  if (functionTemplateData_) {
+    return functionTemplateData_->callbackData();
   }
 
   return nullptr;
 }
 
 v8::Signature* FunctionData::signature() {
-  if (functionTemplate_) {
-    auto functionTemplateData =
-        ExtraDataHelper::getFunctionTemplateExtraData(functionTemplate_);
-    return functionTemplateData->signature();
+  if (functionTemplateData_) {
+    return functionTemplateData_->signature();
   }
 
   return nullptr;
@@ -182,13 +209,10 @@ v8::Signature* FunctionData::signature() {
 //  signature's FunctionTemplate.
 bool FunctionData::checkSignature(Escargot::ExecutionStateRef* state,
                                   ObjectRef* receiver) {
-  auto calleeSignature = signature();
-  if (calleeSignature == nullptr) {
+  if (signatureTemplate_ == nullptr) {
     return true;
   }
 
-  auto esContext = state->context();
-
   // e.g., 1.x();
   // 1 is not created by FunctionTemplate
   auto extraData = ExtraDataHelper::getExtraData(receiver);
@@ -206,9 +230,16 @@ bool FunctionData::checkSignature(Escargot::ExecutionStateRef* state,
     LWNODE_CHECK(false);
   }
 
-  auto calleeFunctionTemplate = CVAL(calleeSignature)->ftpl();
+  // Like V8, templates aren't expected to inherit from others once their
+  // functions are instantiated, so an accepted template stays accepted.
+  if (functionTemplate != nullptr &&
+      functionTemplate == lastAcceptedTemplate_) {
+    return true;
+  }
+
   for (auto p = functionTemplate; p; p = p->parent().value()) {
-    if (p == calleeFunctionTemplate) {
+    if (p == signatureTemplate_) {
+      lastAcceptedTemplate_ = functionTemplate;
       return true;
     }
   }
@@ -92,6 +92,23 @@ class ExtraData : public gc {
     LWNODE_CHECK(isStackTraceData());
     return reinterpret_cast<StackTraceData*>(this);
   }
+
+  // v8::Private values of the object owning this extra data. Returns nullptr
+  // if the key isn't found.
+  ValueRef* getPrivate(ValueRef* key);
+  void setPrivate(ValueRef* key, ValueRef* value);
+  bool deletePrivate(ValueRef* key);
+  // Used when the extra data of an object is replaced.
+  void takePrivateValues(ExtraData* other);
+
+ private:
+  struct PrivateValue {
+    ValueRef* key;
+    ValueRef* value;
+  };
+
+  // Objects hold a few private values at most, so they are searched linearly.
+  GCVector<PrivateValue>* privateValues_{nullptr};
 };
 
 class InternalFieldData : public ExtraData {
@@ -100,14 +117,40 @@ class InternalFieldData : public ExtraData {
   InternalFieldData(int count) { setInternalFieldCount(count); }
   bool isInternalFieldData() const override { return true; }
 
-  virtual int internalFieldCount();
-  virtual void setInternalFieldCount(int size);
-  virtual void* internalField(int idx);
-  virtual void setInternalField(int idx, void* lwValue);
+  // Internal fields are read on every unwrap of an embedder object, so the
+  // accessors are non-virtual and inlined.
+  int internalFieldCount() const { return internalFieldCount_; }
+  void setInternalFieldCount(int size);
+
+  void* internalField(int idx) {
+    if (LWNODE_UNLIKELY(!isValidIndex(idx))) {
+      onInvalidIndex("InternalFieldData::internalField");
+      return nullptr;
+    }
+    return internalFields_[idx];
+  }
+
+  void setInternalField(int idx, void* lwValue) {
+    if (LWNODE_UNLIKELY(!isValidIndex(idx))) {
+      onInvalidIndex("InternalFieldData::setInternalField");
+      return;
+    }
+    internalFields_[idx] = lwValue;
+  }
+
+ protected:
+  // Makes the given GC memory, e.g. slots allocated right after this object,
+  // the storage of the fields.
+  void setInternalFieldStorage(void** fields, int count);
 
  private:
-  bool isValidIndex(int idx);
-  GCContainer<void*>* internalFields_{nullptr};
+  bool isValidIndex(int idx) const {
+    return 0 <= idx && idx < internalFieldCount_;
+  }
+  static void onInvalidIndex(const char* location);
+
+  void** internalFields_{nullptr};
+  int internalFieldCount_{0};
 };
 
 class TemplateData : public InternalFieldData {
@@ -177,6 +220,11 @@ class ObjectData : public TemplateData {
   ObjectData(FunctionObjectRef* functionObject);
   ObjectData(ObjectTemplateRef* objectTemplate);
 
+  // Creates an ObjectData whose internal fields are placed right after it in
+  // a single allocation.
+  static ObjectData* create(ObjectTemplateRef* objectTemplate,
+                            int internalFieldCount);
+
   bool isObjectData() const override { return true; }
 
   void setFunctionObject(FunctionObjectRef* functionObject) {
@@ -192,13 +240,18 @@ class ObjectData : public TemplateData {
   FunctionObjectRef* functionObject_{nullptr};
 };
 
+// The dispatch data of a function created from a FunctionTemplate. It is
+// created once per function, by FunctionTemplate::GetFunction() or on the
+// first call, and read on every call of the function.
 class FunctionData : public ObjectData {
  public:
-  FunctionData(FunctionTemplateRef* functionTemplate)
-      : ObjectData(functionTemplate) {}
+  FunctionData(FunctionTemplateRef* functionTemplate);
 
   bool isFunctionData() const override { return true; }
 
+  // The callback and its data can be changed after the function is created
+  // (see FunctionTemplate::SetCallHandler), so they are read through the
+  // template data.
   v8::Isolate* isolate();
   v8::FunctionCallback callback();
   v8::Value* callbackData();
@@ -209,6 +262,14 @@ class FunctionData : public ObjectData {
 
  private:
   FunctionData() = default;
+
+  FunctionTemplateData* functionTemplateData_{nullptr};
+  // the FunctionTemplate of the signature, if any
+  FunctionTemplateRef* signatureTemplate_{nullptr};
+  // The last receiver template that matched the signature. Methods are
+  // mostly called on instances of one template, so this saves walking the
+  // template chain on most calls.
+  FunctionTemplateRef* lastAcceptedTemplate_{nullptr};
 };
 
 class ExternalObjectData : public ObjectData {
@@ -34,22 +34,28 @@ FunctionCallbackInfoWrap::FunctionCallbackInfoWrap(
     ValueRef** argv)
     : v8::FunctionCallbackInfo<v8::Value>(
           ToAddress(m_implicitArgs),
-          ToAddress(toWrapperArgs(thisValue, argc, argv)),
+          ToAddress(toWrapperArgs(
+              IsolateWrap::fromV8(isolate), thisValue, argc, argv)),
           argc) {
   auto lwIsolate = IsolateWrap::fromV8(isolate);
+  auto arena = lwIsolate->handleArena();
 
-  m_implicitArgs[T::kHolderIndex] = ValueWrap::createValue(holder);
+  m_implicitArgs[T::kHolderIndex] =
+      (holder == thisValue) ? m_args[argc] : arena->addValue(holder);
   m_implicitArgs[T::kIsolateIndex] = reinterpret_cast<HandleWrap*>(isolate);
   m_implicitArgs[T::kReturnValueDefaultValueIndex] =
       lwIsolate->undefined_value();
   m_implicitArgs[T::kReturnValueIndex] = lwIsolate->defaultReturnValue();
   m_implicitArgs[T::kDataIndex] = data;
   m_implicitArgs[T::kNewTargetIndex] =
-      newTarget.hasValue() ? ValueWrap::createValue(newTarget.get())
+      newTarget.hasValue() ? arena->addValue(newTarget.get())
                            : lwIsolate->undefined_value();
+
+  lwIsolate->pushReturnValueSlot(&m_implicitArgs[T::kReturnValueIndex]);
 }
 
-HandleWrap** FunctionCallbackInfoWrap::toWrapperArgs(ValueRef* thisValue,
+HandleWrap** FunctionCallbackInfoWrap::toWrapperArgs(IsolateWrap* lwIsolate,
+                                                     ValueRef* thisValue,
                                                      int argc,
                                                      ValueRef** argv) {
   /*
@@ -69,9 +75,12 @@ HandleWrap** FunctionCallbackInfoWrap::toWrapperArgs(ValueRef* thisValue,
       string1 // the beginning of the arguments array
   */
 
-  m_args =
-      reinterpret_cast<HandleWrap**>(Escargot::Memory::gcMallocUncollectable(
-          sizeof(HandleWrap*) * (argc + 1)));
+  // The wrappers are kept alive by the handle arena, so the array itself
+  // needn't be traced.
+  m_args = (argc <= kInlineArgsLength) ? m_inlineArgs
+                                       : new HandleWrap*[argc + 1];
+
+  auto arena = lwIsolate->handleArena();
 
 #ifdef V8_REVERSE_JSARGS
 #error "Not implement V8_REVERSE_JSARGS"
@@ -80,18 +89,21 @@ HandleWrap** FunctionCallbackInfoWrap::toWrapperArgs(ValueRef* thisValue,
   const int idx_this = argc;
 
   for (int i = 0; i < argc; i++) {
-    m_args[idx_end - i] = ValueWrap::createValue(argv[i]);
+    m_args[idx_end - i] = arena->addValue(argv[i]);
   }
 
-  m_args[idx_this] = ValueWrap::createValue(thisValue);
+  m_args[idx_this] = arena->addValue(thisValue);
 
   return m_args + idx_end;
 #endif
 }
 
 FunctionCallbackInfoWrap::~FunctionCallbackInfoWrap() {
-  if (m_args) {
-    Escargot::Memory::gcFree(m_args);
+  IsolateWrap::fromV8(GetIsolate())
+      ->popReturnValueSlot(&m_implicitArgs[T::kReturnValueIndex]);
+
+  if (m_args != m_inlineArgs) {
+    delete[] m_args;
   }
 }
 
@@ -108,15 +120,28 @@ PropertyCallbackInfoWrap<T>::PropertyCallbackInfoWrap(v8::Isolate* isolate,
                                                       ValueRef* thisValue,
                                                       ValueWrap* data)
     : v8::PropertyCallbackInfo<T>(
-          reinterpret_cast<v8::internal::Address*>(m_implicitArgs)) {
+          reinterpret_cast<v8::internal::Address*>(m_implicitArgs)),
+      m_handleScope(IsolateWrap::fromV8(isolate)) {
   auto lwIsolate = IsolateWrap::fromV8(isolate);
+  auto arena = lwIsolate->handleArena();
   // m_implicitArgs[F::kShouldThrowOnErrorIndex]; // TODO
-  m_implicitArgs[F::kHolderIndex] = ValueWrap::createValue(holder);
+  m_implicitArgs[F::kHolderIndex] = arena->addValue(holder);
   m_implicitArgs[F::kIsolateIndex] = reinterpret_cast<HandleWrap*>(isolate);
   // m_implicitArgs[F::kReturnValueDefaultValueIndex]; // TODO
   m_implicitArgs[F::kReturnValueIndex] = lwIsolate->defaultReturnValue();
   m_implicitArgs[F::kDataIndex] = data;
-  m_implicitArgs[F::kThisIndex] = ValueWrap::createValue(thisValue);
+  m_implicitArgs[F::kThisIndex] = (holder == thisValue)
+                                      ? m_implicitArgs[F::kHolderIndex]
+                                      : arena->addValue(thisValue);
+
+  lwIsolate->pushReturnValueSlot(&m_implicitArgs[F::kReturnValueIndex]);
+}
+
+template <typename T>
+PropertyCallbackInfoWrap<T>::~PropertyCallbackInfoWrap() {
+  auto lwIsolate =
+      reinterpret_cast<IsolateWrap*>(m_implicitArgs[F::kIsolateIndex]);
+  lwIsolate->popReturnValueSlot(&m_implicitArgs[F::kReturnValueIndex]);
 }
 
 template <typename T>
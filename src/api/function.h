@@ -19,11 +19,19 @@
 #include <EscargotPublic.h>
 #include <v8.h>
 #include "handle.h"
+#include "handlescope.h"
 
 using namespace Escargot;
 
 namespace EscargotShim {
 
+class IsolateWrap;
+
+// The wrappers of callback arguments are allocated in the handle arena of the
+// current handle scope, so creating a callback info doesn't allocate on the
+// GC heap. FunctionCallbackInfoWrap should be created in a handle scope of
+// the callback (see runNativeFunctionCallback), while PropertyCallbackInfoWrap
+// opens its own scope.
 class FunctionCallbackInfoWrap : public v8::FunctionCallbackInfo<v8::Value> {
  public:
   using T = v8::FunctionCallbackInfo<v8::Value>;
@@ -37,10 +45,18 @@ class FunctionCallbackInfoWrap : public v8::FunctionCallbackInfo<v8::Value> {
                            ValueRef** argv);
   ~FunctionCallbackInfoWrap();
 
-  HandleWrap** toWrapperArgs(ValueRef* thisValue, int argc, ValueRef** argv);
+  static constexpr int kInlineArgsLength = 8;
 
  private:
+  HandleWrap** toWrapperArgs(IsolateWrap* lwIsolate,
+                             ValueRef* thisValue,
+                             int argc,
+                             ValueRef** argv);
+
+  // NOTE: these are set by toWrapperArgs() before the members are
+  // initialized, so they shouldn't have default member initializers.
   HandleWrap** m_args;
+  HandleWrap* m_inlineArgs[kInlineArgsLength + 1];
   HandleWrap* m_implicitArgs[T::kArgsLength];
 };
 
@@ -53,10 +69,12 @@ class PropertyCallbackInfoWrap : public v8::PropertyCallbackInfo<T> {
                            ValueRef* holder,
                            ValueRef* thisValue,
                            ValueWrap* data);
+  ~PropertyCallbackInfoWrap();
 
   bool hasReturnValue();
 
  private:
+  HandleScopeWrapGuard m_handleScope;
   HandleWrap* m_implicitArgs[F::kArgsLength];
 };
 
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2021-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gc-event-tracker.h"
+
+#include <EscargotPublic.h>
+#include <algorithm>
+#include <chrono>
+
+#include "api/global.h"
+#include "isolate.h"
+
+using namespace Escargot;
+
+namespace EscargotShim {
+
+static uint64_t nowMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// The events are sent with the allocation lock held, so this reads the
+// counters without taking the lock.
+static size_t heapUsedBytes() {
+  GC_prof_stats_s stats;
+  GC_get_prof_stats_unsafe(&stats, sizeof(stats));
+  return stats.heapsize_full - stats.free_bytes_full - stats.unmapped_bytes;
+}
+
+// --- R e a s o n S c o p e ---
+
+GCEventTracker::ReasonScope::ReasonScope(v8::Isolate* isolate, Reason reason) {
+  if (isolate) {
+    tracker_ = IsolateWrap::fromV8(isolate)->gcEventTracker();
+  }
+  if (tracker_) {
+    previous_ = tracker_->reason_;
+    tracker_->reason_ = reason;
+  }
+}
+
+GCEventTracker::ReasonScope::~ReasonScope() {
+  if (tracker_) {
+    tracker_->reason_ = previous_;
+  }
+}
+
+// --- G C E v e n t T r a c k e r ---
+
+GCEventTracker::GCEventTracker(v8::Isolate* isolate) : isolate_(isolate) {
+  Memory::addGCEventListener(
+      Memory::GCEventType::MARK_START, GCEventTracker::onMarkStart, this);
+  Memory::addGCEventListener(
+      Memory::GCEventType::RECLAIM_END, GCEventTracker::onReclaimEnd, this);
+}
+
+GCEventTracker::~GCEventTracker() {
+  Memory::removeGCEventListener(
+      Memory::GCEventType::MARK_START, GCEventTracker::onMarkStart, this);
+  Memory::removeGCEventListener(
+      Memory::GCEventType::RECLAIM_END, GCEventTracker::onReclaimEnd, this);
+}
+
+void GCEventTracker::addPrologueCallback(
+    v8::Isolate::GCCallbackWithData callback, void* data, v8::GCType gcType) {
+  prologueCallbacks_.push_back({callback, data, gcType});
+}
+
+void GCEventTracker::removePrologueCallback(
+    v8::Isolate::GCCallbackWithData callback, void* data) {
+  remove(prologueCallbacks_, callback, data);
+}
+
+void GCEventTracker::addEpilogueCallback(
+    v8::Isolate::GCCallbackWithData callback, void* data, v8::GCType gcType) {
+  epilogueCallbacks_.push_back({callback, data, gcType});
+}
+
+void GCEventTracker::removeEpilogueCallback(
+    v8::Isolate::GCCallbackWithData callback, void* data) {
+  remove(epilogueCallbacks_, callback, data);
+}
+
+void GCEventTracker::invokeCallbackWithoutData(v8::Isolate* isolate,
+                                               v8::GCType gcType,
+                                               v8::GCCallbackFlags flags,
+                                               void* data) {
+  reinterpret_cast<v8::Isolate::GCCallback>(data)(isolate, gcType, flags);
+}
+
+const char* GCEventTracker::reasonName(Reason reason) {
+  switch (reason) {
+    case Reason::kAllocation:
+      return "allocation";
+    case Reason::kIdle:
+      return "idle";
+    case Reason::kForced:
+      return "forced";
+    default:
+      break;
+  }
+  return "unknown";
+}
+
+size_t GCEventTracker::histogramBucket(uint64_t pauseMicros) {
+  size_t bucket = 0;
+  while (pauseMicros > 0 && bucket < kHistogramSize - 1) {
+    pauseMicros >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+void GCEventTracker::remove(CallbackList& list,
+                            v8::Isolate::GCCallbackWithData callback,
+                            void* data) {
+  auto it = std::find_if(
+      list.begin(), list.end(), [&](const CallbackEntry& entry) {
+        return entry.callback == callback && entry.data == data;
+      });
+  if (it != list.end()) {
+    list.erase(it);
+  }
+}
+
+v8::GCCallbackFlags GCEventTracker::callbackFlags() const {
+  switch (currentReason_) {
+    case Reason::kIdle:
+      return v8::kGCCallbackFlagCollectAllAvailableGarbage;
+    case Reason::kForced:
+      return v8::kGCCallbackFlagForced;
+    default:
+      break;
+  }
+  return v8::kNoGCCallbackFlags;
+}
+
+void GCEventTracker::invoke(const CallbackList& list) {
+  if (list.empty()) {
+    return;
+  }
+
+  // Boehm GC is a non-moving mark-sweep collector.
+  const v8::GCType gcType = v8::kGCTypeMarkSweepCompact;
+  const v8::GCCallbackFlags flags = callbackFlags();
+
+  // a callback may remove itself
+  CallbackList callbacks(list);
+  for (const auto& entry : callbacks) {
+    if (entry.gcType & gcType) {
+      entry.callback(isolate_, gcType, flags, entry.data);
+    }
+  }
+}
+
+void GCEventTracker::onMarkStart(void* self) {
+  auto tracker = reinterpret_cast<GCEventTracker*>(self);
+
+  tracker->inCollection_ = true;
+  tracker->currentReason_ = tracker->reason_;
+  tracker->usedBytesBeforeGC_ = heapUsedBytes();
+  tracker->invoke(tracker->prologueCallbacks_);
+  tracker->startMicros_ = nowMicros();
+}
+
+void GCEventTracker::onReclaimEnd(void* self) {
+  auto tracker = reinterpret_cast<GCEventTracker*>(self);
+
+  // the tracker was created during a collection
+  if (!tracker->inCollection_) {
+    return;
+  }
+
+  const uint64_t pauseMicros = nowMicros() - tracker->startMicros_;
+  const size_t usedBytes = heapUsedBytes();
+  const size_t usedBytesBeforeGC = tracker->usedBytesBeforeGC_;
+  const size_t reclaimedBytes =
+      usedBytesBeforeGC > usedBytes ? usedBytesBeforeGC - usedBytes : 0;
+
+  tracker->record(pauseMicros, reclaimedBytes);
+  IsolateWrap::fromV8(tracker->isolate_)->ResetExternalMemoryLimit();
+  tracker->invoke(tracker->epilogueCallbacks_);
+  tracker->inCollection_ = false;
+
+  if (Global::flags()->isOn(Flag::Type::TraceGC)) {
+    LWNODE_LOGR("#%zu Mark-sweep %.1f -> %.1f MB, %.3f ms: %s",
+                tracker->stats_.count,
+                usedBytesBeforeGC / 1048576.0,
+                usedBytes / 1048576.0,
+                pauseMicros / 1000.0,
+                reasonName(tracker->currentReason_));
+  }
+}
+
+void GCEventTracker::record(uint64_t pauseMicros, size_t reclaimedBytes) {
+  stats_.count++;
+  stats_.totalPauseMicros += pauseMicros;
+  stats_.maxPauseMicros = std::max(stats_.maxPauseMicros, pauseMicros);
+  stats_.lastPauseMicros = pauseMicros;
+  stats_.lastReclaimedBytes = reclaimedBytes;
+  stats_.totalReclaimedBytes += reclaimedBytes;
+  stats_.lastReason = currentReason_;
+  stats_.countByReason[static_cast<size_t>(currentReason_)]++;
+  stats_.histogram[histogramBucket(pauseMicros)]++;
+}
+
+}  // namespace EscargotShim
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2021-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <v8.h>
+#include <cstdint>
+#include <vector>
+
+namespace EscargotShim {
+
+// Follows the collections of the GC on the isolate's thread through the
+// Escargot GC events, runs the V8 GC prologue/epilogue callbacks around
+// them and keeps the statistics of the pauses.
+//
+// The collector holds its allocation lock while it sends the events, so the
+// callbacks must not allocate on the GC heap (e.g. create handles). Node's
+// callbacks (perf_hooks) only take timestamps and queue native tasks.
+class GCEventTracker {
+ public:
+  // Why a collection started. Collections not requested by lwnode are
+  // triggered by allocation.
+  enum class Reason : uint8_t {
+    kAllocation = 0,
+    kIdle,
+    kForced,
+    kCount,
+  };
+
+  // Bucket i counts the pauses in [2^(i-1), 2^i) microseconds, and the last
+  // bucket counts the longer ones.
+  static constexpr size_t kHistogramSize = 24;
+
+  struct Stats {
+    size_t count = 0;
+    uint64_t totalPauseMicros = 0;
+    uint64_t maxPauseMicros = 0;
+    uint64_t lastPauseMicros = 0;
+    size_t lastReclaimedBytes = 0;
+    size_t totalReclaimedBytes = 0;
+    Reason lastReason = Reason::kAllocation;
+    size_t countByReason[static_cast<size_t>(Reason::kCount)]{};
+    size_t histogram[kHistogramSize]{};
+  };
+
+  // Collections started while a scope is alive are reported with its reason.
+  class ReasonScope {
+   public:
+    ReasonScope(v8::Isolate* isolate, Reason reason);
+    ~ReasonScope();
+
+   private:
+    GCEventTracker* tracker_ = nullptr;
+    Reason previous_ = Reason::kAllocation;
+  };
+
+  explicit GCEventTracker(v8::Isolate* isolate);
+  ~GCEventTracker();
+
+  void addPrologueCallback(v8::Isolate::GCCallbackWithData callback,
+                           void* data,
+                           v8::GCType gcType);
+  void removePrologueCallback(v8::Isolate::GCCallbackWithData callback,
+                              void* data);
+  void addEpilogueCallback(v8::Isolate::GCCallbackWithData callback,
+                           void* data,
+                           v8::GCType gcType);
+  void removeEpilogueCallback(v8::Isolate::GCCallbackWithData callback,
+                              void* data);
+
+  // Adapts a v8::Isolate::GCCallback, which is passed as the data.
+  static void invokeCallbackWithoutData(v8::Isolate* isolate,
+                                        v8::GCType gcType,
+                                        v8::GCCallbackFlags flags,
+                                        void* data);
+
+  const Stats& stats() const { return stats_; }
+
+  static const char* reasonName(Reason reason);
+  static size_t histogramBucket(uint64_t pauseMicros);
+
+ private:
+  struct CallbackEntry {
+    v8::Isolate::GCCallbackWithData callback;
+    void* data;
+    v8::GCType gcType;
+  };
+
+  typedef std::vector<CallbackEntry> CallbackList;
+
+  static void onMarkStart(void* self);
+  static void onReclaimEnd(void* self);
+
+  static void remove(CallbackList& list,
+                     v8::Isolate::GCCallbackWithData callback,
+                     void* data);
+  void invoke(const CallbackList& list);
+  void record(uint64_t pauseMicros, size_t reclaimedBytes);
+
+  v8::GCCallbackFlags callbackFlags() const;
+
+  v8::Isolate* isolate_;
+  CallbackList prologueCallbacks_;
+  CallbackList epilogueCallbacks_;
+  Reason reason_ = Reason::kAllocation;
+  Reason currentReason_ = Reason::kAllocation;
+  uint64_t startMicros_ = 0;
+  size_t usedBytesBeforeGC_ = 0;
+  bool inCollection_ = false;
+  Stats stats_;
+};
+
+}  // namespace EscargotShim
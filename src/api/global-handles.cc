@@ -14,246 +14,462 @@
  * limitations under the License.
  */
 
+#include "global-handles.h"
+
 #include <EscargotPublic.h>
-#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <new>
 
+#include "api/external-string.h"
 #include "api/isolate.h"
 #include "base.h"
-#include "global-handles.h"
+#include "utils/compiler.h"
+#include "utils/gc-util.h"
+#include "utils/misc.h"
 
-#include "api/utils/gc-util.h"
+namespace EscargotShim {
 
-namespace v8 {
-namespace internal {
-void GlobalHandles::Destroy(EscargotShim::ValueWrap* lwValue) {
-  auto isolate = EscargotShim::IsolateWrap::GetCurrent();
-  if (isolate) {
-    isolate->global_handles()->destroy(lwValue);
+// A global handle. The location of a handle is the node itself, so the node
+// is laid out like the other handles. location_ holds the state of the node:
+// Local while it is free, and Strong, Weak or NearDeath while it is in use.
+class GlobalHandles::Node : public ValueWrap {
+ public:
+  Node() { storage_ = Storage::Global; }
+
+  uint8_t state() const { return location_; }
+  void setState(Location state) { location_ = state; }
+  bool isInUse() const { return location_ != Location::Local; }
+  // The collector clears the value of a weak node when the value dies.
+  bool isDead() const {
+    return location_ == Location::Weak && val_ == nullptr;
+  }
+  void* rawValue() const { return val_; }
+  void** valueSlot() { return &val_; }
+
+  void acquire(HandleWrap* value) { copy(value, Location::Local); }
+  void release() {
+    val_ = nullptr;
+    type_ = Type::NotPresent;
+    valueType_ = ValueType::None;
+    location_ = Location::Local;
+    parameter_ = nullptr;
+    callback_ = nullptr;
+  }
+  // A handle made strong again after its value died holds undefined.
+  void revive() {
+    LWNODE_CHECK(type_ == Type::JsValue);
+    val_ = Escargot::ValueRef::createUndefined();
   }
-}
 
-void GlobalHandles::MakeWeak(EscargotShim::ValueWrap* lwValue,
-                             void* parameter,
-                             v8::WeakCallbackInfo<void>::Callback callback) {
-  auto isolate = EscargotShim::IsolateWrap::GetCurrent();
-  isolate->global_handles()->makeWeak(lwValue, parameter, callback);
+  uint16_t index_{0};
+  void* parameter_{nullptr};
+  WeakCallback callback_{nullptr};
+  Node* nextFree_{nullptr};
+};
+
+// nodes_ should be the first field, so that the block of a node is found
+// from the index of the node.
+class GlobalHandles::NodeBlock {
+ public:
+  NodeBlock(GlobalHandles* owner, NodeBlock* next)
+      : owner_(owner), next_(next) {
+    // the values of strong nodes; the collector scans it as a root
+    roots_ = reinterpret_cast<void**>(
+        GC_MALLOC_UNCOLLECTABLE(sizeof(void*) * kBlockSize));
+    LWNODE_CHECK_NOT_NULL(roots_);
+    for (size_t i = 0; i < kBlockSize; i++) {
+      nodes_[i].index_ = static_cast<uint16_t>(i);
+    }
+  }
+
+  ~NodeBlock() { GC_FREE(roots_); }
+
+  static NodeBlock* from(Node* node) {
+    return reinterpret_cast<NodeBlock*>(node - node->index_);
+  }
+
+  Node nodes_[kBlockSize];
+  void** roots_{nullptr};
+  GlobalHandles* owner_{nullptr};
+  NodeBlock* next_{nullptr};
+  size_t weakNodes_{0};
+};
+
+// --- ProcessingHoldScope ---
+
+static THREAD_LOCAL size_t s_processingHoldDepth;
+
+GlobalHandles::ProcessingHoldScope::ProcessingHoldScope() {
+  s_processingHoldDepth++;
 }
 
-void* GlobalHandles::ClearWeakness(EscargotShim::ValueWrap* lwValue) {
-  auto isolate = EscargotShim::IsolateWrap::GetCurrent();
-  isolate->global_handles()->clearWeakness(lwValue);
-  return nullptr;
+GlobalHandles::ProcessingHoldScope::~ProcessingHoldScope() {
+  s_processingHoldDepth--;
 }
 
-}  // namespace internal
-}  // namespace v8
+bool GlobalHandles::ProcessingHoldScope::isSkipProcessing() {
+  return s_processingHoldDepth > 0;
+}
 
-namespace EscargotShim {
+// --- GlobalHandles ---
 
 GlobalHandles::GlobalHandles(IsolateWrap* isolate)
     : v8::internal::GlobalHandles(isolate), isolate_(isolate) {}
 
-void GlobalHandles::dispose() {
-  LWNODE_CALL_TRACE_ID(GLOBALHANDLES);
-  persistentValues_.clear();
+GlobalHandles::Node* GlobalHandles::toNode(HandleWrap* location) {
+  LWNODE_DCHECK(location->isGlobalHandleNode());
+  return static_cast<Node*>(location);
+}
+
+GlobalHandles* GlobalHandles::ownerOf(HandleWrap* location) {
+  if (location->isGlobalHandleNode()) {
+    return NodeBlock::from(toNode(location))->owner_;
+  }
+  auto isolate = IsolateWrap::GetCurrent();
+  return isolate ? isolate->global_handles() : nullptr;
+}
 
-  for (auto gcObjectInfo : gcObjectInfos_) {
-    delete gcObjectInfo;
+GlobalHandles::Node* GlobalHandles::allocateNode() {
+  if (firstFreeNode_ == nullptr) {
+    firstBlock_ = new NodeBlock(this, firstBlock_);
+    statistics_.blocks++;
+    for (size_t i = kBlockSize; i > 0; i--) {
+      Node* node = &firstBlock_->nodes_[i - 1];
+      node->nextFree_ = firstFreeNode_;
+      firstFreeNode_ = node;
+    }
   }
 
-  isolate_ = nullptr;
+  Node* node = firstFreeNode_;
+  firstFreeNode_ = node->nextFree_;
+  node->nextFree_ = nullptr;
+  return node;
 }
 
-void GlobalHandles::create(ValueWrap* lwValue) {
-  auto iter = persistentValues_.find(lwValue);
-  if (iter == persistentValues_.end()) {
-    persistentValues_.emplace(lwValue, 1);
-  } else {
-    ++iter->second;
-    // TODO:
-    LWNODE_CALL_TRACE_ID(GLOBALHANDLES,
-                         "Persistent value was created multiple times: %p",
-                         lwValue);
+void GlobalHandles::freeNode(Node* node) {
+  switch (node->state()) {
+    case HandleWrap::Location::Strong:
+      NodeBlock::from(node)->roots_[node->index_] = nullptr;
+      statistics_.strongNodes--;
+      break;
+    case HandleWrap::Location::Weak:
+      GC_unregister_disappearing_link(node->valueSlot());
+      NodeBlock::from(node)->weakNodes_--;
+      statistics_.weakNodes--;
+      break;
+    case HandleWrap::Location::NearDeath:
+      statistics_.nearDeathNodes--;
+      break;
+    default:
+      LWNODE_CHECK_NOT_REACH_HERE();
   }
+
+  node->release();
+  node->nextFree_ = firstFreeNode_;
+  firstFreeNode_ = node;
 }
 
-bool GlobalHandles::destroy(ValueWrap* lwValue) {
-  auto iter = persistentValues_.find(lwValue);
-  if (iter != persistentValues_.end()) {
-    if (iter->second == 1) {
-      persistentValues_.erase(iter);
-    } else {
-      --iter->second;
+void GlobalHandles::setStrong(Node* node) {
+  auto block = NodeBlock::from(node);
+  if (node->state() == HandleWrap::Location::Weak) {
+    if (node->isDead()) {
+      node->revive();
     }
-    return true;
+    // the value is rooted before it is unlinked
+    block->roots_[node->index_] = node->rawValue();
+    GC_unregister_disappearing_link(node->valueSlot());
+    block->weakNodes_--;
+    statistics_.weakNodes--;
+  } else {
+    LWNODE_CHECK(!node->isInUse());
+    block->roots_[node->index_] = node->rawValue();
   }
-  return false;
+  node->setState(HandleWrap::Location::Strong);
+  statistics_.strongNodes++;
 }
 
-size_t GlobalHandles::PostGarbageCollectionProcessing(
-    /*const v8::GCCallbackFlags gc_callback_flags*/) {
-#if defined(LWNODE_ENABLE_EXPERIMENTAL)
-  clearWeakValues();
-#endif
+void GlobalHandles::setWeak(Node* node) {
+  LWNODE_CHECK(node->state() == HandleWrap::Location::Strong);
+  auto block = NodeBlock::from(node);
 
-  return 0;
+  // the value is linked before it is unrooted. Values that aren't on the GC
+  // heap (e.g. small integers) never die.
+  void* base = GC_base(node->rawValue());
+  if (base != nullptr) {
+    GC_general_register_disappearing_link(node->valueSlot(), base);
+  }
+  block->roots_[node->index_] = nullptr;
+  block->weakNodes_++;
+
+  node->setState(HandleWrap::Location::Weak);
+  statistics_.strongNodes--;
+  statistics_.weakNodes++;
 }
 
-void GlobalHandles::releaseWeakValues() {
-  std::set<GcObjectInfo*, ObjectInfoComparator> objectsInfoPersistent;
-  std::vector<GcObjectInfo*> objectsInfoWeak;
-
-  for (auto gcObjectInfo : gcObjectInfos_) {
-    if (gcObjectInfo->isPersistent()) {
-      objectsInfoPersistent.insert(gcObjectInfo);
-    } else {
-      // TODO: check if the weak pointer is valid
-      if (gcObjectInfo->hasCallback()) {
-        void* embedderFields[v8::kEmbedderFieldsInWeakCallback] = {nullptr,
-                                                                   nullptr};
-        v8::WeakCallbackInfo<void> info(isolate_->toV8(),
-                                        gcObjectInfo->parameter(),
-                                        embedderFields,
-                                        nullptr);
-        gcObjectInfo->runCallback(info);
-      }
+void GlobalHandles::setNearDeath(Node* node) {
+  LWNODE_CHECK(node->isDead());
+  // the collector has removed the link
+  NodeBlock::from(node)->weakNodes_--;
+  node->setState(HandleWrap::Location::NearDeath);
+  statistics_.weakNodes--;
+  statistics_.nearDeathNodes++;
+}
 
-      // reset callback
-      MemoryUtil::gcRegisterFinalizer(
-          gcObjectInfo->lwValue(), [](void* self, void* data) {}, nullptr);
+HandleWrap* GlobalHandles::create(HandleWrap* value) {
+  LWNODE_CHECK(value->isValid());
 
-      objectsInfoWeak.push_back(gcObjectInfo);
+  if (!value->isCopyable()) {
+    referencedHandles_[value]++;
+    statistics_.referencedHandles++;
+    return value;
+  }
 
-      GC_invoke_finalizers();
-    }
+  Node* node = allocateNode();
+  node->acquire(value);
+  setStrong(node);
+  return node;
+}
+
+void GlobalHandles::releaseReference(HandleWrap* location) {
+  auto iter = referencedHandles_.find(location);
+  if (iter == referencedHandles_.end()) {
+    return;
+  }
+  if (--iter->second == 0) {
+    referencedHandles_.erase(iter);
   }
+  statistics_.referencedHandles--;
+}
 
-  gcObjectInfos_.clear();
-  gcObjectInfos_.insert(objectsInfoPersistent.begin(),
-                        objectsInfoPersistent.end());
-  for (auto objectInfo : objectsInfoWeak) {
-    delete objectInfo;
+void GlobalHandles::destroy(HandleWrap* location) {
+  if (!location->isGlobalHandleNode()) {
+    releaseReference(location);
+    return;
   }
+  freeNode(toNode(location));
 }
 
-bool GlobalHandles::makeWeak(ValueWrap* lwValue,
-                             void* parameter,  // c++ native object
-                             v8::WeakCallbackInfo<void>::Callback callback) {
-  addWeakValue(lwValue, parameter, callback);
-
-  MemoryUtil::gcRegisterFinalizer(
-      lwValue,
-      [](void* self, void* data) {
-        LWNODE_CALL_TRACE_GC_START();
-        auto globalHandles = static_cast<GlobalHandles*>(data);
-
-        LWNODE_CALL_TRACE_ID(GLOBALHANDLES,
-                             "Call weak callback: %p %p",
-                             self,
-                             globalHandles->isolate_);
-        if (!globalHandles->isolate_) {
-          return;
-        }
-
-        auto gcObjectInfo = globalHandles->findGcObjectInfo((ValueWrap*)self);
-        if (gcObjectInfo) {
-          if (gcObjectInfo->hasCallback()) {
-            void* embedderFields[v8::kEmbedderFieldsInWeakCallback] = {nullptr,
-                                                                       nullptr};
-            v8::WeakCallbackInfo<void> info(globalHandles->isolate_->toV8(),
-                                            gcObjectInfo->parameter(),
-                                            embedderFields,
-                                            nullptr);
-            LWNODE_CHECK_NOT_NULL(globalHandles->isolate_);
-            gcObjectInfo->runCallback(info);
-          }
-
-          globalHandles->removeGcObjectInfo(gcObjectInfo->lwValue());
-        }
-
-        LWNODE_CALL_TRACE_GC_END();
-      },
-      isolate_->GetCurrent()->global_handles());
+void GlobalHandles::makeWeak(HandleWrap* location,
+                             void* parameter,
+                             WeakCallback callback) {
+  // Contexts are held by reference (see create()) and stay strong. An
+  // isolate disposes of its contexts explicitly, so there is nothing for a
+  // weak callback to release.
+  if (!location->isGlobalHandleNode()) {
+    return;
+  }
 
-  return true;
+  Node* node = toNode(location);
+  if (node->state() == HandleWrap::Location::Strong) {
+    setWeak(node);
+  }
+  LWNODE_CHECK(node->state() == HandleWrap::Location::Weak);
+  node->parameter_ = parameter;
+  node->callback_ = callback;
 }
 
-bool GlobalHandles::clearWeakness(ValueWrap* lwValue) {
-  setPersistent(lwValue);
-  return true;
+void* GlobalHandles::clearWeakness(HandleWrap* location) {
+  if (!location->isGlobalHandleNode()) {
+    return nullptr;
+  }
+
+  Node* node = toNode(location);
+  void* parameter = node->parameter_;
+  if (node->state() == HandleWrap::Location::Weak) {
+    setStrong(node);
+  }
+  node->parameter_ = nullptr;
+  node->callback_ = nullptr;
+  return parameter;
 }
 
-void GlobalHandles::addWeakValue(
-    ValueWrap* lwValue,
-    void* parameter,
-    v8::WeakCallbackInfo<void>::Callback callback) {
-  GcObjectInfo objInfo(lwValue, parameter, callback);
-  auto itr = gcObjectInfos_.find(&objInfo);
-  if (itr != gcObjectInfos_.end()) {
-    (*itr)->unsetPersistent();
+void GlobalHandles::invokeFinalizer(Node* node) {
+  setNearDeath(node);
+  statistics_.finalized++;
+
+  // the callback resets the handle, after which the node may be reused
+  void* parameter = node->parameter_;
+  WeakCallback callback = node->callback_;
+
+  if (callback == nullptr) {
+    // the handle was made weak without a callback; clear its location
+    *reinterpret_cast<HandleWrap**>(parameter) = nullptr;
+    freeNode(node);
     return;
   }
 
-  GcObjectInfo* newObjInfo = new GcObjectInfo(lwValue, parameter, callback);
-  gcObjectInfos_.insert(newObjInfo);
+  v8::HandleScope handleScope(isolate_->toV8());
+  void* embedderFields[v8::kEmbedderFieldsInWeakCallback] = {};
+  WeakCallback secondPassCallback = nullptr;
+  v8::WeakCallbackInfo<void> info(
+      isolate_->toV8(), parameter, embedderFields, &secondPassCallback);
+  callback(info);
+
+  if (secondPassCallback) {
+    v8::WeakCallbackInfo<void> secondPassInfo(
+        isolate_->toV8(), parameter, embedderFields, nullptr);
+    secondPassCallback(secondPassInfo);
+  }
 }
 
-void GlobalHandles::setPersistent(ValueWrap* lwValue) {
-  GcObjectInfo objInfo(lwValue);
-  auto itr = gcObjectInfos_.find(&objInfo);
-  if (itr != gcObjectInfos_.end()) {
-    (*itr)->setPersistent();
-    return;
+bool GlobalHandles::hasPendingFinalizers() const {
+  if (statistics_.weakNodes == 0) {
+    return false;
   }
-
-  GcObjectInfo* newObjInfo = new GcObjectInfo(lwValue);
-  gcObjectInfos_.insert(newObjInfo);
+  return scanBlock_ != nullptr || scannedGCNo_ != GC_get_gc_no();
 }
 
-void GlobalHandles::clearWeakValues() {
-  std::set<GcObjectInfo*, ObjectInfoComparator> objectsInfoPersistent;
-  for (auto objectInfo : gcObjectInfos_) {
-    if (objectInfo->isPersistent()) {
-      objectsInfoPersistent.insert(objectInfo);
-    } else {
-      // TODO: check validness of a weak pointer, and call finalizer
-    }
+bool GlobalHandles::processPendingFinalizers(uint64_t budgetMicros) {
+  if (isProcessing_ || ProcessingHoldScope::isSkipProcessing()) {
+    return hasPendingFinalizers();
   }
 
-  gcObjectInfos_.clear();
-  gcObjectInfos_.insert(objectsInfoPersistent.begin(),
-                        objectsInfoPersistent.end());
-}
+  // the resources of the external strings collected since are disposed
+  // here, out of the collector
+  ExternalStringRegistry::instance()->disposePending(isolate_);
 
-GcObjectInfo* GlobalHandles::findGcObjectInfo(ValueWrap* lwValue) {
-  GcObjectInfo objInfo(lwValue);
-  auto itr = gcObjectInfos_.find(&objInfo);
-  if (itr != gcObjectInfos_.end()) {
-    return *itr;
+  if (!hasPendingFinalizers()) {
+    return false;
   }
 
-  return nullptr;
-}
+  isProcessing_ = true;
 
-void GlobalHandles::removeGcObjectInfo(ValueWrap* lwValue) {
-  GcObjectInfo objInfo(lwValue);
-  auto itr = gcObjectInfos_.find(&objInfo);
-  if (itr != gcObjectInfos_.end()) {
-    auto objectInfo = *itr;
-    gcObjectInfos_.erase(itr);
-    delete objectInfo;
+  if (scanBlock_ == nullptr) {
+    scanBlock_ = firstBlock_;
+    scanIndex_ = 0;
+    scanGCNo_ = GC_get_gc_no();
   }
-}
 
-size_t GlobalHandles::handles_count() const {
+  // reading the clock costs more than a typical finalizer, so the budget is
+  // checked every few finalizers and at the end of a block
+  constexpr size_t kFinalizersPerCheck = 8;
+  const auto deadline =
+      (budgetMicros == std::numeric_limits<uint64_t>::max())
+          ? std::chrono::steady_clock::time_point::max()
+          : std::chrono::steady_clock::now() +
+                std::chrono::microseconds(budgetMicros);
   size_t count = 0;
-  for (auto gcObjectInfo : gcObjectInfos_) {
-    if (gcObjectInfo->isPersistent()) {
-      count++;
+  bool isBudgetLeft = true;
+
+  // blocks added by a callback are linked in front, so the scan doesn't
+  // visit them
+  while (scanBlock_ != nullptr && isBudgetLeft) {
+    NodeBlock* block = scanBlock_;
+    while (block->weakNodes_ > 0 && scanIndex_ < kBlockSize) {
+      Node* node = &block->nodes_[scanIndex_++];
+      if (!node->isDead()) {
+        continue;
+      }
+      invokeFinalizer(node);
+      if (++count % kFinalizersPerCheck == 0 &&
+          std::chrono::steady_clock::now() >= deadline) {
+        isBudgetLeft = false;
+        break;
+      }
+    }
+
+    if (!isBudgetLeft) {
+      break;
+    }
+    scanBlock_ = block->next_;
+    scanIndex_ = 0;
+    isBudgetLeft = std::chrono::steady_clock::now() < deadline;
+  }
+
+  if (scanBlock_ == nullptr) {
+    scannedGCNo_ = scanGCNo_;
+  }
+
+  isProcessing_ = false;
+  return hasPendingFinalizers();
+}
+
+void GlobalHandles::processAllPendingFinalizers() {
+  processPendingFinalizers(std::numeric_limits<uint64_t>::max());
+}
+
+void GlobalHandles::dispose() {
+  LWNODE_CALL_TRACE_ID(GLOBALHANDLES);
+
+  while (firstBlock_) {
+    NodeBlock* block = firstBlock_;
+    firstBlock_ = block->next_;
+    for (auto& node : block->nodes_) {
+      if (node.state() == HandleWrap::Location::Weak) {
+        GC_unregister_disappearing_link(node.valueSlot());
+      }
     }
+    delete block;
   }
 
-  return count;
+  firstFreeNode_ = nullptr;
+  scanBlock_ = nullptr;
+  scanIndex_ = 0;
+  referencedHandles_.clear();
+  statistics_ = Statistics();
+}
+
+size_t GlobalHandles::handles_count() const {
+  return statistics_.strongNodes + statistics_.weakNodes +
+         statistics_.nearDeathNodes + statistics_.referencedHandles;
+}
+
+GlobalHandles::Statistics GlobalHandles::statistics() const {
+  return statistics_;
+}
+
+size_t GlobalHandles::totalSize() const {
+  return statistics_.blocks * sizeof(NodeBlock);
+}
+
+size_t GlobalHandles::usedSize() const {
+  return (statistics_.strongNodes + statistics_.weakNodes +
+          statistics_.nearDeathNodes) *
+         sizeof(Node);
 }
 
 }  // namespace EscargotShim
+
+namespace v8 {
+namespace internal {
+
+using EscargotShim::HandleWrap;
+
+bool GlobalHandles::IsWeakHandleEnabled() {
+#if defined(LWNODE_ENABLE_EXPERIMENTAL)
+  return true;
+#else
+  return false;
+#endif
+}
+
+void GlobalHandles::Destroy(HandleWrap* location) {
+  auto globalHandles = EscargotShim::GlobalHandles::ownerOf(location);
+  if (globalHandles) {
+    globalHandles->destroy(location);
+  }
+}
+
+void GlobalHandles::MakeWeak(HandleWrap* location,
+                             void* parameter,
+                             v8::WeakCallbackInfo<void>::Callback callback) {
+  auto globalHandles = EscargotShim::GlobalHandles::ownerOf(location);
+  LWNODE_CHECK_NOT_NULL(globalHandles);
+  globalHandles->makeWeak(location, parameter, callback);
+}
+
+void GlobalHandles::MakeWeak(HandleWrap** location_addr) {
+  auto globalHandles = EscargotShim::GlobalHandles::ownerOf(*location_addr);
+  LWNODE_CHECK_NOT_NULL(globalHandles);
+  globalHandles->makeWeak(*location_addr, location_addr, nullptr);
+}
+
+void* GlobalHandles::ClearWeakness(HandleWrap* location) {
+  auto globalHandles = EscargotShim::GlobalHandles::ownerOf(location);
+  LWNODE_CHECK_NOT_NULL(globalHandles);
+  return globalHandles->clearWeakness(location);
+}
+
+}  // namespace internal
+}  // namespace v8
@@ -16,8 +16,6 @@
 
 #pragma once
 
-#include <set>
-
 #include <EscargotPublic.h>
 
 #include "handle.h"
@@ -29,13 +27,19 @@ class GlobalHandles : public gc {
  public:
   GlobalHandles(Isolate* isolate) : isolate_(isolate) {}
 
-  static void MakeWeak(EscargotShim::ValueWrap* lwValue,
+  // Whether v8::PersistentBase::SetWeak() makes a handle weak. Weak handles
+  // are enabled in experimental builds only (LWNODE_ENABLE_EXPERIMENTAL);
+  // otherwise, handles stay strong until they are reset.
+  static bool IsWeakHandleEnabled();
+
+  // These take the location of a global handle, i.e. the address returned
+  // by EscargotShim::GlobalHandles::create().
+  static void MakeWeak(EscargotShim::HandleWrap* location,
                        void* parameter,
                        v8::WeakCallbackInfo<void>::Callback callback);
-
-  // void Create(EscargotShim::ValueWrap* lwValue);
-  static void Destroy(EscargotShim::ValueWrap* lwValue);
-  static void* ClearWeakness(EscargotShim::ValueWrap* lwValue);
+  static void MakeWeak(EscargotShim::HandleWrap** location_addr);
+  static void Destroy(EscargotShim::HandleWrap* location);
+  static void* ClearWeakness(EscargotShim::HandleWrap* location);
 
   virtual size_t handles_count() const = 0;
 
@@ -48,76 +52,107 @@ class GlobalHandles : public gc {
 
 namespace EscargotShim {
 
-class GlobalWeakHandler;
-
-class GcObjectInfo {
+// A table of global handles laid out like V8's: the handles are nodes in
+// fixed-size blocks, and the state of a node (free, strong, weak or near
+// death) is kept in the node itself. Released nodes are chained into a free
+// list and reused, so creating, weakening and disposing a handle neither
+// allocates on the GC heap nor touches a hash table.
+//
+// The node blocks are malloc'ed, so the collector doesn't see the values of
+// the nodes. Each block has a root array allocated as uncollectable memory,
+// which holds the values of its strong nodes; that is the only way the
+// table keeps values alive. The value slot of a weak node is registered as a
+// disappearing link, so the collector clears it when the value dies. After
+// a GC, such nodes become near death and their callbacks are run in slices
+// by processPendingFinalizers(), which the message loop calls before
+// polling.
+//
+// Handles that can't be copied into a node (contexts, see
+// HandleWrap::isCopyable()) are kept by reference and stay strong.
+class GlobalHandles final : public v8::internal::GlobalHandles {
  public:
-  GcObjectInfo(ValueWrap* lwValue,
-               void* parameter = nullptr,
-               v8::WeakCallbackInfo<void>::Callback callback = nullptr)
-      : lwValue_(lwValue), parameter_(parameter), callback_(callback) {}
-
-  void setPersistent() {
-    holder_.reset(lwValue_);
-    isPersistent_ = true;
-  }
-
-  void unsetPersistent() {
-    holder_.reset(nullptr);
-    isPersistent_ = false;
-  }
-
-  bool isPersistent() { return isPersistent_; }
-  ValueWrap* lwValue() const { return lwValue_; }
-  void* parameter() { return parameter_; }
-  bool hasCallback() { return callback_ != nullptr; }
-  void runCallback(v8::WeakCallbackInfo<void>& info) { callback_(info); }
+  typedef v8::WeakCallbackInfo<void>::Callback WeakCallback;
 
- private:
-  ValueWrap* lwValue_ = nullptr;
-  void* parameter_ = nullptr;
-  v8::WeakCallbackInfo<void>::Callback callback_ = nullptr;
-  Escargot::PersistentRefHolder<ValueWrap> holder_;
-  bool isPersistent_ = false;
-};
+  static constexpr size_t kBlockSize = 256;
+  static constexpr uint64_t kDefaultSliceBudgetMicros = 1000;
 
-class GlobalHandles final : public v8::internal::GlobalHandles {
- public:
-  GlobalHandles(IsolateWrap* isolate);
+  class Node;
+  class NodeBlock;
+
+  // Defers the weak callbacks on this thread while it is alive, e.g. while
+  // the microtasks are running.
+  class ProcessingHoldScope {
+   public:
+    ProcessingHoldScope();
+    ~ProcessingHoldScope();
 
-  size_t PostGarbageCollectionProcessing(
-      /*const v8::GCCallbackFlags gc_callback_flags*/);
+    static bool isSkipProcessing();
+  };
+
+  struct Statistics {
+    size_t blocks = 0;
+    size_t strongNodes = 0;
+    size_t weakNodes = 0;
+    size_t nearDeathNodes = 0;
+    size_t referencedHandles = 0;
+    size_t finalized = 0;
+  };
 
-  void create(ValueWrap* lwValue);
-  bool makeWeak(ValueWrap* lwValue,
-                void* parameter,
-                v8::WeakCallbackInfo<void>::Callback callback);
-  bool clearWeakness(ValueWrap* lwValue);
-  bool destroy(ValueWrap* lwValue);
+  GlobalHandles(IsolateWrap* isolate);
+
+  // Returns the location of a new strong handle to the given value.
+  HandleWrap* create(HandleWrap* value);
+  void destroy(HandleWrap* location);
+  // Without a callback, the parameter is the address of the location, which
+  // is cleared when the value dies.
+  void makeWeak(HandleWrap* location, void* parameter, WeakCallback callback);
+  void* clearWeakness(HandleWrap* location);
+  // Releases every node. The callbacks of weak handles aren't run.
   void dispose();
 
-  void releaseWeakValues();
-  size_t handles_count() const override;
+  bool hasPendingFinalizers() const;
+  // Runs the callbacks of the weak handles whose values died until the
+  // budget runs out, and returns true if some are left. The resources of
+  // the collected external strings are disposed first.
+  bool processPendingFinalizers(
+      uint64_t budgetMicros = kDefaultSliceBudgetMicros);
+  // Runs the callbacks of every weak handle whose value died.
+  void processAllPendingFinalizers();
 
-  void addWeakValue(ValueWrap* lwValue,
-                    void* parameter,
-                    v8::WeakCallbackInfo<void>::Callback callback);
-  void setPersistent(ValueWrap* lwValue);
-  void clearWeakValues();
-  GcObjectInfo* findGcObjectInfo(ValueWrap* value);
-  void removeGcObjectInfo(ValueWrap* lwValue);
+  size_t handles_count() const override;
+  Statistics statistics() const;
+  size_t totalSize() const;
+  size_t usedSize() const;
 
  private:
-  GCUnorderedMap<ValueWrap*, size_t> persistentValues_;
-  IsolateWrap* isolate_{nullptr};
-  struct ObjectInfoComparator {
-    bool operator()(const GcObjectInfo* a, const GcObjectInfo* b) const {
-      return a->lwValue() < b->lwValue();
-    }
-  };
+  static Node* toNode(HandleWrap* location);
+  static GlobalHandles* ownerOf(HandleWrap* location);
 
-  // TODO: use std::unique_ptr
-  std::set<GcObjectInfo*, ObjectInfoComparator> gcObjectInfos_;
+  Node* allocateNode();
+  void freeNode(Node* node);
+  void setStrong(Node* node);
+  void setWeak(Node* node);
+  void setNearDeath(Node* node);
+  void invokeFinalizer(Node* node);
+  void releaseReference(HandleWrap* location);
+
+  IsolateWrap* isolate_{nullptr};
+  NodeBlock* firstBlock_{nullptr};
+  Node* firstFreeNode_{nullptr};
+  Statistics statistics_;
+  // contexts held by global handles and their reference counts
+  GCUnorderedMap<HandleWrap*, size_t> referencedHandles_;
+
+  // the block and the node from which the next slice looks for dead values
+  NodeBlock* scanBlock_{nullptr};
+  size_t scanIndex_{0};
+  // the GC number the scan in progress was started after
+  size_t scanGCNo_{0};
+  // the GC number up to which the dead values have been looked for
+  size_t scannedGCNo_{0};
+  bool isProcessing_{false};
+
+  friend class v8::internal::GlobalHandles;
 };
 
 }  // namespace EscargotShim
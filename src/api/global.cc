@@ -50,7 +50,7 @@ void Global::initGlobalObject(ContextWrap* lwContext) {
 
 void Global::initErrorObject(ContextRef* context) {
   Evaluator::EvaluatorResult r =
-      Evaluator::execute(context, [](ExecutionStateRef* state) -> ValueRef* {
+      EvalHelper::execute(context, [](ExecutionStateRef* state) -> ValueRef* {
         auto errorObject = state->context()
                                ->globalObject()
                                ->get(state, StringRef::createFromASCII("Error"))
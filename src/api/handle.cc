@@ -15,10 +15,10 @@
  */
 
 #include "handle.h"
+#include <cstddef>
 #include <sstream>
 #include "api.h"
 #include "context.h"
-#include "engine.h"
 #include "isolate.h"
 #include "utils/misc.h"
 
@@ -37,6 +37,12 @@ uint8_t HandleWrap::valueType() const {
 }
 
 uint8_t HandleWrap::location() const {
+  typedef v8::internal::Internals I;
+  static_assert(offsetof(HandleWrap, location_) == I::kNodeFlagsOffset,
+                "PersistentBase::IsWeak() reads the location");
+  static_assert(Location::Weak == I::kNodeStateIsWeakValue &&
+                    Location::NearDeath == I::kNodeStateIsPendingValue,
+                "Location should match the node states of V8");
   return location_;
 }
 
@@ -48,6 +54,18 @@ bool HandleWrap::isStrongOrWeak() const {
   return (location_ == Strong || location_ == Weak || location_ == NearDeath);
 }
 
+bool HandleWrap::isCopyable() const {
+  return type_ != Type::Context;
+}
+
+bool HandleWrap::isArenaAllocated() const {
+  return storage_ == Storage::Arena;
+}
+
+bool HandleWrap::isGlobalHandleNode() const {
+  return storage_ == Storage::Global;
+}
+
 void HandleWrap::copy(HandleWrap* that, Location location) {
   val_ = that->val_;
   type_ = that->type_;
@@ -95,17 +113,22 @@ ValueWrap::ValueWrap(void* ptr,
   LWNODE_CALL_TRACE_ID(HANDLE, "%s", getHandleInfoString().c_str());
 }
 
-bool ValueWrap::isExternalString() const {
-  return valueType_ == ValueWrap::ExternalString;
+ValueWrap* ValueWrap::createValue(Escargot::ValueRef* esValue) {
+  return new ValueWrap(esValue, Type::JsValue);
 }
 
-ExternalStringWrap* ValueWrap::asExternalString() const {
-  LWNODE_CHECK(isExternalString());
-  return reinterpret_cast<ExternalStringWrap*>(const_cast<ValueWrap*>(this));
-}
+ValueWrap* ValueWrap::detach(ValueWrap* lwValue) {
+  if (lwValue == nullptr || lwValue->storage_ == Storage::Heap) {
+    return lwValue;
+  }
+  auto detached = new ValueWrap();
+  detached->copy(lwValue, Location::Local);
 
-ValueWrap* ValueWrap::createValue(Escargot::ValueRef* esValue) {
-  return new ValueWrap(esValue, Type::JsValue);
+  LWNODE_CALL_TRACE_ID(HANDLE,
+                       "%p is detached from %s",
+                       detached,
+                       lwValue->getHandleInfoString().c_str());
+  return detached;
 }
 
 ValueRef* ValueWrap::value() const {
@@ -118,6 +141,10 @@ ValueRef* ValueWrap::value() const {
   return reinterpret_cast<ValueRef*>(val_);
 }
 
+bool ValueWrap::isExternalString() const {
+  return valueType_ == ValueType::ExternalString;
+}
+
 ValueWrap* ValueWrap::createContext(ContextWrap* lwContext) {
   LWNODE_CHECK(lwContext->type_ == Type::Context);
   LWNODE_CHECK_NOT_NULL(lwContext->val_);
@@ -173,203 +200,4 @@ ModuleWrap* ValueWrap::module() const {
   return reinterpret_cast<ModuleWrap*>(val_);
 }
 
-// --- PersistentWrap ---
-
-inline static GCHeap* GCHeap() {
-  return Engine::current()->gcHeap();
-}
-
-inline static void acquireStrong(void* address, void* data = nullptr) {
-  GCHeap()->acquire(address, GCHeap::STRONG, data);
-}
-
-inline static void releaseStrong(void* address) {
-  GCHeap()->release(address, GCHeap::STRONG);
-}
-
-inline static void acquireWeak(void* address, void* data = nullptr) {
-  GCHeap()->acquire(address, GCHeap::WEAK, data);
-}
-
-inline static void releaseWeak(void* address) {
-  GCHeap()->release(address, GCHeap::WEAK);
-}
-
-inline static void makeStrongToWeak(void* address) {
-  acquireWeak(address);
-  releaseStrong(address);
-}
-/*
-  1. val_ : HandleWrap MUST be compatible with in V8 other apis.
-
-  ex1)
-    v8::Persistent<String> global1;
-    global1.Reset(isolate, v8_str("str"));
-    Local<String> local1 = Local<String>::New(isolate, global1);
-    CHECK(global1 == local1);
-
-  ex2)
-    v8::Context* operator->() {
-      return *reinterpret_cast<v8::Context**>(&context_);
-    }
-    v8::Context* operator*() { return operator->(); }
-    v8::Persistent<v8::Context> context_;
-
-  2. member values of this instance MUST be hidden to GC.
-*/
-
-PersistentWrap::PersistentWrap(ValueWrap* lwValue) {
-  // copy the given value information and set it as Strong
-  copy(lwValue, Location::Strong);
-
-  holder_ = lwValue;
-
-  LWNODE_CALL_TRACE_ID(GCHEAP,
-                       "%s trace: (%p)",
-                       getPersistentInfoString().c_str(),
-                       getTracingAddress());
-
-  acquireStrong(this, nullptr);
-  LWNODE_DCHECK(GCHeap()->isTraced(this));
-}
-
-void* PersistentWrap::getTracingAddress() {
-  return this;
-}
-
-void* PersistentWrap::GlobalizeReference(v8::Isolate* isolate, void* address) {
-  LWNODE_CALL_TRACE_ID(GCHEAP);
-  ValueWrap* lwValue = reinterpret_cast<ValueWrap*>(address);
-  LWNODE_CHECK(lwValue->isValid());
-
-  PersistentWrap* persistent = new PersistentWrap(lwValue);
-
-  persistent->v8Isolate_ = isolate;
-
-  GCHeap()->printStatus(true);
-
-  return persistent;
-}
-
-void PersistentWrap::DisposeGlobal(void* address) {
-  PersistentWrap* persistent = reinterpret_cast<PersistentWrap*>(address);
-  LWNODE_CALL_TRACE_ID(GCHEAP, "%s", persistent->getPersistentInfoString());
-
-  LWNODE_DCHECK(persistent->location_ != Local);
-
-  persistent->dispose();
-
-  GCHeap()->printStatus(true);
-}
-
-void PersistentWrap::dispose() {
-  LWNODE_CALL_TRACE_ID(GCHEAP,
-                       "%s isFinalizerCalled: %b",
-                       getPersistentInfoString(),
-                       isFinalizerCalled);
-  if (isFinalizerCalled) {
-    return;
-  }
-
-  if (location_ == Location::Strong) {
-    releaseStrong(getTracingAddress());
-  } else if (location_ == Location::Weak) {
-    releaseWeak(getTracingAddress());
-  } else {
-    LWNODE_CHECK_NOT_REACH_HERE();
-  }
-}
-
-void PersistentWrap::MakeWeak(
-    void* address,
-    void* parameter,
-    v8::WeakCallbackInfo<void>::Callback weak_callback) {
-  LWNODE_CALL_TRACE_ID(GCHEAP);
-  PersistentWrap* persitent = reinterpret_cast<PersistentWrap*>(address);
-  LWNODE_CHECK(persitent->location() != Location::Local);
-  persitent->makeWeak(parameter, weak_callback);
-
-  GCHeap()->printStatus(true);
-}
-
-void PersistentWrap::makeWeak(
-    void* parameter, v8::WeakCallbackInfo<void>::Callback weak_callback) {
-  if (location_ == Location::Strong) {
-    // Strong -> Weak
-    makeStrongToWeak(getTracingAddress());
-    location_ = Location::Weak;
-    parameter_ = parameter;
-    weak_callback_ = weak_callback;
-
-  } else if (location_ == Location::Weak) {
-    LWNODE_CHECK(weak_callback_ == weak_callback);
-    LWNODE_CHECK(parameter_ == parameter);
-
-  } else {
-    LWNODE_CHECK_NOT_REACH_HERE();
-  }
-
-  LWNODE_CHECK(GCHeap()->isTraced(this));
-}
-
-void PersistentWrap::invokeFinalizer() {
-  if (Engine::getState() == Engine::Running) {
-    GCHeap()->disposePhantomWeak(this);
-  }
-
-  v8::HandleScope handleScope(v8Isolate_);
-  void* embedderFields[v8::kEmbedderFieldsInWeakCallback] = {};
-  v8::WeakCallbackInfo<void> data(
-      v8Isolate_, parameter_, embedderFields, nullptr);
-
-  weak_callback_(data);
-
-  isFinalizerCalled = true;
-}
-
-void* PersistentWrap::ClearWeak(void* address) {
-  LWNODE_CALL_TRACE_ID(GCHEAP);
-  PersistentWrap* persitent = reinterpret_cast<PersistentWrap*>(address);
-  LWNODE_CHECK(persitent->location() != Location::Local);
-  void* p = persitent->clearWeak();
-  GCHeap()->printStatus(true);
-  return p;
-}
-
-void* PersistentWrap::clearWeak() {
-  if (location_ == Location::Strong) {
-    // Nothing to do
-    LWNODE_CHECK_NULL(weak_callback_);
-    LWNODE_CHECK_NULL(parameter_);
-
-  } else if (location_ == Location::Weak) {
-    // Weak -> Strong
-    acquireStrong(getTracingAddress(), nullptr);
-    releaseWeak(getTracingAddress());
-    location_ = Location::Strong;
-
-  } else {
-    LWNODE_CHECK_NOT_REACH_HERE();
-  }
-
-  void* p = parameter_;
-  parameter_ = nullptr;
-  weak_callback_ = nullptr;
-  return p;
-}
-
-PersistentWrap* PersistentWrap::as(void* address) {
-  auto p = reinterpret_cast<PersistentWrap*>(address);
-  LWNODE_CHECK(p->isStrongOrWeak());
-  LWNODE_CHECK(p->isValid());
-  return p;
-}
-
-std::string PersistentWrap::getPersistentInfoString() {
-  std::stringstream ss;
-  ss << getHandleInfoString() << " holder: " << holder_;
-
-  return ss.str();
-}
-
 }  // namespace EscargotShim
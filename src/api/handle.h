@@ -25,8 +25,7 @@ namespace EscargotShim {
 class ContextWrap;
 class IsolateWrap;
 class ModuleWrap;
-class ExternalStringWrap;
-class GCHeap;
+class HandleArena;
 
 class HandleWrap : public gc {
  public:
@@ -41,6 +40,9 @@ class HandleWrap : public gc {
     EndOfType,
   };
 
+  // The location of a global handle is its node state. It is read by the
+  // inline PersistentBase::IsWeak() of v8.h, so the values match V8's node
+  // states (free, normal, weak and pending).
   enum Location : uint8_t {
     Local = 0,
     Strong,
@@ -48,16 +50,30 @@ class HandleWrap : public gc {
     NearDeath,
   };
 
+  // Marks the handles to the strings created on external resources, so
+  // that String::IsExternal() doesn't look the resource up.
   enum ValueType : uint8_t {
     None,
     ExternalString,
   };
 
+  enum Storage : uint8_t {
+    Heap = 0,
+    Arena,
+    Global,
+  };
+
   uint8_t type() const;
   uint8_t valueType() const;
   bool isValid() const;
   bool isStrongOrWeak() const;
   uint8_t location() const;
+  // ContextWrap carries extra fields, so handles to it can't be copied into a
+  // handle arena and are kept by reference instead.
+  bool isCopyable() const;
+  bool isArenaAllocated() const;
+  // A global handle is a node of the isolate's GlobalHandles table.
+  bool isGlobalHandleNode() const;
   HandleWrap* clone(Location location = Local);
   std::string getHandleInfoString() const;
   static HandleWrap* as(void* address);
@@ -68,8 +84,12 @@ class HandleWrap : public gc {
 
   void* val_ = nullptr;
   uint8_t type_ = Type::NotPresent;
-  uint8_t valueType_ = ValueType::None;  // TODO: remove this variable
+  uint8_t valueType_ = ValueType::None;
+  uint8_t storage_ = Storage::Heap;
+  // laid at v8::internal::Internals::kNodeFlagsOffset
   uint8_t location_ = Location::Local;
+
+  friend class HandleArena;
 };
 
 class ValueWrap : public HandleWrap {
@@ -78,12 +98,10 @@ class ValueWrap : public HandleWrap {
   const ValueWrap& operator=(const ValueWrap& src) = delete;
   const ValueWrap& operator=(ValueWrap&& src) = delete;
 
-  bool isExternalString() const;
-  ExternalStringWrap* asExternalString() const;
-
   // Value
   static ValueWrap* createValue(Escargot::ValueRef* esValue);
   Escargot::ValueRef* value() const;
+  bool isExternalString() const;
 
   // Context
   static ValueWrap* createContext(ContextWrap* lwContext);
@@ -110,6 +128,11 @@ class ValueWrap : public HandleWrap {
   static ValueWrap* createModule(ModuleWrap* esModule);
   ModuleWrap* module() const;
 
+  // Returns a handle that may outlive the current handle scope. A handle
+  // living in a handle arena or in a global handle node is copied to the GC
+  // heap; others are returned as they are. Null-safe.
+  static ValueWrap* detach(ValueWrap* lwValue);
+
  protected:
   ValueWrap(void* ptr,
             HandleWrap::Type type,
@@ -117,34 +140,20 @@ class ValueWrap : public HandleWrap {
   ValueWrap() = default;
 };
 
-class PersistentWrap : public ValueWrap {
+// A ValueWrap placed on the C stack. It is only used as the source of a new
+// local handle, which HandleScope::CreateHandle copies into the current
+// scope, so creating a Local doesn't need a GC allocation.
+class StackValueWrap : public ValueWrap {
  public:
-  static void* GlobalizeReference(v8::Isolate* isolate, void* address);
-  static void DisposeGlobal(void* address);
-  static void MakeWeak(void* address,
-                       void* parameter,
-                       v8::WeakCallbackInfo<void>::Callback weak_callback);
-  static void* ClearWeak(void* address);
-
-  static PersistentWrap* as(void* address);
-  std::string getPersistentInfoString();
-  void invokeFinalizer();
-
- private:
-  PersistentWrap(ValueWrap* ptr);
-
-  void dispose();
-  void makeWeak(void* parameter,
-                v8::WeakCallbackInfo<void>::Callback weak_callback);
-  void* clearWeak();
-  void* getTracingAddress();
-
-  ValueWrap* holder_{nullptr};
-  v8::Isolate* v8Isolate_{nullptr};
-  v8::WeakCallbackInfo<void>::Callback weak_callback_{nullptr};
-  void* parameter_{nullptr};
-  bool isFinalizerCalled{false};
-  friend class GCHeap;
+  StackValueWrap(void* ptr,
+                 HandleWrap::Type type,
+                 HandleWrap::ValueType valueType = HandleWrap::ValueType::None)
+      : ValueWrap(ptr, type, valueType) {}
+
+  void* operator new(size_t size) = delete;
+  void* operator new[](size_t size) = delete;
+  void operator delete(void*, size_t) = delete;
+  void operator delete[](void*, size_t) = delete;
 };
 
 }  // namespace EscargotShim
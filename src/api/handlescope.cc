@@ -22,10 +22,118 @@
 #include "utils/misc.h"
 
 #include <algorithm>
+#include <cstring>
+#include <new>
 #include <sstream>
 
+using namespace Escargot;
+
 namespace EscargotShim {
 
+// --- HandleArena ---
+
+HandleWrap* HandleArena::allocate() {
+  if (top_ == limit_) {
+    grow();
+  }
+  auto slot = ::new (top_++) HandleWrap();
+  slot->storage_ = HandleWrap::Storage::Arena;
+  return slot;
+}
+
+HandleWrap* HandleArena::add(HandleWrap* value) {
+  auto slot = allocate();
+  slot->copy(value, HandleWrap::Location::Local);
+  return slot;
+}
+
+HandleWrap* HandleArena::addValue(ValueRef* value) {
+  auto slot = allocate();
+  slot->val_ = value;
+  slot->type_ = HandleWrap::Type::JsValue;
+  return slot;
+}
+
+void HandleArena::set(HandleWrap* slot, HandleWrap* value) {
+  LWNODE_CHECK(slot->isArenaAllocated());
+  slot->copy(value, HandleWrap::Location::Local);
+}
+
+void HandleArena::grow() {
+  if (usedBlocks_ == blocks_.size()) {
+    blocks_.push_back(reinterpret_cast<HandleWrap*>(
+        Memory::gcMalloc(sizeof(HandleWrap) * kBlockSize)));
+  }
+  top_ = blocks_[usedBlocks_++];
+  limit_ = top_ + kBlockSize;
+}
+
+void HandleArena::clearSlots(HandleWrap* begin, HandleWrap* end) {
+  // released slots shouldn't keep their values reachable
+  if (begin < end) {
+    memset(reinterpret_cast<void*>(begin),
+           0,
+           (end - begin) * sizeof(HandleWrap));
+  }
+}
+
+void HandleArena::reset(const Mark& mark) {
+  LWNODE_CHECK(mark.usedBlocks <= usedBlocks_);
+
+  while (usedBlocks_ > mark.usedBlocks) {
+    clearSlots(blocks_[usedBlocks_ - 1], top_);
+    usedBlocks_--;
+    // a block is only left when it becomes full
+    top_ = (usedBlocks_ > 0) ? blocks_[usedBlocks_ - 1] + kBlockSize : nullptr;
+  }
+
+  clearSlots(mark.top, top_);
+  top_ = mark.top;
+  limit_ = (usedBlocks_ > 0) ? blocks_[usedBlocks_ - 1] + kBlockSize : nullptr;
+
+  // keep a spare block to avoid reallocation at a scope boundary
+  while (blocks_.size() > usedBlocks_ + 1) {
+    Memory::gcFree(blocks_.back());
+    blocks_.pop_back();
+  }
+}
+
+HandleWrap* HandleArena::resetAndKeep(const Mark& mark, HandleWrap* handle) {
+  if (handle == nullptr || !isAllocatedSince(mark, handle)) {
+    reset(mark);
+    return handle;
+  }
+
+  HandleWrap kept;
+  kept.copy(handle, HandleWrap::Location::Local);
+  reset(mark);
+  return add(&kept);
+}
+
+bool HandleArena::isAllocatedSince(const Mark& mark,
+                                   const HandleWrap* handle) const {
+  size_t i = (mark.usedBlocks > 0) ? mark.usedBlocks - 1 : 0;
+  for (; i < usedBlocks_; i++) {
+    const HandleWrap* begin =
+        (i + 1 == mark.usedBlocks) ? mark.top : blocks_[i];
+    const HandleWrap* end =
+        (i + 1 == usedBlocks_) ? top_ : blocks_[i] + kBlockSize;
+    if (begin <= handle && handle < end) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t HandleArena::size() const {
+  if (usedBlocks_ == 0) {
+    return 0;
+  }
+  return (usedBlocks_ - 1) * kBlockSize + (top_ - blocks_[usedBlocks_ - 1]);
+}
+
+// --- HandleScopeWrap ---
+
 HandleScopeWrap::HandleScopeWrap(v8::HandleScope* scope,
                                  HandleScopeWrap::Type type)
     : type_(type), v8scope_(reinterpret_cast<void*>(scope)) {}
@@ -91,8 +199,7 @@ void HandleScopeWrap::clear() {
 HandleScopeWrapGuard::HandleScopeWrapGuard(IsolateWrap* isolate)
     : isolate_(isolate) {
   LWNODE_CHECK_NOT_NULL(isolate_);
-  isolate_->pushHandleScope(
-      new HandleScopeWrap(HandleScopeWrap::Type::Internal));
+  isolate_->pushHandleScope(&scope_);
 }
 
 HandleScopeWrapGuard::~HandleScopeWrapGuard() {
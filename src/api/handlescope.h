@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <EscargotPublic.h>
 #include <v8.h>
 #include "utils/gc-util.h"
 
@@ -27,6 +28,44 @@ class HandleScopeWrapGuard;
 
 typedef void v8Scope_t;
 
+// A per-isolate bump-pointer arena of local handles. A handle scope records
+// the arena mark when it is entered and resets the arena to the mark when it
+// is left, so the handles of the scope are released at once. The arena
+// blocks are reachable from the isolate, so live slots are GC roots.
+class HandleArena : public gc {
+ public:
+  static constexpr size_t kBlockSize = 1024;
+
+  struct Mark {
+    size_t usedBlocks{0};
+    HandleWrap* top{nullptr};
+  };
+
+  Mark mark() const { return Mark{usedBlocks_, top_}; }
+  // Returns an empty slot.
+  HandleWrap* allocate();
+  // Returns a slot holding a local copy of the given handle.
+  HandleWrap* add(HandleWrap* value);
+  // Returns a slot holding a local handle to the given value.
+  HandleWrap* addValue(Escargot::ValueRef* value);
+  void set(HandleWrap* slot, HandleWrap* value);
+  void reset(const Mark& mark);
+  // Resets the arena to the mark, but keeps the given handle alive by moving
+  // it below the mark if it was allocated after the mark.
+  HandleWrap* resetAndKeep(const Mark& mark, HandleWrap* handle);
+  bool isAllocatedSince(const Mark& mark, const HandleWrap* handle) const;
+  size_t size() const;
+
+ private:
+  void grow();
+  void clearSlots(HandleWrap* begin, HandleWrap* end);
+
+  GCVector<HandleWrap*> blocks_;
+  size_t usedBlocks_{0};
+  HandleWrap* top_{nullptr};
+  HandleWrap* limit_{nullptr};
+};
+
 class HandleScopeWrap : public gc {
  public:
   enum Type : uint8_t {
@@ -51,7 +90,9 @@ class HandleScopeWrap : public gc {
 
   Type type_{None};
   v8Scope_t* v8scope_{nullptr};
+  // handles that can't be copied into the handle arena
   GCVector<HandleWrap*> handles_;
+  HandleArena::Mark arenaMark_;
 
   friend class IsolateWrap;
   friend class HandleScopeWrapGuard;
@@ -69,6 +110,8 @@ class HandleScopeWrapGuard : public gc {
 
  private:
   IsolateWrap* isolate_{nullptr};
+  // The scope lives with the guard, so entering it doesn't allocate.
+  HandleScopeWrap scope_{HandleScopeWrap::Type::Internal};
 };
 
 }  // namespace EscargotShim
@@ -15,10 +15,12 @@
  */
 
 #include "isolate.h"
+#include <mutex>
 #include "api.h"
 #include "base.h"
 #include "context.h"
 #include "es-helper.h"
+#include "external-string.h"
 #include "extra-data.h"
 #include "utils/compiler.h"
 #include "utils/gc-util.h"
@@ -29,6 +31,25 @@ namespace internal {
 
 using namespace EscargotShim;
 
+Isolate::Isolate() {
+  auto offset = [this](void* field) {
+    return reinterpret_cast<uint8_t*>(field) - reinterpret_cast<uint8_t*>(this);
+  };
+  LWNODE_DCHECK(offset(embedder_data_) ==
+                Internals::kIsolateEmbedderDataOffset);
+  LWNODE_DCHECK(offset(&external_memory_) == Internals::kExternalMemoryOffset);
+  LWNODE_DCHECK(offset(&external_memory_limit_) ==
+                Internals::kExternalMemoryLimitOffset);
+  LWNODE_DCHECK(offset(&external_memory_low_since_gc_) ==
+                Internals::kExternalMemoryLowSinceMarkCompactOffset);
+}
+
+void Isolate::ResetExternalMemoryLimit() {
+  external_memory_low_since_gc_ = external_memory_;
+  external_memory_limit_ =
+      external_memory_ + Internals::kExternalAllocationSoftLimit;
+}
+
 // 'exception_' is of type ValueWrap*. Ref: api-exception.cc
 void Isolate::SetTerminationOnExternalTryCatch() {
   LWNODE_CALL_TRACE_ID(TRYCATCH, "try_catch_handler_: %p", try_catch_handler_);
@@ -273,6 +294,7 @@ IsolateWrap::IsolateWrap() {
   LWNODE_CALL_TRACE_ID(ISOWRAP, "malc: %p", this);
 
   global_handles_ = new GlobalHandles(this);
+  handleArena_ = new HandleArena();
 
   privateValuesSymbol_ = PersistentRefHolder<SymbolRef>(
       SymbolRef::create(StringRef::createFromUTF8(PRIVATE_VALUES.data(),
@@ -320,6 +342,10 @@ void IsolateWrap::Dispose() {
 
   global_handles()->dispose();
   RegisteredExtension::unregisterAll();
+  ExternalStringRegistry::instance()->dispose(this);
+
+  delete gcEventTracker_;
+  gcEventTracker_ = nullptr;
 
   LWNODE_CALL_TRACE_GC_END();
 }
@@ -379,8 +405,9 @@ void IsolateWrap::Initialize(const v8::Isolate::CreateParams& params) {
 
   LWNODE_CHECK_NOT_NULL(arrayBufferDecorator_->array_buffer_allocator());
 
+  // ArrayBuffer data goes through the decorator to count its size
   auto platform = Platform::GetInstance();
-  platform->setAllocator(array_buffer_allocator());
+  platform->setAllocator(arrayBufferDecorator_);
 
   vmInstance_ = VMInstanceRef::create();
   vmInstance_->setOnVMInstanceDelete([](VMInstanceRef* instance) {
@@ -397,6 +424,8 @@ void IsolateWrap::Initialize(const v8::Isolate::CreateParams& params) {
 
   InitializeGlobalSlots();
 
+  gcEventTracker_ = new GCEventTracker(toV8());
+
   // Register lwnode internal promise hook to create the internal field.
   LWNODE_ONCE(LWNODE_DLOG_INFO("v8::Promise::kEmbedderFieldCount: %d",
                                v8::Promise::kEmbedderFieldCount));
@@ -472,26 +501,65 @@ IsolateWrap* IsolateWrap::GetCurrent() {
 }
 
 void IsolateWrap::pushHandleScope(HandleScopeWrap* handleScope) {
+  handleScope->arenaMark_ = handleArena_->mark();
   handleScopes_.push_back(handleScope);
 }
 
 void IsolateWrap::popHandleScope(v8Scope_t* handleScope) {
-  LWNODE_CHECK(handleScopes_.back()->v8Scope() == handleScope);
+  auto lwHandleScope = handleScopes_.back();
+  LWNODE_CHECK(lwHandleScope->v8Scope() == handleScope);
 
   LWNODE_CALL_TRACE_ID(ISOWRAP);
   // TODO: remove the following line and simply pop the last
-  handleScopes_.back()->clear();
+  lwHandleScope->clear();
 
   handleScopes_.pop_back();
+
+  const auto& mark = lwHandleScope->arenaMark_;
+
+  if (returnValueSlots_.empty()) {
+    handleArena_->reset(mark);
+    return;
+  }
+
+  // The return value of the running callback may be a handle of this scope.
+  // Move it to the outer scope, or to the heap if there is no outer scope.
+  auto slot = returnValueSlots_.back();
+  if (!handleScopes_.empty()) {
+    *slot = handleArena_->resetAndKeep(mark, *slot);
+    return;
+  }
+
+  if (handleArena_->isAllocatedSince(mark, *slot)) {
+    *slot = (*slot)->clone(HandleWrap::Location::Local);
+  }
+  handleArena_->reset(mark);
 }
 
-void IsolateWrap::addHandleToCurrentScope(HandleWrap* value) {
+HandleWrap* IsolateWrap::addHandleToCurrentScope(HandleWrap* value) {
   LWNODE_CALL_TRACE_ID(ISOWRAP, "%p", value);
   LWNODE_CHECK(handleScopes_.size() >= 1);
+
+  if (value->isCopyable()) {
+    return handleArena_->add(value);
+  }
+
+  if (value->isStrongOrWeak()) {
+    value = value->clone(HandleWrap::Location::Local);
+  }
   handleScopes_.back()->add(value);
+  return value;
 }
 
-void IsolateWrap::escapeHandle(HandleWrap* value) {
+HandleWrap* IsolateWrap::reserveEscapeSlot() {
+  if (handleScopes_.empty()) {
+    return nullptr;
+  }
+  return handleArena_->allocate();
+}
+
+HandleWrap* IsolateWrap::escapeHandle(HandleWrap* value,
+                                      HandleWrap* escapeSlot) {
   auto nHandleScopes = handleScopes_.size();
   LWNODE_CHECK(nHandleScopes > 1);
 
@@ -499,9 +567,41 @@ void IsolateWrap::escapeHandle(HandleWrap* value) {
 
   LWNODE_CHECK((*last)->type() == HandleScopeWrap::Type::Escapable);
 
+  if (value == nullptr) {
+    return nullptr;
+  }
+
+  if (value->isArenaAllocated()) {
+    if (!handleArena_->isAllocatedSince((*last)->arenaMark_, value)) {
+      return value;
+    }
+    LWNODE_CHECK_NOT_NULL(escapeSlot);
+    handleArena_->set(escapeSlot, value);
+    return escapeSlot;
+  }
+
   if ((*last)->remove(value)) {
     (*(++last))->add(value);
   }
+  return value;
+}
+
+void IsolateWrap::pushReturnValueSlot(HandleWrap** slot) {
+  returnValueSlots_.push_back(slot);
+}
+
+void IsolateWrap::popReturnValueSlot(HandleWrap** slot) {
+  LWNODE_CHECK(!returnValueSlots_.empty() && returnValueSlots_.back() == slot);
+  returnValueSlots_.pop_back();
+}
+
+void IsolateWrap::pushExecutionState(ExecutionStateRef* state) {
+  executionStates_.push_back(state);
+}
+
+void IsolateWrap::popExecutionState(ExecutionStateRef* state) {
+  LWNODE_CHECK(!executionStates_.empty() && executionStates_.back() == state);
+  executionStates_.pop_back();
 }
 
 bool IsolateWrap::isCurrentScopeSealed() {
@@ -545,20 +645,25 @@ void IsolateWrap::addEternal(GCManagedObject* value) {
   eternals_.push_back(value);
 }
 
-void IsolateWrap::addBackingStore(BackingStoreRef* value) {
-  auto itr = backingStoreCounter_.find(value);
-  if (itr != backingStoreCounter_.end()) {
+typedef GCMap<BackingStoreRef*, int, BackingStoreComparator>
+    BackingStoreCounter;
+
+static void increaseBackingStoreCount(BackingStoreCounter& counter,
+                                      BackingStoreRef* value) {
+  auto itr = counter.find(value);
+  if (itr != counter.end()) {
     ++itr->second;
   } else {
-    backingStoreCounter_.insert(std::make_pair(value, 1));
+    counter.insert(std::make_pair(value, 1));
   }
 }
 
-void IsolateWrap::removeBackingStore(BackingStoreRef* value) {
-  auto itr = backingStoreCounter_.find(value);
-  if (itr != backingStoreCounter_.end()) {
+static void decreaseBackingStoreCount(BackingStoreCounter& counter,
+                                      BackingStoreRef* value) {
+  auto itr = counter.find(value);
+  if (itr != counter.end()) {
     if (itr->second == 1) {
-      backingStoreCounter_.erase(itr);
+      counter.erase(itr);
     } else {
       --itr->second;
     }
@@ -567,71 +672,92 @@ void IsolateWrap::removeBackingStore(BackingStoreRef* value) {
   }
 }
 
-SymbolRef* IsolateWrap::createApiSymbol(StringRef* name) {
-  // FIXME: Use a set
-  auto newSymbol = SymbolRef::create(name);
-  bool found = false;
-  for (size_t i = 0; i < apiSymbols_.size(); i++) {
-    if (apiSymbols_[i]->description()->equals(name)) {
-      apiSymbols_[i] = newSymbol;
-      found = true;
-      break;
-    }
+// The holders of a shared backing store are passed between the threads of
+// workers (e.g. through MessagePort), so they are counted in a process-wide
+// map. The map is kept in an uncollectable root and is never freed.
+static std::mutex s_sharedBackingStoreMutex;
+
+static BackingStoreCounter& sharedBackingStoreCounter() {
+  static auto holder =
+      new PersistentRefHolder<BackingStoreCounter>(new BackingStoreCounter());
+  return *holder->get();
+}
+
+void IsolateWrap::addBackingStore(BackingStoreRef* value) {
+  if (value->isShared()) {
+    addSharedBackingStore(value);
+    return;
   }
+  increaseBackingStoreCount(backingStoreCounter_, value);
+}
 
-  if (!found) {
-    apiSymbols_.push_back(newSymbol);
-    LWNODE_DLOG_INFO("malc: api symbol: %s", name->toStdUTF8String().c_str());
+void IsolateWrap::removeBackingStore(BackingStoreRef* value) {
+  if (value->isShared()) {
+    removeSharedBackingStore(value);
+    return;
   }
+  decreaseBackingStoreCount(backingStoreCounter_, value);
+}
 
-  return newSymbol;
+void IsolateWrap::addSharedBackingStore(BackingStoreRef* value) {
+  std::lock_guard<std::mutex> lock(s_sharedBackingStoreMutex);
+  increaseBackingStoreCount(sharedBackingStoreCounter(), value);
 }
 
-SymbolRef* IsolateWrap::getApiSymbol(StringRef* name) {
-  // FIXME: Use a set
-  LWNODE_CALL_TRACE_ID(ISOWRAP);
+void IsolateWrap::removeSharedBackingStore(BackingStoreRef* value) {
+  std::lock_guard<std::mutex> lock(s_sharedBackingStoreMutex);
+  decreaseBackingStoreCount(sharedBackingStoreCounter(), value);
+}
 
-  for (auto apiSymbols : apiSymbols_) {
-    if (apiSymbols->description()->equals(name)) {
-      return apiSymbols;
-    }
+SymbolRef* ApiSymbolRegistry::get(StringRef* name) {
+  lookups_++;
+
+  auto it = symbols_.find(name);
+  if (it != symbols_.end()) {
+    hits_++;
+    return it->second;
   }
 
-  return createApiSymbol(name);
+  return create(name);
 }
 
-SymbolRef* IsolateWrap::createApiPrivateSymbol(StringRef* name) {
-  // FIXME: Use a set
+SymbolRef* ApiSymbolRegistry::create(StringRef* name) {
   auto newSymbol = SymbolRef::create(name);
-  bool found = false;
-  for (size_t i = 0; i < apiPrivateSymbols_.size(); i++) {
-    if (apiPrivateSymbols_[i]->description()->equals(name)) {
-      apiPrivateSymbols_[i] = newSymbol;
-      found = true;
-      break;
-    }
-  }
 
-  if (!found) {
-    apiPrivateSymbols_.push_back(newSymbol);
-    LWNODE_DLOG_INFO("malc: private symbol: %s",
-                     name->toStdUTF8String().c_str());
+  auto result = symbols_.emplace(name, newSymbol);
+  if (result.second) {
+    LWNODE_DLOG_INFO("malc: api symbol: %s", name->toStdUTF8String().c_str());
+  } else {
+    result.first->second = newSymbol;
   }
 
   return newSymbol;
 }
 
-SymbolRef* IsolateWrap::getApiPrivateSymbol(StringRef* name) {
-  // FIXME: Use a set
+ApiSymbolRegistry::Stats ApiSymbolRegistry::stats() const {
+  Stats stats;
+  stats.size = symbols_.size();
+  stats.lookups = lookups_;
+  stats.hits = hits_;
+  return stats;
+}
+
+SymbolRef* IsolateWrap::createApiSymbol(StringRef* name) {
+  return apiSymbols_.create(name);
+}
+
+SymbolRef* IsolateWrap::getApiSymbol(StringRef* name) {
   LWNODE_CALL_TRACE_ID(ISOWRAP);
+  return apiSymbols_.get(name);
+}
 
-  for (auto apiPrivateSymbol : apiPrivateSymbols_) {
-    if (apiPrivateSymbol->description()->equals(name)) {
-      return apiPrivateSymbol;
-    }
-  }
+SymbolRef* IsolateWrap::createApiPrivateSymbol(StringRef* name) {
+  return apiPrivateSymbols_.create(name);
+}
 
-  return createApiPrivateSymbol(name);
+SymbolRef* IsolateWrap::getApiPrivateSymbol(StringRef* name) {
+  LWNODE_CALL_TRACE_ID(ISOWRAP);
+  return apiPrivateSymbols_.get(name);
 }
 
 void IsolateWrap::ClearPendingExceptionAndMessage() {
@@ -641,10 +767,11 @@ void IsolateWrap::ClearPendingExceptionAndMessage() {
 
 void IsolateWrap::CollectGarbage(GarbageCollectionReason reason) {
   if (reason == GarbageCollectionReason::kTesting) {
-    global_handles_->releaseWeakValues();
-  } else {
-    global_handles_->PostGarbageCollectionProcessing();
+    // the stack isn't scanned, so the values of weak handles die for sure
+    GCEventTracker::ReasonScope scope(toV8(), GCEventTracker::Reason::kForced);
+    MemoryUtil::gcFull();
   }
+  global_handles_->processAllPendingFinalizers();
 }
 
 void IsolateWrap::ScheduleThrow(Escargot::ValueRef* value) {
@@ -20,6 +20,7 @@
 #include "arraybuffer-allocator.h"
 #include "engine.h"
 #include "execution/v8threads.h"
+#include "gc-event-tracker.h"
 #include "global-handles.h"
 #include "handlescope.h"
 #include "utils/compiler.h"
@@ -28,7 +29,25 @@
 namespace v8 {
 namespace internal {
 class Isolate : public gc {
+  // The head of this object is laid out like V8's IsolateData, so that the
+  // inline functions of v8.h (Isolate::GetData/SetData and
+  // Isolate::AdjustAmountOfExternalAllocatedMemory) work on it. These should
+  // be the first fields.
+  void* embedder_data_[Internals::kNumIsolateDataSlots] = {};
+  int64_t external_memory_ = 0;
+  int64_t external_memory_limit_ = Internals::kExternalAllocationSoftLimit;
+  int64_t external_memory_low_since_gc_ = 0;
+
  public:
+  Isolate();
+
+  // The amount of the external memory reported by the embedder with
+  // AdjustAmountOfExternalAllocatedMemory.
+  int64_t external_memory() const { return external_memory_; }
+  // The embedder is nudged to collect garbage again once the external memory
+  // grows by the soft limit from here.
+  void ResetExternalMemoryLimit();
+
   void RegisterTryCatchHandler(v8::TryCatch* that);
   void UnregisterTryCatchHandler(v8::TryCatch* that);
   void SetTerminationOnExternalTryCatch();
@@ -118,10 +137,6 @@ class Isolate : public gc {
   v8::TryCatch* getExternalTryCatchOnTop();
   bool hasExternalTryCatch();
 
-  // @important memory layout (IsolateData, kEmbedderDataOffset,
-  // kExternalMemoryOffset, kExternalMemoryLlimitOffset and so on) aren't
-  // considered.
-
   Escargot::ValueRef* scheduled_exception_{nullptr};
 
   v8::PromiseHook promise_hook_{nullptr};
@@ -155,6 +170,38 @@ struct BackingStoreComparator {
   }
 };
 
+// A registry of the symbols created by Symbol::ForApi and Private::ForApi,
+// indexed by the content of their descriptions.
+class ApiSymbolRegistry {
+ public:
+  struct Stats {
+    size_t size{0};
+    size_t lookups{0};
+    size_t hits{0};
+  };
+
+  // Returns the symbol registered for the name, or registers a new one.
+  SymbolRef* get(StringRef* name);
+  // Registers a new symbol for the name, replacing the existing one if any.
+  SymbolRef* create(StringRef* name);
+  Stats stats() const;
+
+ private:
+  struct NameHash {
+    size_t operator()(StringRef* name) const {
+      return StringRefHelper::hash(name);
+    }
+  };
+
+  struct NameEqual {
+    bool operator()(StringRef* a, StringRef* b) const { return a->equals(b); }
+  };
+
+  GCUnorderedMap<StringRef*, SymbolRef*, NameHash, NameEqual> symbols_;
+  size_t lookups_{0};
+  size_t hits_{0};
+};
+
 class IsolateWrap final : public v8::internal::Isolate {
  public:
   ~IsolateWrap();
@@ -202,9 +249,26 @@ class IsolateWrap final : public v8::internal::Isolate {
   // HandleScope & Handle
   void pushHandleScope(HandleScopeWrap* handleScope);
   void popHandleScope(v8Scope_t* v8HandleScope);
-  void addHandleToCurrentScope(HandleWrap* value);
-  void escapeHandle(HandleWrap* value);
+  HandleWrap* addHandleToCurrentScope(HandleWrap* value);
+  HandleWrap* reserveEscapeSlot();
+  HandleWrap* escapeHandle(HandleWrap* value, HandleWrap* escapeSlot);
   bool isCurrentScopeSealed();
+  HandleArena* handleArena() { return handleArena_; }
+
+  // The return value slots of running API callbacks. A return value handle
+  // created in a handle scope of a callback is kept alive when the scope is
+  // left (see popHandleScope).
+  void pushReturnValueSlot(HandleWrap** slot);
+  void popReturnValueSlot(HandleWrap** slot);
+
+  // The execution states of the running native callbacks. The API called
+  // from a callback runs its closures on the innermost one (see
+  // EvalHelper::execute).
+  void pushExecutionState(ExecutionStateRef* state);
+  void popExecutionState(ExecutionStateRef* state);
+  ExecutionStateRef* currentExecutionState() {
+    return executionStates_.empty() ? nullptr : executionStates_.back();
+  }
 
   // Context
   void pushContext(ContextWrap* context);
@@ -218,9 +282,13 @@ class IsolateWrap final : public v8::internal::Isolate {
 
   // Increment/Decrement a counter when either a unique_ptr<v8::BackingStore>
   // or shared_ptr<v8::BackingStore> is created. It holds a BackingStore when
-  // it is transferred between Array/SharedArrayBuffers.
+  // it is transferred between Array/SharedArrayBuffers. Shared backing stores
+  // are counted process-wide since a worker may release the holder on
+  // another thread.
   void addBackingStore(BackingStoreRef* value);
   void removeBackingStore(BackingStoreRef* value);
+  static void addSharedBackingStore(BackingStoreRef* value);
+  static void removeSharedBackingStore(BackingStoreRef* value);
 
   VMInstanceRef* get() { return vmInstance_; }
   VMInstanceRef* vmInstance() { return vmInstance_; }
@@ -241,6 +309,11 @@ class IsolateWrap final : public v8::internal::Isolate {
   SymbolRef* createApiPrivateSymbol(StringRef* name);
   SymbolRef* getApiPrivateSymbol(StringRef* name);
 
+  const ApiSymbolRegistry& apiSymbols() const { return apiSymbols_; }
+  const ApiSymbolRegistry& apiPrivateSymbols() const {
+    return apiPrivateSymbols_;
+  }
+
   void CollectGarbage(
       GarbageCollectionReason reason = GarbageCollectionReason::kRuntime);
 
@@ -271,6 +344,8 @@ class IsolateWrap final : public v8::internal::Isolate {
 
   ThreadManager* thread_manager() { return threadManager_; }
 
+  GCEventTracker* gcEventTracker() { return gcEventTracker_; }
+
   void PerformMicrotaskCheckpoint() {
     v8::MicrotasksScope::PerformCheckpoint(toV8(this));
   }
@@ -284,11 +359,14 @@ class IsolateWrap final : public v8::internal::Isolate {
   GCMap<BackingStoreRef*, int, BackingStoreComparator> backingStoreCounter_;
 
   GCVector<HandleScopeWrap*> handleScopes_;
+  HandleArena* handleArena_ = nullptr;
+  GCVector<HandleWrap**> returnValueSlots_;
+  GCVector<ExecutionStateRef*> executionStates_;
   GCVector<ContextWrap*> contextScopes_;
 
   PersistentRefHolder<SymbolRef> privateValuesSymbol_;
-  GCVector<SymbolRef*> apiSymbols_;
-  GCVector<SymbolRef*> apiPrivateSymbols_;
+  ApiSymbolRegistry apiSymbols_;
+  ApiSymbolRegistry apiPrivateSymbols_;
 
   // Isolate Scope
   static THREAD_LOCAL IsolateWrap* s_currentIsolate;
@@ -304,8 +382,29 @@ class IsolateWrap final : public v8::internal::Isolate {
   ValueWrap* globalSlot_[internal::Internals::kRootIndexSize]{};
 
   ThreadManager* threadManager_ = nullptr;
+  GCEventTracker* gcEventTracker_ = nullptr;
 
   v8::PromiseRejectCallback promise_reject_callback_{nullptr};
 };
 
+// Makes the execution state of a native callback the current one of the
+// isolate while the embedder's callback runs.
+class ExecutionStateScope {
+ public:
+  ExecutionStateScope(IsolateWrap* isolate, ExecutionStateRef* state)
+      : isolate_(isolate), state_(state) {
+    isolate_->pushExecutionState(state_);
+  }
+  ExecutionStateScope(v8::Isolate* isolate, ExecutionStateRef* state)
+      : ExecutionStateScope(IsolateWrap::fromV8(isolate), state) {}
+  ~ExecutionStateScope() { isolate_->popExecutionState(state_); }
+
+  void* operator new(size_t size) = delete;
+  void* operator new[](size_t size) = delete;
+
+ private:
+  IsolateWrap* isolate_;
+  ExecutionStateRef* state_;
+};
+
 }  // namespace EscargotShim
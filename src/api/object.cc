@@ -34,6 +34,7 @@ static ValueRef* accessorPropertyGetter(
     ValueRef* receiver,
     ObjectRef::NativeDataAccessorPropertyData* data) {
   auto wrapper = AccessorNameCallbackDataWrap::toWrap(data);
+  ExecutionStateScope stateScope(wrapper->m_isolate, state);
 
   PropertyCallbackInfoWrap<v8::Value> info(
       wrapper->m_isolate, self, receiver, VAL(wrapper->m_data));
@@ -62,6 +63,7 @@ static bool accessorPropertySetter(
     ObjectRef::NativeDataAccessorPropertyData* data,
     ValueRef* setterInputData) {
   auto wrapper = AccessorNameCallbackDataWrap::toWrap(data);
+  ExecutionStateScope stateScope(wrapper->m_isolate, state);
 
   HandleScope handle_scope(wrapper->m_isolate);
 
@@ -98,10 +100,10 @@ NativeDataAccessorPropertyDataWrap<T, F>::NativeDataAccessorPropertyDataWrap(
           accessorPropertyGetter,
           setter == nullptr ? nullptr : accessorPropertySetter),
       m_isolate(isolate),
-      m_name(*name),
+      m_name(reinterpret_cast<v8::Name*>(ValueWrap::detach(VAL(*name)))),
       m_getter(getter),
       m_setter(setter),
-      m_data(*data) {}
+      m_data(reinterpret_cast<v8::Value*>(ValueWrap::detach(VAL(*data)))) {}
 
 Maybe<bool> ObjectUtils::SetAccessor(ObjectRef* esObject,
                                      IsolateWrap* lwIsolate,
@@ -122,7 +124,7 @@ Maybe<bool> ObjectUtils::SetAccessor(ObjectRef* esObject,
   auto esName = CVAL(*name)->value();
   LWNODE_CHECK(esName->isString() || esName->isSymbol());
 
-  auto result = Evaluator::execute(
+  auto result = EvalHelper::execute(
       lwIsolate->GetCurrentContext()->get(),
       [](ExecutionStateRef* esState,
          ObjectRef* esSelf,
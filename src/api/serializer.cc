@@ -192,6 +192,8 @@ bool ValueSerializer::WriteValue(ValueRef* value) {
     return WriteNumber(value->asNumber());
   } else if (value->isBigInt()) {
     LWNODE_UNIMPLEMENT;
+  } else if (value->isSharedArrayBufferObject()) {
+    return WriteSharedArrayBuffer(value->asSharedArrayBufferObject());
   } else if (value->isArrayBufferObject()) {
     auto arrayBuffer = value->asArrayBufferObject();
     return WriteArrayBuffer(arrayBuffer->byteLength(),
@@ -346,7 +348,7 @@ bool ValueSerializer::WriteObject(ObjectRef* object) {
   uint32_t propertiesWritten = 0;
   WriteTag(SerializationTag::kBeginJSObject);
   Escargot::ValueVectorRef* keys = nullptr;
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* state,
          ObjectRef* object,
@@ -404,6 +406,29 @@ bool ValueSerializer::WriteArrayBuffer(size_t length, uint8_t* bytes) {
   return ThrowIfOutOfMemory();
 }
 
+// The memory isn't copied. The delegate keeps the backing store and gives the
+// deserializer of the receiving isolate a SharedArrayBuffer on the same
+// memory.
+bool ValueSerializer::WriteSharedArrayBuffer(
+    SharedArrayBufferObjectRef* sharedArrayBuffer) {
+  if (!delegate_) {
+    ThrowDataCloneError(ErrorMessageType::kDataCloneErrorSharedArrayBuffer);
+    return false;
+  }
+
+  v8::Isolate* v8_isolate = lwIsolate_->toV8();
+  Maybe<uint32_t> index = delegate_->GetSharedArrayBufferId(
+      v8_isolate,
+      Utils::NewLocal<SharedArrayBuffer>(v8_isolate, sharedArrayBuffer));
+  if (index.IsNothing()) {
+    return false;
+  }
+
+  WriteTag(SerializationTag::kSharedArrayBuffer);
+  WriteVarint<uint32_t>(index.FromJust());
+  return ThrowIfOutOfMemory();
+}
+
 bool ValueSerializer::WriteArrayBufferView(
     ArrayBufferViewRef* arrayBufferView) {
   WriteTag(SerializationTag::kArrayBufferView);
@@ -432,6 +457,13 @@ bool ValueSerializer::WriteArrayBufferView(
 
 bool ValueSerializer::WriteTypedArrayObject(
     Escargot::ArrayBufferViewRef* bufferView) {
+  auto buffer = bufferView->buffer();
+  if (buffer && buffer->isSharedArrayBufferObject()) {
+    // the view shares the whole buffer, so its byte offset is kept
+    return WriteSharedArrayBuffer(buffer->asSharedArrayBufferObject()) &&
+           WriteArrayBufferView(bufferView);
+  }
+
   auto result =
       WriteArrayBuffer(bufferView->byteLength(), bufferView->rawBuffer());
   return result && WriteArrayBufferView(bufferView);
@@ -471,16 +503,14 @@ bool ValueSerializer::ThrowIfOutOfMemory() {
   return true;
 }
 
-void ValueSerializer::ThrowDataCloneError() {
+void ValueSerializer::ThrowDataCloneError(ErrorMessageType type) {
   if (delegate_) {
     delegate_->ThrowDataCloneError(Utils::NewLocal<String>(
-        lwIsolate_->toV8(),
-        ErrorMessage::createErrorStringRef(
-            ErrorMessageType::kDataCloneErrorOutOfMemory)));
+        lwIsolate_->toV8(), ErrorMessage::createErrorStringRef(type)));
   } else {
     auto esContext = lwIsolate_->GetCurrentContext()->get();
-    lwIsolate_->ScheduleThrow(ExceptionHelper::createErrorObject(
-        esContext, ErrorMessageType::kDataCloneErrorOutOfMemory));
+    lwIsolate_->ScheduleThrow(
+        ExceptionHelper::createErrorObject(esContext, type));
   }
 
   if (lwIsolate_->sholdReportPendingMessage(false)) {
@@ -599,6 +629,14 @@ OptionalRef<ValueRef> ValueDeserializer::ReadValue() {
       return OptionalRef<ValueRef>();
     }
     return OptionalRef<ValueRef>(arrayBuffer);
+  } else if (tag == SerializationTag::kSharedArrayBuffer) {
+    ValueRef* sharedArrayBuffer = nullptr;
+    if (!ReadSharedArrayBuffer(sharedArrayBuffer)) {
+      LWNODE_CALL_TRACE_ID_LOG(SERIALIZER,
+                               "Cannot read shared array buffer value");
+      return OptionalRef<ValueRef>();
+    }
+    return OptionalRef<ValueRef>(sharedArrayBuffer);
   } else {
     LWNODE_CALL_TRACE_ID_LOG(SERIALIZER, "Fail: %c", (char)tag);
     LWNODE_UNIMPLEMENT;
@@ -827,6 +865,36 @@ bool ValueDeserializer::ReadJsArrayBuffer(ValueRef*& value) {
   return true;
 }
 
+bool ValueDeserializer::ReadSharedArrayBuffer(ValueRef*& value) {
+  uint32_t index = 0;
+  if (!delegate_ || !ReadVarint<uint32_t>(index)) {
+    return false;
+  }
+
+  v8::Isolate* v8_isolate = lwIsolate_->toV8();
+  v8::Local<v8::SharedArrayBuffer> sharedArrayBuffer;
+  if (!delegate_->GetSharedArrayBufferFromId(v8_isolate, index)
+           .ToLocal(&sharedArrayBuffer)) {
+    return false;
+  }
+
+  auto esSharedArrayBuffer =
+      VAL(*sharedArrayBuffer)->value()->asSharedArrayBufferObject();
+
+  if (CheckTag(SerializationTag::kArrayBufferView)) {
+    SerializationTag tag;
+    ReadTag(tag);
+    ArrayBufferViewRef* arrayBufferView = nullptr;
+    if (!ReadArrayBufferView(arrayBufferView, esSharedArrayBuffer)) {
+      return false;
+    }
+    value = arrayBufferView;
+    return true;
+  }
+  value = esSharedArrayBuffer;
+  return true;
+}
+
 bool ValueDeserializer::ReadArrayBuffer(
     ArrayBufferObjectRef*& arrayBufferObject) {
   uint32_t length = 0;
@@ -836,7 +904,7 @@ bool ValueDeserializer::ReadArrayBuffer(
   }
 
   auto esContext = lwIsolate_->GetCurrentContext()->get();
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       esContext,
       [](ExecutionStateRef* esState, size_t byteLength) -> ValueRef* {
         auto arrayBuffer = ArrayBufferObjectRef::create(esState);
@@ -857,7 +925,7 @@ bool ValueDeserializer::ReadArrayBuffer(
 }
 
 bool ValueDeserializer::ReadArrayBufferView(
-    ArrayBufferViewRef*& arrayBufferView, ArrayBufferObjectRef* abo) {
+    ArrayBufferViewRef*& arrayBufferView, ArrayBufferRef* arrayBuffer) {
   uint8_t tag = 0;
   uint32_t byteOffset = 0;
   uint32_t arrayLength = 0;
@@ -877,7 +945,7 @@ bool ValueDeserializer::ReadArrayBufferView(
   case ArrayBufferViewTag::k##Type##Array:                                     \
     arrayBufferView = ArrayBufferHelper::createView<Type##ArrayObjectRef>(     \
         esContext,                                                             \
-        abo,                                                                   \
+        arrayBuffer,                                                           \
         byteOffset,                                                            \
         arrayLength,                                                           \
         ArrayBufferHelper::ArrayType::kExternal##Type##Array);                 \
@@ -21,6 +21,7 @@
 #include <EscargotPublic.h>
 #include <v8.h>
 
+#include "error-message.h"
 #include "utils/optional.h"
 
 using namespace Escargot;
@@ -80,11 +81,13 @@ class ValueSerializer {
   bool WriteJsArray(ArrayObjectRef* array);
   bool WriteHostObject(ObjectRef* object);
   bool WriteArrayBuffer(size_t length, uint8_t* bytes);
+  bool WriteSharedArrayBuffer(SharedArrayBufferObjectRef* sharedArrayBuffer);
   bool WriteArrayBufferView(ArrayBufferViewRef* arrayBufferView);
   bool WriteTypedArrayObject(Escargot::ArrayBufferViewRef* bufferView);
   bool ExpandBuffer(size_t required_capacity);
   bool ThrowIfOutOfMemory();
-  void ThrowDataCloneError();
+  void ThrowDataCloneError(ErrorMessageType type =
+                               ErrorMessageType::kDataCloneErrorOutOfMemory);
 
   IsolateWrap* lwIsolate_ = nullptr;
   v8::ValueSerializer::Delegate* delegate_ = nullptr;
@@ -118,8 +121,9 @@ class ValueDeserializer {
   bool ReadJsArray(ArrayObjectRef*& array);
   bool ReadJsArrayBuffer(ValueRef*& value);
   bool ReadArrayBuffer(ArrayBufferObjectRef*& arayBufferObject);
+  bool ReadSharedArrayBuffer(ValueRef*& value);
   bool ReadArrayBufferView(ArrayBufferViewRef*& arrayBufferView,
-                           ArrayBufferObjectRef* arrayBufferObject);
+                           ArrayBufferRef* arrayBuffer);
 
   bool ReadRawBytes(size_t size, const uint8_t*& data);
 
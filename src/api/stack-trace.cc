@@ -68,7 +68,7 @@ ValueRef* StackTrace::StackTraceGetter(
   auto lwIsolate = IsolateWrap::GetCurrent();
   auto lwContext = lwIsolate->GetCurrentContext();
 
-  if (!accessorData->stackTrace()) {
+  if (!accessorData->hasStackTrace()) {
     auto undefined = ValueRef::createUndefined();
     accessorData->setStackValue(undefined);
     return undefined;
@@ -80,7 +80,7 @@ ValueRef* StackTrace::StackTraceGetter(
     // 'PrepareStackTraceCallback'.
     PrepareStackTraceScope scope(lwIsolate);
     auto formattedStackTrace = lwIsolate->RunPrepareStackTraceCallback(
-        state, lwContext, self, accessorData->stackTrace());
+        state, lwContext, self, accessorData->stackTrace(state));
     if (!formattedStackTrace->isUndefined()) {
       accessorData->setStackValue(formattedStackTrace);
       return formattedStackTrace;
@@ -88,8 +88,8 @@ ValueRef* StackTrace::StackTraceGetter(
   }
 
   StackTrace stackTrace(state, self);
-  auto stackTraceString =
-      stackTrace.formatStackTraceStringNodeStyle(accessorData->stackTrace());
+  auto stackTraceString = stackTrace.formatStackTraceStringNodeStyle(
+      accessorData->stackTrace(state));
   accessorData->setStackValue(stackTraceString);
   return stackTraceString;
 }
@@ -126,51 +126,37 @@ ValueRef* StackTrace::captureStackTraceCallback(ExecutionStateRef* state,
     exceptionObject->deleteOwnProperty(state, stackString);
   }
 
-  auto callSite = IsolateWrap::GetCurrent()->GetCurrentContext()->callSite();
-  auto stackTraceData = state->computeStackTrace();
-  auto stackTraceVector = ValueVectorRef::create();
-
   ValueRef* filterFunction = nullptr;
   if (argc > 1 && argv[1]->isFunctionObject()) {
     filterFunction = argv[1];
   }
 
-  int stacktraceStartIdx = 1;
-
-  double stackTraceLimit = 0;
-  if (getStackTraceLimit(state, stackTraceLimit)) {
-    size_t maxPrintStackSize =
-        std::min(stackTraceLimit, (double)stackTraceData.size());
-    for (size_t i = 0; i < maxPrintStackSize; i++) {
-      if (StackTrace::checkFilter(filterFunction, stackTraceData[i])) {
-        if (stackTraceVector->size() > 0) {
-          stackTraceVector->erase(0, stackTraceVector->size());
-        }
-        filterFunction = nullptr;
-
-        continue;
-      }
-
-      stackTraceVector->pushBack(
-          callSite->instantiate(state->context(), stackTraceData[i]));
-    }
-  }
-
   // FIXME: it seems there are some cases where we need to freeze the
   // stack string here. Investigate further
   StackTrace stackTrace(state, exceptionObject);
-  stackTrace.addStackProperty(ArrayObjectRef::create(state, stackTraceVector));
+  auto frames =
+      stackTrace.collectFrames(state->computeStackTrace(), filterFunction);
+  stackTrace.addStackProperty(frames ? frames : new StackFrames());
 
   return ValueRef::createUndefined();
 }
 
-void StackTrace::addStackProperty(ArrayObjectRef* stackTrace) {
+void StackTrace::addStackProperty(StackFrames* frames) {
   // NOTE: either Error or Exception contains stack.
   error_->defineNativeDataAccessorProperty(
       state_,
       StringRef::createFromUTF8("stack"),
       new NativeAccessorProperty(
-          true, false, true, StackTraceGetter, StackTraceSetter, stackTrace));
+          true, false, true, StackTraceGetter, StackTraceSetter, frames));
+}
+
+ArrayObjectRef* StackTrace::NativeAccessorProperty::stackTrace(
+    ExecutionStateRef* state) {
+  if (frames_) {
+    stackTrace_ = genCallSites(state, *frames_);
+    frames_ = nullptr;
+  }
+  return stackTrace_;
 }
 
 ValueRef* StackTrace::createCaptureStackTrace(
@@ -259,25 +245,41 @@ std::string StackTrace::formatStackTraceLine(
   return oss.str();
 }
 
-ArrayObjectRef* StackTrace::genCallSites(
-    const GCManagedVector<Evaluator::StackTraceData>& stackTraceData) {
-  auto callSite = IsolateWrap::GetCurrent()->GetCurrentContext()->callSite();
-
+StackTrace::StackFrames* StackTrace::collectFrames(
+    const GCManagedVector<Evaluator::StackTraceData>& stackTraceData,
+    ValueRef* filter) {
   double stackTraceLimit = 0;
   if (!getStackTraceLimit(state_, stackTraceLimit)) {
     return nullptr;
   }
 
-  auto stackTraceVector = ValueVectorRef::create();
+  auto frames = new StackFrames();
   size_t maxPrintStackSize =
       std::min(stackTraceLimit, (double)stackTraceData.size());
 
   for (size_t i = 0; i < maxPrintStackSize; i++) {
+    if (checkFilter(filter, stackTraceData[i])) {
+      frames->clear();
+      filter = nullptr;
+      continue;
+    }
+    frames->push_back(stackTraceData[i]);
+  }
+
+  return frames;
+}
+
+ArrayObjectRef* StackTrace::genCallSites(ExecutionStateRef* state,
+                                         const StackFrames& frames) {
+  auto callSite = IsolateWrap::GetCurrent()->GetCurrentContext()->callSite();
+  auto stackTraceVector = ValueVectorRef::create();
+
+  for (size_t i = 0; i < frames.size(); i++) {
     stackTraceVector->pushBack(
-        callSite->instantiate(state_->context(), stackTraceData[i]));
+        callSite->instantiate(state->context(), frames[i]));
   }
 
-  return ArrayObjectRef::create(state_, stackTraceVector);
+  return ArrayObjectRef::create(state, stackTraceVector);
 }
 
 CallSite::CallSite(ContextRef* context) : context_(context) {
@@ -405,7 +407,7 @@ void CallSite::injectSitePrototype() {
 void CallSite::setCallSitePrototype(
     const std::string& name,
     Escargot::FunctionObjectRef::NativeFunctionPointer fn) {
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       context_,
       [](ExecutionStateRef* state,
          const std::string* name,
@@ -18,6 +18,7 @@
 
 #include <EscargotPublic.h>
 #include <GCUtil.h>
+#include "utils/gc-util.h"
 
 using namespace Escargot;
 
@@ -27,6 +28,11 @@ class StackTraceData;
 
 class StackTrace {
  public:
+  typedef GCVector<Evaluator::StackTraceData> StackFrames;
+
+  // The stack frames are kept as they are until the stack is read. CallSite
+  // objects and the stack string are created only then, since most errors are
+  // caught without their stack being read.
   class NativeAccessorProperty
       : public ObjectRef::NativeDataAccessorPropertyData {
    public:
@@ -35,13 +41,14 @@ class StackTrace {
                            bool isConfigurable,
                            ObjectRef::NativeDataAccessorPropertyGetter getter,
                            ObjectRef::NativeDataAccessorPropertySetter setter,
-                           ArrayObjectRef* stackTrace)
+                           StackFrames* frames)
         : NativeDataAccessorPropertyData(
               isWritable, isEnumerable, isConfigurable, getter, setter),
-          stackTrace_(stackTrace) {}
+          frames_(frames) {}
 
-    ArrayObjectRef* stackTrace() { return stackTrace_; }
-    void setStackTrace(ArrayObjectRef* stackTrace) { stackTrace_ = stackTrace; }
+    bool hasStackTrace() { return frames_ != nullptr || stackTrace_; }
+    // Creates the CallSite objects of the frames once.
+    ArrayObjectRef* stackTrace(ExecutionStateRef* state);
 
     ValueRef* stackValue() { return stackValue_; }
     void setStackValue(ValueRef* stackValue) { stackValue_ = stackValue; }
@@ -50,6 +57,7 @@ class StackTrace {
     void* operator new(size_t size) { return GC_MALLOC(size); }
 
    private:
+    StackFrames* frames_ = nullptr;
     ArrayObjectRef* stackTrace_ = nullptr;
     ValueRef* stackValue_ = nullptr;
   };
@@ -88,10 +96,18 @@ class StackTrace {
   static std::string formatStackTraceLine(
       const Evaluator::StackTraceData& line);
 
-  void addStackProperty(ArrayObjectRef* stackTraceVector);
+  // frames can be null if there is no stack trace.
+  void addStackProperty(StackFrames* frames);
+
+  // Returns the frames up to Error.stackTraceLimit, or null if the limit
+  // isn't a number. If filter is given, the frames above the call of filter
+  // and the call itself are skipped.
+  StackFrames* collectFrames(
+      const GCManagedVector<Evaluator::StackTraceData>& stackTraceData,
+      ValueRef* filter = nullptr);
 
-  ArrayObjectRef* genCallSites(
-      const GCManagedVector<Evaluator::StackTraceData>& stackTraceData);
+  static ArrayObjectRef* genCallSites(ExecutionStateRef* state,
+                                      const StackFrames& frames);
 
   StringRef* formatStackTraceStringNodeStyle(ArrayObjectRef* stackTrace);
 
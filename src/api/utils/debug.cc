@@ -125,7 +125,7 @@ static void printObjectProperties(ExecutionStateRef* state,
 
 void DebugUtils::printObject(ObjectRef* value, int depth) {
   auto lwIsolate = IsolateWrap::GetCurrent();
-  auto r = Evaluator::execute(
+  auto r = EvalHelper::execute(
       lwIsolate->GetCurrentContext()->get(),
       [](ExecutionStateRef* state, ObjectRef* object, int depth) -> ValueRef* {
         printObjectProperties(state, object, depth);
@@ -151,7 +151,7 @@ void DebugUtils::printObject(ObjectRef* value, int depth) {
 
 void DebugUtils::printToString(ValueRef* value) {
   auto context = IsolateWrap::GetCurrent()->GetCurrentContext()->get();
-  EvalResult r = Evaluator::execute(
+  EvalResult r = EvalHelper::execute(
       context,
       [](ExecutionStateRef* state, ValueRef* value) -> ValueRef* {
         auto valueString = value->toString(state);
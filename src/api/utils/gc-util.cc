@@ -187,6 +187,20 @@ void MemoryUtil::gcSetWarningListener(OnGCWarnEventListener callback) {
   }
 }
 
+MemoryUtil::HeapUsage MemoryUtil::gcHeapUsage() {
+  GC_word heapSize, freeBytes, unmappedBytes, bytesSinceGC, totalBytes;
+  GC_get_heap_usage_safe(
+      &heapSize, &freeBytes, &unmappedBytes, &bytesSinceGC, &totalBytes);
+
+  HeapUsage usage;
+  usage.heapSize = heapSize;
+  usage.freeBytes = freeBytes;
+  usage.unmappedBytes = unmappedBytes;
+  usage.bytesSinceGC = bytesSinceGC;
+  usage.totalBytes = totalBytes;
+  return usage;
+}
+
 void MemoryUtil::printGCStats() {
   // struct GC_prof_stats_s stats;
   // GC_get_prof_stats(&stats, sizeof(stats));
@@ -200,6 +200,16 @@ class ESCARGOT_EXPORT MemoryUtil {
   typedef void (*OnGCWarnEventListener)(WarnEventType type);
 
   static void gcSetWarningListener(OnGCWarnEventListener callback);
+
+  struct HeapUsage {
+    size_t heapSize = 0;  // excludes the unmapped bytes
+    size_t freeBytes = 0;
+    size_t unmappedBytes = 0;
+    size_t bytesSinceGC = 0;
+    size_t totalBytes = 0;  // allocated since the start
+  };
+  // This reads the counters of the collector only, so it's cheap.
+  static HeapUsage gcHeapUsage();
   static void gcPrintGCMemoryUsage(void* data);
   static void gcFull();
   static void gcInvokeFinalizers();
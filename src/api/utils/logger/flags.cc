@@ -46,6 +46,8 @@ void Flags::initFlags() {
   addFlag<FlagWithNegativeValues>("--trace-call=", Flag::Type::TraceCall, true);
   addFlag<Flag>("--internal-log", Flag::Type::InternalLog);
   addFlag<Flag>("--start-debug-server", Flag::Type::DebugServer);
+  addFlag<FlagWithValues>(
+      "--arraybuffer-pool", Flag::Type::ArrayBufferPool, true);
 }
 
 bool Flag::isPrefixOf(const std::string& name) {
@@ -91,8 +93,14 @@ void Flags::add(const std::string& userOption) {
 
   add(flag);
 
-  if (flag->type() == Flag::Type::TraceCall ||
-      flag->type() == Flag::Type::UnhandledRejections) {
+  bool hasValues = flag->type() == Flag::Type::TraceCall ||
+                   flag->type() == Flag::Type::UnhandledRejections;
+  if (flag->type() == Flag::Type::ArrayBufferPool) {
+    // the value is optional
+    hasValues = userOption.find('=') != std::string::npos;
+  }
+
+  if (hasValues) {
     std::string optionValues = userOption.substr(userOption.find_first_of('=') +
                                                  1);  // +1 for skipping '='
     auto tokens = strSplit(optionValues, ',');
@@ -137,6 +145,14 @@ bool Flags::isOn(Flag::Type type, const std::string& value) {
   return flag->hasValue(value);
 }
 
+std::set<std::string> Flags::values(Flag::Type type) {
+  Flag* flag = getFlag(type);
+  if (!flag) {
+    return {};
+  }
+  return flag->values();
+}
+
 void Flags::shrinkArgumentList(int* argc, char** argv) {
   int count = 0;
   for (int idx = 0; idx < *argc; idx++) {
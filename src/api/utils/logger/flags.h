@@ -49,6 +49,7 @@ class Flag {
     InternalLog,
     LWNodeOther,
     DebugServer,
+    ArrayBufferPool,
   };
 
   Flag(const std::string& name, Type type, bool useAsPrefix = false)
@@ -61,6 +62,7 @@ class Flag {
 
   virtual void addValue(const std::string& value){};
   virtual bool hasValue(const std::string& value) { return false; }
+  virtual std::set<std::string> values() { return {}; }
 
   virtual void addNegativeValue(const std::string& value) {}
   virtual bool hasNegativeValue(const std::string& value) { return false; }
@@ -85,6 +87,8 @@ class FlagWithValues : public Flag {
     return values_.find(value) != values_.end();
   }
 
+  virtual std::set<std::string> values() override { return values_; }
+
  private:
   std::set<std::string> values_;
 };
@@ -125,6 +129,7 @@ class LWNODE_EXPORT Flags {
   void add(Flag* flag);
 
   bool isOn(Flag::Type type, const std::string& value = "");
+  std::set<std::string> values(Flag::Type type);
   void shrinkArgumentList(int* argc, char** argv);
 
   // NOTE: get() and set() are only used in cctest
@@ -17,8 +17,11 @@
  */
 
 #include "smaps.h"
+#include <fcntl.h>
 #include <unistd.h>
 #include <cassert>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <string>
@@ -184,6 +187,98 @@ std::vector<SmapContents> parseSmaps(std::string pid) {
   return std::vector<SmapContents>();
 }
 
+// readSmapsRollup
+
+template <size_t N>
+static void readField(const char* line,
+                      const char* end,
+                      const char (&key)[N],
+                      size_t* value) {
+  // e.g) "Pss:                 374 kB"
+  if (static_cast<size_t>(end - line) < N - 1 ||
+      memcmp(line, key, N - 1) != 0) {
+    return;
+  }
+
+  size_t result = 0;
+  for (const char* p = line + N - 1; p < end; p++) {
+    if (*p >= '0' && *p <= '9') {
+      result = result * 10 + (*p - '0');
+    } else if (*p != ' ' && *p != '\t') {
+      break;
+    }
+  }
+  *value += result;
+}
+
+static void accumulateSmapsLine(const char* line,
+                                const char* end,
+                                SmapsRollup* rollup) {
+  switch (line[0]) {
+    case 'R':
+      readField(line, end, "Rss:", &rollup->rss);
+      break;
+    case 'P':
+      readField(line, end, "Pss:", &rollup->pss);
+      break;
+    case 'S':
+      readField(line, end, "Swap:", &rollup->swap);
+      readField(line, end, "SwapPss:", &rollup->swapPss);
+      break;
+  }
+}
+
+static bool accumulateSmapsFile(const std::string& path, SmapsRollup* rollup) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+
+  char buffer[4096];
+  size_t length = 0;
+  while (true) {
+    ssize_t n = read(fd, buffer + length, sizeof(buffer) - length);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    length += n;
+
+    char* line = buffer;
+    char* end = buffer + length;
+    char* newline;
+    while ((newline = static_cast<char*>(memchr(line, '\n', end - line)))) {
+      accumulateSmapsLine(line, newline, rollup);
+      line = newline + 1;
+    }
+
+    // keep the incomplete line for the next read
+    length = end - line;
+    if (length == sizeof(buffer)) {
+      length = 0;  // a line too long to be a field
+    }
+    memmove(buffer, line, length);
+  }
+  if (length > 0) {
+    accumulateSmapsLine(buffer, buffer + length, rollup);
+  }
+
+  close(fd);
+  return true;
+}
+
+bool readSmapsRollup(const std::string& pid, SmapsRollup* rollup) {
+  *rollup = SmapsRollup();
+  if (accumulateSmapsFile("/proc/" + pid + "/smaps_rollup", rollup)) {
+    return true;
+  }
+
+  *rollup = SmapsRollup();
+  return accumulateSmapsFile("/proc/" + pid + "/smaps", rollup);
+}
+
 size_t calculateTotal(std::vector<SmapContents>& smaps, const char* key) {
   size_t total = 0;
   for (auto& smap : smaps) {
@@ -52,5 +52,17 @@ enum SnapshotStringOption {
 std::string getMemorySnapshotString(std::vector<SmapContents>& smaps,
                                     SnapshotStringOption option = kShowDefault);
 
+// The totals of the memory usage of a process in kB. This reads
+// /proc/<pid>/smaps_rollup, or sums up /proc/<pid>/smaps if the kernel doesn't
+// provide it, without allocating per mapping.
+struct SmapsRollup {
+  size_t rss = 0;
+  size_t pss = 0;
+  size_t swap = 0;
+  size_t swapPss = 0;
+};
+
+bool readSmapsRollup(const std::string& pid, SmapsRollup* rollup);
+
 bool existsFile(const std::string& path);
 std::string getCurrentTimeString(std::string format = "%y%m%d-%H%M%S");
@@ -20,8 +20,15 @@
 
 #include "string-util.h"
 
+#include <cstring>
 #include <sstream>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 // Magic values subtracted from a buffer value during UTF8 conversion.
 // This table contains as many values as there might be trailing bytes
 // in a UTF-8 sequence.
@@ -53,6 +60,151 @@ bool UTF8Sequence::convertUTF8ToLatin1(
   return true;
 }
 
+// The ASCII fast paths below test a word of code units at a time.
+static const uint64_t kNonASCIIMask8 = 0x8080808080808080ULL;
+static const uint64_t kNonASCIIMask16 = 0xFF80FF80FF80FF80ULL;
+
+static inline uint64_t loadWord(const void* source) {
+  uint64_t word;
+  memcpy(&word, source, sizeof(word));
+  return word;
+}
+
+static inline bool isLeadSurrogate(char16_t c) {
+  return (c & 0xFC00) == 0xD800;
+}
+
+static inline bool isTrailSurrogate(char16_t c) {
+  return (c & 0xFC00) == 0xDC00;
+}
+
+size_t UTF8Encoder::length(const uint8_t* latin1, size_t length) {
+  // every non-ASCII Latin-1 character takes 2 bytes
+  size_t result = length;
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    result += __builtin_popcountll(loadWord(latin1 + i) & kNonASCIIMask8);
+  }
+  for (; i < length; i++) {
+    result += latin1[i] >> 7;
+  }
+  return result;
+}
+
+size_t UTF8Encoder::length(const char16_t* utf16, size_t length) {
+  size_t result = 0;
+  size_t i = 0;
+  while (i < length) {
+    if (i + 4 <= length && !(loadWord(utf16 + i) & kNonASCIIMask16)) {
+      result += 4;
+      i += 4;
+      continue;
+    }
+
+    char16_t c = utf16[i++];
+    if (c < 0x80) {
+      result += 1;
+    } else if (c < 0x800) {
+      result += 2;
+    } else if (isLeadSurrogate(c) && i < length && isTrailSurrogate(utf16[i])) {
+      result += 4;
+      i++;
+    } else {
+      result += 3;
+    }
+  }
+  return result;
+}
+
+UTF8Encoder::Result UTF8Encoder::encode(const uint8_t* latin1,
+                                        size_t length,
+                                        uint8_t* dest,
+                                        size_t capacity) {
+  size_t i = 0;
+  size_t w = 0;
+  while (i < length) {
+    if (i + 8 <= length && w + 8 <= capacity &&
+        !(loadWord(latin1 + i) & kNonASCIIMask8)) {
+      memcpy(dest + w, latin1 + i, 8);
+      i += 8;
+      w += 8;
+      continue;
+    }
+
+    uint8_t c = latin1[i];
+    if (c < 0x80) {
+      if (w + 1 > capacity) break;
+      dest[w++] = c;
+    } else {
+      if (w + 2 > capacity) break;
+      dest[w++] = 0xC0 | (c >> 6);
+      dest[w++] = 0x80 | (c & 0x3F);
+    }
+    i++;
+  }
+
+  Result result;
+  result.read = result.characters = i;
+  result.written = w;
+  return result;
+}
+
+UTF8Encoder::Result UTF8Encoder::encode(const char16_t* utf16,
+                                        size_t length,
+                                        uint8_t* dest,
+                                        size_t capacity,
+                                        bool replaceInvalid) {
+  size_t i = 0;
+  size_t w = 0;
+  size_t characters = 0;
+  while (i < length) {
+    if (i + 4 <= length && w + 4 <= capacity &&
+        !(loadWord(utf16 + i) & kNonASCIIMask16)) {
+      for (int k = 0; k < 4; k++) {
+        dest[w++] = static_cast<uint8_t>(utf16[i++]);
+      }
+      characters += 4;
+      continue;
+    }
+
+    uint32_t c = utf16[i];
+    size_t units = 1;
+    if (c < 0x80) {
+      if (w + 1 > capacity) break;
+      dest[w++] = c;
+    } else if (c < 0x800) {
+      if (w + 2 > capacity) break;
+      dest[w++] = 0xC0 | (c >> 6);
+      dest[w++] = 0x80 | (c & 0x3F);
+    } else if (isLeadSurrogate(c) && i + 1 < length &&
+               isTrailSurrogate(utf16[i + 1])) {
+      if (w + 4 > capacity) break;
+      c = 0x10000 + ((c - 0xD800) << 10) + (utf16[i + 1] - 0xDC00);
+      dest[w++] = 0xF0 | (c >> 18);
+      dest[w++] = 0x80 | ((c >> 12) & 0x3F);
+      dest[w++] = 0x80 | ((c >> 6) & 0x3F);
+      dest[w++] = 0x80 | (c & 0x3F);
+      units = 2;
+    } else {
+      if (w + 3 > capacity) break;
+      if (replaceInvalid && (isLeadSurrogate(c) || isTrailSurrogate(c))) {
+        c = 0xFFFD;
+      }
+      dest[w++] = 0xE0 | (c >> 12);
+      dest[w++] = 0x80 | ((c >> 6) & 0x3F);
+      dest[w++] = 0x80 | (c & 0x3F);
+    }
+    i += units;
+    characters++;
+  }
+
+  Result result;
+  result.read = i;
+  result.written = w;
+  result.characters = characters;
+  return result;
+}
+
 std::vector<std::string> strSplit(const std::string& str, char delimiter) {
   std::vector<std::string> tokens;
   std::stringstream ss(str);
@@ -64,3 +216,95 @@ std::vector<std::string> strSplit(const std::string& str, char delimiter) {
 
   return tokens;
 }
+
+// --- StringEncoding ---
+
+StringEncoding::Type StringEncoding::classify(const uint8_t* latin1,
+                                              size_t length) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 16 <= length; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(latin1 + i));
+    if (_mm_movemask_epi8(v)) {
+      return kLatin1;
+    }
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 16 <= length; i += 16) {
+    uint8x16_t v = vld1q_u8(latin1 + i);
+    uint8x8_t high = vorr_u8(vget_low_u8(v), vget_high_u8(v));
+    if (vget_lane_u64(vreinterpret_u64_u8(high), 0) & kNonASCIIMask8) {
+      return kLatin1;
+    }
+  }
+#endif
+  for (; i + 8 <= length; i += 8) {
+    if (loadWord(latin1 + i) & kNonASCIIMask8) {
+      return kLatin1;
+    }
+  }
+  for (; i < length; i++) {
+    if (latin1[i] & 0x80) {
+      return kLatin1;
+    }
+  }
+  return kAscii;
+}
+
+StringEncoding::Type StringEncoding::classify(const char16_t* utf16,
+                                              size_t length) {
+  // the bits of all code units seen so far; a surrogate ends the scan since
+  // it's the widest class
+  uint16_t bits = 0;
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i surrogateMask = _mm_set1_epi16(static_cast<short>(0xF800));
+  const __m128i surrogateBits = _mm_set1_epi16(static_cast<short>(0xD800));
+  __m128i accumulated = _mm_setzero_si128();
+  for (; i + 8 <= length; i += 8) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf16 + i));
+    __m128i surrogates =
+        _mm_cmpeq_epi16(_mm_and_si128(v, surrogateMask), surrogateBits);
+    if (_mm_movemask_epi8(surrogates)) {
+      return kHasSurrogates;
+    }
+    accumulated = _mm_or_si128(accumulated, v);
+  }
+  accumulated = _mm_or_si128(accumulated, _mm_srli_si128(accumulated, 8));
+  accumulated = _mm_or_si128(accumulated, _mm_srli_si128(accumulated, 4));
+  accumulated = _mm_or_si128(accumulated, _mm_srli_si128(accumulated, 2));
+  bits = static_cast<uint16_t>(_mm_cvtsi128_si32(accumulated));
+#elif defined(__ARM_NEON)
+  const uint16x8_t surrogateMask = vdupq_n_u16(0xF800);
+  const uint16x8_t surrogateBits = vdupq_n_u16(0xD800);
+  uint16x8_t accumulated = vdupq_n_u16(0);
+  for (; i + 8 <= length; i += 8) {
+    uint16x8_t v = vld1q_u16(reinterpret_cast<const uint16_t*>(utf16 + i));
+    uint16x8_t surrogates =
+        vceqq_u16(vandq_u16(v, surrogateMask), surrogateBits);
+    uint16x4_t folded =
+        vorr_u16(vget_low_u16(surrogates), vget_high_u16(surrogates));
+    if (vget_lane_u64(vreinterpret_u64_u16(folded), 0)) {
+      return kHasSurrogates;
+    }
+    accumulated = vorrq_u16(accumulated, v);
+  }
+  uint16x4_t folded =
+      vorr_u16(vget_low_u16(accumulated), vget_high_u16(accumulated));
+  folded = vorr_u16(folded, vext_u16(folded, folded, 2));
+  folded = vorr_u16(folded, vext_u16(folded, folded, 1));
+  bits = vget_lane_u16(folded, 0);
+#endif
+  for (; i < length; i++) {
+    char16_t c = utf16[i];
+    if ((c & 0xF800) == 0xD800) {
+      return kHasSurrogates;
+    }
+    bits |= c;
+  }
+
+  if (bits & 0xFF00) {
+    return kTwoByte;
+  }
+  return (bits & 0x80) ? kLatin1 : kAscii;
+}
@@ -118,3 +118,47 @@ class UTF8Sequence {
  private:
   static const uint32_t s_offsetsFromUTF8[6];
 };
+
+// Transcodes the content of an 8-bit (Latin-1) or a 16-bit (UTF-16) string to
+// UTF-8 in a single pass, without an intermediate copy. Lone surrogates are
+// encoded as 3 bytes, or as U+FFFD if replaceInvalid is set.
+class UTF8Encoder {
+ public:
+  struct Result {
+    size_t read = 0;        // code units consumed from the source
+    size_t written = 0;     // bytes written to the destination
+    size_t characters = 0;  // code points written
+  };
+
+  static size_t length(const uint8_t* latin1, size_t length);
+  static size_t length(const char16_t* utf16, size_t length);
+
+  // Encodes as many whole code points as fit in the capacity.
+  static Result encode(const uint8_t* latin1,
+                       size_t length,
+                       uint8_t* dest,
+                       size_t capacity);
+  static Result encode(const char16_t* utf16,
+                       size_t length,
+                       uint8_t* dest,
+                       size_t capacity,
+                       bool replaceInvalid);
+};
+
+// Classifies the content of a string buffer by the narrowest encoding that
+// can hold it. The scanners use SSE2 or NEON where the target has them, and
+// fall back to testing a word of code units at a time.
+class StringEncoding {
+ public:
+  enum Type : uint8_t {
+    kAscii,          // every code unit < 0x80
+    kLatin1,         // every code unit < 0x100
+    kTwoByte,        // some code unit >= 0x100, no surrogates
+    kHasSurrogates,  // some code unit in [0xD800, 0xDFFF]
+  };
+
+  static Type classify(const uint8_t* latin1, size_t length);
+  static Type classify(const char16_t* utf16, size_t length);
+
+  static bool isOneByte(Type type) { return type <= kLatin1; }
+};
@@ -15,6 +15,8 @@
  */
 
 #include "lwnode-gc-strategy.h"
+#include <GCUtil.h>
+#include <algorithm>
 #include <thread>
 #include "lwnode.h"
 
@@ -24,6 +26,10 @@ static TimePoint getCurrentTime() {
   return std::chrono::system_clock::now();
 }
 
+static size_t usedHeapSize() {
+  return GC_get_heap_size() - GC_get_free_bytes();
+}
+
 bool DelayedGC::canScheduleGC() {
   // condition (a)
   if (isLastCallChecked_ == true) {
@@ -72,4 +78,103 @@ void EveryTickGC::handle(v8::Isolate* isolate) {
   IdleGC(isolate);
 }
 
+PressureAwareGC::PressureAwareGC(std::unique_ptr<GCStrategyInterface> strategy)
+    : strategy_(std::move(strategy)),
+      defaultFreeSpaceDivisor_(GC_get_free_space_divisor()) {}
+
+bool PressureAwareGC::canScheduleGC() {
+  return pendingLevel_ != static_cast<int>(v8::MemoryPressureLevel::kNone) ||
+         strategy_->canScheduleGC();
+}
+
+void PressureAwareGC::notify(v8::MemoryPressureLevel level) {
+  int newLevel = static_cast<int>(level);
+  int oldLevel = pendingLevel_.load();
+  while (oldLevel < newLevel &&
+         !pendingLevel_.compare_exchange_weak(oldLevel, newLevel)) {
+  }
+
+  if (level != v8::MemoryPressureLevel::kNone) {
+    MessageLoop::GetInstance()->wakeupMainloopOnce();
+  }
+}
+
+v8::MemoryPressureLevel PressureAwareGC::levelFromHeapSize() {
+  if (thresholds_.moderateHeapSize == 0 && thresholds_.criticalHeapSize == 0) {
+    return v8::MemoryPressureLevel::kNone;
+  }
+
+  size_t used = usedHeapSize();
+  if (thresholds_.criticalHeapSize > 0 &&
+      used >= thresholds_.criticalHeapSize) {
+    return v8::MemoryPressureLevel::kCritical;
+  }
+  if (thresholds_.moderateHeapSize > 0 &&
+      used >= thresholds_.moderateHeapSize) {
+    return v8::MemoryPressureLevel::kModerate;
+  }
+  return v8::MemoryPressureLevel::kNone;
+}
+
+bool PressureAwareGC::isHeapGCDue() {
+  size_t minBytesSinceGC =
+      std::max(kMinBytesSinceGC, usedAfterLastGC_ / kHeapGrowthDivisor);
+  if (GC_get_bytes_since_gc() < minBytesSinceGC) {
+    return false;
+  }
+  return MilliSecondTick(getCurrentTime() - lastGCTime_).count() >=
+         thresholds_.minHeapGCInterval;
+}
+
+void PressureAwareGC::setUnderPressure(bool underPressure) {
+  if (isUnderPressure_ == underPressure) {
+    return;
+  }
+
+  isUnderPressure_ = underPressure;
+  GC_set_free_space_divisor(underPressure
+                                ? thresholds_.pressureFreeSpaceDivisor
+                                : defaultFreeSpaceDivisor_);
+}
+
+void PressureAwareGC::handle(v8::Isolate* isolate) {
+  auto level = static_cast<v8::MemoryPressureLevel>(pendingLevel_.exchange(
+      static_cast<int>(v8::MemoryPressureLevel::kNone)));
+  auto heapLevel = levelFromHeapSize();
+
+  // a notified pressure is always handled, but the heap thresholds wait for
+  // the heap to grow since the last collection
+  if (level == v8::MemoryPressureLevel::kNone &&
+      (heapLevel == v8::MemoryPressureLevel::kNone || !isHeapGCDue())) {
+    setUnderPressure(heapLevel != v8::MemoryPressureLevel::kNone);
+    strategy_->handle(isolate);
+    return;
+  }
+
+  if (heapLevel > level) {
+    level = heapLevel;
+  }
+  setUnderPressure(true);
+
+  Event event;
+  event.level = level;
+  event.usedBefore = usedHeapSize();
+  IdleGC(isolate);
+  event.usedAfter = usedHeapSize();
+  event.time = getCurrentTime();
+  usedAfterLastGC_ = event.usedAfter;
+  lastGCTime_ = event.time;
+
+  if (events_.size() == kMaxEvents) {
+    events_.pop_front();
+  }
+  events_.push_back(event);
+}
+
+std::vector<PressureAwareGC::Event> PressureAwareGC::takeEvents() {
+  std::vector<Event> events(events_.begin(), events_.end());
+  events_.clear();
+  return events;
+}
+
 }  // namespace LWNode
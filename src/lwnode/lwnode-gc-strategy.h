@@ -19,6 +19,9 @@
 #include <v8.h>
 #include <atomic>
 #include <chrono>
+#include <deque>
+#include <memory>
+#include <vector>
 
 namespace LWNode {
 
@@ -65,4 +68,70 @@ class EveryTickGC : public GCStrategyInterface {
   void handle(v8::Isolate* isolate) override;
 };
 
+class PressureAwareGC : public GCStrategyInterface {
+  /*
+    @note Pressure Aware GC Strategy:
+    Garbage collection will be conducted right away on the main loop when :
+      - (a) memory pressure is notified, e.g. by
+            Isolate::MemoryPressureNotification or by the embedder
+      - (b) the used GC heap exceeds one of the thresholds, and the heap
+            has grown by a quarter of what survived the last collection
+            (at least kMinBytesSinceGC) and `minHeapGCInterval` ms have
+            passed since then. Without the growth and the interval, a heap
+            whose live data is above a threshold would be collected on every
+            iteration of the loop.
+    While under pressure, the free space divisor of the collector is raised to
+    keep the heap small. Otherwise, the given strategy handles GC.
+  */
+
+ public:
+  struct Thresholds {
+    size_t moderateHeapSize{0};  // bytes, 0 means no threshold
+    size_t criticalHeapSize{0};
+    unsigned pressureFreeSpaceDivisor{8};
+    unsigned minHeapGCInterval{1000};  // ms
+  };
+
+  struct Event {
+    v8::MemoryPressureLevel level;
+    size_t usedBefore;  // used bytes of the GC heap
+    size_t usedAfter;
+    TimePoint time;
+  };
+
+  PressureAwareGC(std::unique_ptr<GCStrategyInterface> strategy);
+
+  bool canScheduleGC() override;
+  void handle(v8::Isolate* isolate) override;
+
+  // This can be called from any thread.
+  void notify(v8::MemoryPressureLevel level);
+
+  void setThresholds(const Thresholds& thresholds) { thresholds_ = thresholds; }
+  const Thresholds& thresholds() const { return thresholds_; }
+
+  // Returns the events that happened since the last call.
+  std::vector<Event> takeEvents();
+
+ private:
+  static constexpr size_t kMaxEvents{16};
+  static constexpr size_t kMinBytesSinceGC{1024 * 1024};
+  static constexpr size_t kHeapGrowthDivisor{4};
+
+  v8::MemoryPressureLevel levelFromHeapSize();
+  bool isHeapGCDue();
+  void setUnderPressure(bool underPressure);
+
+  std::unique_ptr<GCStrategyInterface> strategy_;
+  std::atomic<int> pendingLevel_{
+      static_cast<int>(v8::MemoryPressureLevel::kNone)};
+  Thresholds thresholds_;
+  bool isUnderPressure_{false};
+  // the used bytes and the time after the last collection done here
+  size_t usedAfterLastGC_{0};
+  TimePoint lastGCTime_;
+  unsigned defaultFreeSpaceDivisor_{0};
+  std::deque<Event> events_;
+};
+
 }  // namespace LWNode
@@ -39,7 +39,7 @@ static void SetMethod(ContextRef* context,
                       ObjectRef* target,
                       std::string name,
                       NativeFunctionPointer nativeFunction) {
-  Evaluator::execute(
+  EvalHelper::execute(
       context,
       [](ExecutionStateRef* state,
          ObjectRef* target,
@@ -96,14 +96,19 @@ bool dumpSelfMemorySnapshot() {
   return dumpMemorySnapshot(createDumpFilePath(), smaps);
 }
 
+// The usage probes only need the totals, so they don't parse every mapping.
+static SmapsRollup getSelfSmapsRollup() {
+  SmapsRollup rollup;
+  readSmapsRollup("self", &rollup);
+  return rollup;
+}
+
 static ValueRef* PssUsage(ExecutionStateRef* state,
                           ValueRef* thisValue,
                           size_t argc,
                           ValueRef** argv,
                           bool isConstructCall) {
-  auto& smaps = getSelfSmaps();
-  size_t total = calculateTotal(smaps, kPss);
-  return ValueRef::create(total);
+  return ValueRef::create(getSelfSmapsRollup().pss);
 };
 
 static ValueRef* PssSwapUsage(ExecutionStateRef* state,
@@ -111,9 +116,8 @@ static ValueRef* PssSwapUsage(ExecutionStateRef* state,
                               size_t argc,
                               ValueRef** argv,
                               bool isConstructCall) {
-  auto& smaps = getSelfSmaps();
-  size_t total = calculateTotalPssSwap(smaps);
-  return ValueRef::create(total);
+  auto rollup = getSelfSmapsRollup();
+  return ValueRef::create(rollup.pss + rollup.swap);
 };
 
 static ValueRef* RssUsage(ExecutionStateRef* state,
@@ -121,9 +125,7 @@ static ValueRef* RssUsage(ExecutionStateRef* state,
                           size_t argc,
                           ValueRef** argv,
                           bool isConstructCall) {
-  auto& smaps = getSelfSmaps();
-  size_t total = calculateTotalRss(smaps);
-  return ValueRef::create(total);
+  return ValueRef::create(getSelfSmapsRollup().rss);
 };
 
 static ValueRef* MemSnapshot(ExecutionStateRef* state,
@@ -188,6 +190,242 @@ static ValueRef* getGCMemoryStats(ExecutionStateRef* state,
   return ValueRef::create(object);
 }
 
+static ObjectRef* createApiSymbolStats(ContextRef* context,
+                                       const ApiSymbolRegistry& registry) {
+  auto stats = registry.stats();
+  auto object = ObjectRefHelper::create(context);
+
+  ObjectRefHelper::setProperty(context,
+                               object,
+                               StringRef::createFromASCII("size"),
+                               ValueRef::create(stats.size))
+      .check();
+
+  ObjectRefHelper::setProperty(context,
+                               object,
+                               StringRef::createFromASCII("lookups"),
+                               ValueRef::create(stats.lookups))
+      .check();
+
+  ObjectRefHelper::setProperty(context,
+                               object,
+                               StringRef::createFromASCII("hits"),
+                               ValueRef::create(stats.hits))
+      .check();
+
+  return object;
+}
+
+static ValueRef* getApiSymbolStats(ExecutionStateRef* state,
+                                   ValueRef* thisValue,
+                                   size_t argc,
+                                   ValueRef** argv,
+                                   bool isConstructCall) {
+  auto lwIsolate = IsolateWrap::GetCurrent();
+  auto context = state->context();
+  auto object = ObjectRefHelper::create(context);
+
+  ObjectRefHelper::setProperty(
+      context,
+      object,
+      StringRef::createFromASCII("symbols"),
+      createApiSymbolStats(context, lwIsolate->apiSymbols()))
+      .check();
+
+  ObjectRefHelper::setProperty(
+      context,
+      object,
+      StringRef::createFromASCII("privateSymbols"),
+      createApiSymbolStats(context, lwIsolate->apiPrivateSymbols()))
+      .check();
+
+  return ValueRef::create(object);
+}
+
+static ValueRef* getArrayBufferStats(ExecutionStateRef* state,
+                                     ValueRef* thisValue,
+                                     size_t argc,
+                                     ValueRef** argv,
+                                     bool isConstructCall) {
+  auto decorator = IsolateWrap::GetCurrent()->arrayBufferDecorator_;
+  auto context = state->context();
+  auto object = ObjectRefHelper::create(context);
+
+  auto setProperty = [&](const char* name, size_t value) {
+    ObjectRefHelper::setProperty(context,
+                                 object,
+                                 StringRef::createFromASCII(name),
+                                 ValueRef::create(value))
+        .check();
+  };
+
+  setProperty("currentBytes", decorator->currentMemorySize());
+  setProperty("peakBytes", decorator->peakMemorySize());
+
+  if (auto pool = ArrayBufferPool::instance()) {
+    auto statistics = pool->statistics();
+    setProperty("poolMaxSize", statistics.maxPooledSize);
+    setProperty("poolInUseBytes", statistics.inUseBytes);
+    setProperty("poolSlabBytes", statistics.slabBytes);
+  }
+
+  return ValueRef::create(object);
+}
+
+static ValueRef* getGCPauseStats(ExecutionStateRef* state,
+                                 ValueRef* thisValue,
+                                 size_t argc,
+                                 ValueRef** argv,
+                                 bool isConstructCall) {
+  auto tracker = IsolateWrap::GetCurrent()->gcEventTracker();
+  auto context = state->context();
+  auto object = ObjectRefHelper::create(context);
+  const auto& stats = tracker->stats();
+
+  auto setProperty = [&](ObjectRef* target, const char* name, ValueRef* value) {
+    ObjectRefHelper::setProperty(
+        context, target, StringRef::createFromASCII(name), value)
+        .check();
+  };
+
+  auto toValue = [](uint64_t value) {
+    return ValueRef::create(static_cast<double>(value));
+  };
+
+  setProperty(object, "count", toValue(stats.count));
+  setProperty(object, "totalPauseMicros", toValue(stats.totalPauseMicros));
+  setProperty(object, "maxPauseMicros", toValue(stats.maxPauseMicros));
+  setProperty(object, "lastPauseMicros", toValue(stats.lastPauseMicros));
+  setProperty(object, "lastReclaimedBytes", toValue(stats.lastReclaimedBytes));
+  setProperty(
+      object, "totalReclaimedBytes", toValue(stats.totalReclaimedBytes));
+  setProperty(object,
+              "lastReason",
+              StringRef::createFromASCII(
+                  GCEventTracker::reasonName(stats.lastReason)));
+
+  auto reasons = ObjectRefHelper::create(context);
+  for (size_t i = 0;
+       i < static_cast<size_t>(GCEventTracker::Reason::kCount);
+       i++) {
+    setProperty(reasons,
+                GCEventTracker::reasonName(
+                    static_cast<GCEventTracker::Reason>(i)),
+                toValue(stats.countByReason[i]));
+  }
+  setProperty(object, "countByReason", reasons);
+
+  // histogram[i] counts the pauses in [2^(i-1), 2^i) microseconds
+  auto histogram = ValueVectorRef::create();
+  for (size_t i = 0; i < GCEventTracker::kHistogramSize; i++) {
+    histogram->pushBack(toValue(stats.histogram[i]));
+  }
+  setProperty(object, "histogram", ArrayObjectRef::create(state, histogram));
+
+  return ValueRef::create(object);
+}
+
+static const char* toMemoryPressureLevelString(v8::MemoryPressureLevel level) {
+  switch (level) {
+    case v8::MemoryPressureLevel::kNone:
+      return "none";
+    case v8::MemoryPressureLevel::kModerate:
+      return "moderate";
+    case v8::MemoryPressureLevel::kCritical:
+      return "critical";
+  }
+  return "none";
+}
+
+// notifyMemoryPressure(level: 'moderate' | 'critical')
+static ValueRef* notifyMemoryPressure(ExecutionStateRef* state,
+                                      ValueRef* thisValue,
+                                      size_t argc,
+                                      ValueRef** argv,
+                                      bool isConstructCall) {
+  auto level = v8::MemoryPressureLevel::kModerate;
+  if (argc > 0 && argv[0]->isString()) {
+    auto name = argv[0]->asString()->toStdUTF8String();
+    if (name == "critical") {
+      level = v8::MemoryPressureLevel::kCritical;
+    } else if (name == "none") {
+      level = v8::MemoryPressureLevel::kNone;
+    }
+  }
+  MessageLoop::GetInstance()->notifyMemoryPressure(level);
+  return ValueRef::createUndefined();
+}
+
+// setMemoryPressureThresholds(moderate: bytes, critical: bytes, divisor,
+//                             minHeapGCInterval: ms)
+static ValueRef* setMemoryPressureThresholds(ExecutionStateRef* state,
+                                             ValueRef* thisValue,
+                                             size_t argc,
+                                             ValueRef** argv,
+                                             bool isConstructCall) {
+  auto gcStrategy = MessageLoop::GetInstance()->pressureAwareGC();
+  auto thresholds = gcStrategy->thresholds();
+
+  if (argc > 0 && argv[0]->isNumber()) {
+    thresholds.moderateHeapSize = argv[0]->asNumber();
+  }
+  if (argc > 1 && argv[1]->isNumber()) {
+    thresholds.criticalHeapSize = argv[1]->asNumber();
+  }
+  if (argc > 2 && argv[2]->isNumber() && argv[2]->asNumber() >= 1) {
+    thresholds.pressureFreeSpaceDivisor = argv[2]->asNumber();
+  }
+  if (argc > 3 && argv[3]->isNumber() && argv[3]->asNumber() >= 0) {
+    thresholds.minHeapGCInterval = argv[3]->asNumber();
+  }
+
+  gcStrategy->setThresholds(thresholds);
+  return ValueRef::createUndefined();
+}
+
+static ValueRef* getMemoryPressureEvents(ExecutionStateRef* state,
+                                         ValueRef* thisValue,
+                                         size_t argc,
+                                         ValueRef** argv,
+                                         bool isConstructCall) {
+  auto context = state->context();
+  auto events = MessageLoop::GetInstance()->pressureAwareGC()->takeEvents();
+  auto eventVector = ValueVectorRef::create();
+
+  for (auto& event : events) {
+    auto object = ObjectRefHelper::create(context);
+    auto level = toMemoryPressureLevelString(event.level);
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    event.time.time_since_epoch())
+                    .count();
+
+    ObjectRefHelper::setProperty(context,
+                                 object,
+                                 StringRef::createFromASCII("level"),
+                                 StringRef::createFromASCII(level))
+        .check();
+    ObjectRefHelper::setProperty(context,
+                                 object,
+                                 StringRef::createFromASCII("usedBefore"),
+                                 ValueRef::create(event.usedBefore))
+        .check();
+    ObjectRefHelper::setProperty(context,
+                                 object,
+                                 StringRef::createFromASCII("usedAfter"),
+                                 ValueRef::create(event.usedAfter))
+        .check();
+    ObjectRefHelper::setProperty(context,
+                                 object,
+                                 StringRef::createFromASCII("time"),
+                                 ValueRef::create(static_cast<double>(time)))
+        .check();
+
+    eventVector->pushBack(object);
+  }
+
+  return ArrayObjectRef::create(state, eventVector);
+}
+
 static ValueRef* checkIfHandledAsOneByteString(ExecutionStateRef* state,
                                                ValueRef* thisValue,
                                                size_t argc,
@@ -233,7 +471,17 @@ void InitializeProcessMethods(Local<Object> target, Local<Context> context) {
             CreateReloadableSourceFromFile);
 #endif
   SetMethod(esContext, esTarget, "getGCMemoryStats", getGCMemoryStats);
+  SetMethod(esContext, esTarget, "getApiSymbolStats", getApiSymbolStats);
+  SetMethod(esContext, esTarget, "getArrayBufferStats", getArrayBufferStats);
+  SetMethod(esContext, esTarget, "getGCPauseStats", getGCPauseStats);
   SetMethod(esContext, esTarget, "hasSystemInfo", hasSystemInfo);
+  SetMethod(esContext, esTarget, "notifyMemoryPressure", notifyMemoryPressure);
+  SetMethod(esContext,
+            esTarget,
+            "setMemoryPressureThresholds",
+            setMemoryPressureThresholds);
+  SetMethod(
+      esContext, esTarget, "getMemoryPressureEvents", getMemoryPressureEvents);
 }
 
 void IdleGC(v8::Isolate* isolate) {
@@ -241,8 +489,14 @@ void IdleGC(v8::Isolate* isolate) {
   if (isolate) {
     IsolateWrap::fromV8(isolate)->vmInstance()->enterIdleMode();
   }
-  Escargot::Memory::gc();
+  {
+    GCEventTracker::ReasonScope scope(isolate, GCEventTracker::Reason::kIdle);
+    Escargot::Memory::gc();
+  }
   malloc_trim(0);
+  if (auto pool = ArrayBufferPool::instance()) {
+    pool->trim();
+  }
 }
 
 void initDebugger() {
@@ -254,11 +508,15 @@ void initDebugger() {
 
 class MessageLoop::Internal {
  public:
-  Internal() { gcStrategy_ = std::make_unique<DelayedGC>(); }
+  Internal() {
+    gcStrategy_ =
+        std::make_unique<PressureAwareGC>(std::make_unique<DelayedGC>());
+  }
   void handleGC(v8::Isolate* isolate) { gcStrategy_->handle(isolate); }
+  PressureAwareGC* gcStrategy() { return gcStrategy_.get(); }
 
  private:
-  std::unique_ptr<GCStrategyInterface> gcStrategy_;
+  std::unique_ptr<PressureAwareGC> gcStrategy_;
 };
 
 MessageLoop::MessageLoop() {
@@ -282,6 +540,21 @@ void MessageLoop::wakeupMainloopOnce() {
 
 void MessageLoop::onPrepare(v8::Isolate* isolate) {
   internal_->handleGC(isolate);
+
+  // finalize the weak handles left by the last GC a slice at a time, and
+  // come back on the next iteration if some are left
+  auto globalHandles = IsolateWrap::fromV8(isolate)->global_handles();
+  if (globalHandles->processPendingFinalizers()) {
+    wakeupMainloopOnce();
+  }
+}
+
+void MessageLoop::notifyMemoryPressure(v8::MemoryPressureLevel level) {
+  internal_->gcStrategy()->notify(level);
+}
+
+PressureAwareGC* MessageLoop::pressureAwareGC() {
+  return internal_->gcStrategy();
 }
 
 Escargot::ContextRef* Utils::ToEsContext(v8::Context* context) {
@@ -38,5 +38,33 @@
         'cctest/test-strings.cc',
       ]
     },
+    {
+      # micro benchmarks; they print their numbers and aren't run by CI
+      'target_name': 'cctest_bench',
+      'type': 'executable',
+      'dependencies': [
+        './cctest/gtest/gtest.gyp:gtest',
+        '../escargotshim.gyp:escargotshim',
+        '../escargot.gyp:escargot',
+       ],
+      'defines': [
+         'GTEST_DONT_DEFINE_TEST=1',
+         'CCTEST_ENGINE_ESCARGOT=1',
+       ],
+      'cflags_cc': [
+        '-Wno-unused-parameter',
+        '-Wno-unused-result',
+        '-Wno-sign-compare',
+        '-std=c++14',
+      ],
+      'include_dirs': [
+        './cctest',
+        '../src',
+      ],
+      'sources': [
+        'cctest/cctest.cc',
+        'cctest/bench-internal.cc',
+      ]
+    },
   ],
 }
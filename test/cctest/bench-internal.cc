@@ -0,0 +1,471 @@
+/*
+ * Copyright (c) 2021-present Samsung Electronics Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Micro benchmarks of the shim. They are built as the cctest_bench target,
+// apart from cctest, and print their numbers instead of asserting on them:
+//
+//   out/cctest/out/Release/cctest_bench -f=bench_FunctionDispatch
+
+#include "cctest.h"
+
+#include <EscargotPublic.h>
+#include "api/context.h"
+#include "api/handlescope.h"
+#include "api/isolate.h"
+#include "internal-api.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "api/function.h"
+#include "api/utils/smaps.h"
+
+using namespace Escargot;
+using namespace EscargotShim;
+
+// Runs |body| |count| times and returns the average time in nanoseconds.
+template <typename F>
+static double measureNanos(int count, F&& body) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; i++) {
+    body(i);
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / count;
+}
+
+// Returns the average time of a run of |source|, which makes |count| calls.
+static double measureScriptNanos(int count, const char* source) {
+  auto start = std::chrono::steady_clock::now();
+  CompileRun(source);
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / count;
+}
+
+static const int kCount = 1000000;
+
+static void HandleArenaCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  auto isolate = info.GetIsolate();
+  v8::HandleScope scope(isolate);
+  for (int i = 0; i < 8; i++) {
+    v8::Integer::New(isolate, i);
+  }
+  info.GetReturnValue().Set(v8::Integer::New(isolate, info.Length()));
+}
+
+TEST(bench_HandleArena) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+
+  auto function = v8::FunctionTemplate::New(isolate, HandleArenaCallback)
+                      ->GetFunction(env.local())
+                      .ToLocalChecked();
+  env->Global()->Set(env.local(), v8_str("f"), function).FromJust();
+  CompileRun("function loop(n) { for (let i = 0; i < n; i++) f(i); }");
+  size_t before = GC_get_total_bytes();
+  double callback = measureScriptNanos(kCount, "loop(1000000)");
+  size_t callbackBytes = (GC_get_total_bytes() - before) / kCount;
+  printf("callback with 8 locals: %.1f ns, %zu GC bytes\n",
+         callback,
+         callbackBytes);
+
+  // compare creating 8 locals per scope with creating 8 heap handles
+  before = GC_get_total_bytes();
+  double arena = measureNanos(kCount, [&](int) {
+    v8::HandleScope inner(isolate);
+    for (int j = 0; j < 8; j++) {
+      v8::Integer::New(isolate, j);
+    }
+  });
+  size_t arenaBytes = (GC_get_total_bytes() - before) / kCount;
+
+  before = GC_get_total_bytes();
+  double heap = measureNanos(kCount, [&](int) {
+    v8::HandleScope inner(isolate);
+    for (int j = 0; j < 8; j++) {
+      ValueWrap::createValue(ValueRef::create(j));
+    }
+  });
+  size_t heapBytes = (GC_get_total_bytes() - before) / kCount;
+
+  printf("scope of 8 handles: %.1f ns, %zu GC bytes (arena) "
+         "%.1f ns, %zu GC bytes (heap)\n",
+         arena,
+         arenaBytes,
+         heap,
+         heapBytes);
+}
+
+static void ArgumentCountCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  info.GetReturnValue().Set(info.Length());
+}
+
+TEST(bench_CallbackInfo) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+  auto lwIsolate = IsolateWrap::fromV8(isolate);
+
+  const int kMaxArgc = FunctionCallbackInfoWrap::kInlineArgsLength + 4;
+  ValueRef* argv[kMaxArgc];
+  for (int i = 0; i < kMaxArgc; i++) {
+    argv[i] = ValueRef::create(i);
+  }
+  auto esThis = reinterpret_cast<ValueWrap*>(*env->Global())->value();
+
+  const int kArgcs[] = {
+      0, 3, FunctionCallbackInfoWrap::kInlineArgsLength, kMaxArgc};
+  for (int argc : kArgcs) {
+    size_t before = GC_get_total_bytes();
+    double nanos = measureNanos(kCount, [&](int) {
+      HandleScopeWrapGuard handleScope(lwIsolate);
+      FunctionCallbackInfoWrap info(isolate,
+                                    esThis,
+                                    esThis,
+                                    OptionalRef<ObjectRef>(),
+                                    lwIsolate->undefined_value(),
+                                    argc,
+                                    argv);
+    });
+    printf("argc %d: %.1f ns, %zu GC bytes per callback info\n",
+           argc,
+           nanos,
+           (GC_get_total_bytes() - before) / kCount);
+  }
+
+  // the overhead of calling a native function from JavaScript
+  auto function = v8::FunctionTemplate::New(isolate, ArgumentCountCallback)
+                      ->GetFunction(env.local())
+                      .ToLocalChecked();
+  env->Global()->Set(env.local(), v8_str("f"), function).FromJust();
+  CompileRun("function loop(n) { for (let i = 0; i < n; i++) f(i, i, i); }");
+  printf("native call: %.1f ns\n",
+         measureScriptNanos(kCount, "loop(1000000)"));
+}
+
+TEST(bench_PrivateValues) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  auto context = env.local();
+  v8::HandleScope scope(isolate);
+
+  auto objectTemplate = v8::ObjectTemplate::New(isolate);
+  objectTemplate->SetInternalFieldCount(1);
+  auto wrapper = objectTemplate->NewInstance(context).ToLocalChecked();
+  auto plain = v8::Object::New(isolate);
+  auto key = v8::Private::ForApi(isolate, v8_str("private:key"));
+
+  auto measure = [&](v8::Local<v8::Object> object) {
+    return measureNanos(kCount, [&](int i) {
+      v8::HandleScope inner(isolate);
+      object->SetPrivate(context, key, v8_num(i)).FromJust();
+      object->GetPrivate(context, key).ToLocalChecked();
+    });
+  };
+  printf("set/get private: %.1f ns (extra data) %.1f ns (hidden)\n",
+         measure(wrapper),
+         measure(plain));
+}
+
+TEST(bench_IdentityHash) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  auto context = env.local();
+  v8::HandleScope scope(isolate);
+
+  const int kBuckets = 1024;
+  auto array = CompileRun(
+                   "var objects = [];"
+                   "for (var i = 0; i < 1000000; i++) objects.push({});"
+                   "objects")
+                   .As<v8::Array>();
+  CHECK_EQ(array->Length(), static_cast<uint32_t>(kCount));
+
+  std::vector<v8::Global<v8::Object>> objects(kCount);
+  for (int i = 0; i < kCount; i++) {
+    v8::HandleScope inner(isolate);
+    objects[i].Reset(isolate,
+                     array->Get(context, i)
+                         .ToLocalChecked()
+                         ->ToObject(context)
+                         .ToLocalChecked());
+  }
+
+  // the first call assigns the hash, the later ones read it back
+  std::vector<int> hashes(kCount);
+  double assign = measureNanos(kCount, [&](int i) {
+    v8::HandleScope inner(isolate);
+    hashes[i] = objects[i].Get(isolate)->GetIdentityHash();
+  });
+  double lookup = measureNanos(kCount, [&](int i) {
+    v8::HandleScope inner(isolate);
+    CHECK_EQ(objects[i].Get(isolate)->GetIdentityHash(), hashes[i]);
+  });
+
+  // the distribution over 1M objects, as in internal_IdentityHash
+  std::vector<int> buckets(kBuckets, 0);
+  for (int hash : hashes) {
+    CHECK_GT(hash, 0);
+    buckets[hash % kBuckets]++;
+  }
+  const int expected = kCount / kBuckets;
+  for (int count : buckets) {
+    CHECK_GT(count, expected / 2);
+    CHECK_LT(count, expected * 2);
+  }
+  std::sort(hashes.begin(), hashes.end());
+  auto distinct = std::unique(hashes.begin(), hashes.end()) - hashes.begin();
+  CHECK_GT(distinct, kCount * 99 / 100);
+
+  printf("GetIdentityHash: %.1f ns (assign) %.1f ns (lookup), "
+         "%ld distinct of %d\n",
+         assign,
+         lookup,
+         static_cast<long>(distinct),
+         kCount);
+}
+
+TEST(bench_HeapStatistics) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+
+  v8::HeapStatistics stats;
+  double nanos =
+      measureNanos(kCount, [&](int) { isolate->GetHeapStatistics(&stats); });
+  printf("GetHeapStatistics: %.1f ns\n", nanos);
+}
+
+TEST(bench_SmapsRollup) {
+  const int kProbes = 100;
+  double rollupProbe = measureNanos(kProbes, [](int) {
+    SmapsRollup rollup;
+    readSmapsRollup("self", &rollup);
+  });
+  double fullProbe = measureNanos(kProbes, [](int) {
+    auto smaps = parseSmaps("self");
+    calculateTotal(smaps, kPss);
+  });
+  printf("pss probe: %.1f us (rollup) %.1f us (full parse)\n",
+         rollupProbe / 1000,
+         fullProbe / 1000);
+}
+
+TEST(bench_ContextEmbedderData) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+  auto context = env.local();
+  auto lwContext = reinterpret_cast<ValueWrap*>(*context)->context();
+
+  // the indexes node uses (see ContextEmbedderIndex)
+  const int kEnvironment = 32;
+  const int kContextTag = 35;
+  static int tag;
+  int environment;
+  context->SetAlignedPointerInEmbedderData(kEnvironment, &environment);
+  context->SetAlignedPointerInEmbedderData(kContextTag, &tag);
+
+  // the lookup of Environment::GetCurrent(context)
+  void* volatile result = nullptr;
+  double inlined = measureNanos(kCount, [&](int) {
+    if (context->GetNumberOfEmbedderDataFields() > kContextTag &&
+        context->GetAlignedPointerFromEmbedderData(kContextTag) == &tag) {
+      result = context->GetAlignedPointerFromEmbedderData(kEnvironment);
+    }
+  });
+  CHECK_EQ(result, &environment);
+  double throughShim = measureNanos(kCount, [&](int) {
+    result = lwContext->GetAlignedPointerFromEmbedderData(kEnvironment);
+  });
+  printf("Environment::GetCurrent: %.1f ns (through the shim: %.1f ns)\n",
+         inlined,
+         throughShim);
+}
+
+TEST(bench_InternalFieldWrappers) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+
+  auto templ = v8::ObjectTemplate::New(isolate);
+  templ->SetInternalFieldCount(2);
+  auto object = templ->NewInstance(env.local()).ToLocalChecked();
+  static int wrapped;
+  object->SetAlignedPointerInInternalField(1, &wrapped);
+
+  // create and unwrap wrapper objects like BaseObject does
+  size_t before = GC_get_total_bytes();
+  double create = measureNanos(kCount, [&](int) {
+    v8::HandleScope scope(isolate);
+    auto wrapper = templ->NewInstance(env.local()).ToLocalChecked();
+    wrapper->SetAlignedPointerInInternalField(0, &wrapped);
+    CHECK_EQ(wrapper->GetAlignedPointerFromInternalField(0), &wrapped);
+  });
+  size_t bytes = GC_get_total_bytes() - before;
+
+  int unwrapped = 0;
+  double unwrap = measureNanos(kCount, [&](int) {
+    if (object->GetAlignedPointerFromInternalField(1) == &wrapped) {
+      unwrapped++;
+    }
+  });
+  CHECK_EQ(unwrapped, kCount);
+
+  printf("wrapper: create %.1f ns (%zu GC bytes), unwrap %.1f ns\n",
+         create,
+         bytes / kCount,
+         unwrap);
+}
+
+TEST(bench_ArrayBufferPool) {
+  ArrayBufferPool pool(ArrayBufferPool::kDefaultMaxPooledSize);
+  auto allocator = v8::ArrayBuffer::Allocator::NewDefaultAllocator();
+
+  // the time to allocate and free a small buffer
+  double pooled = measureNanos(kCount, [&](int) {
+    void* data = pool.allocate(256);
+    pool.free(data, 256);
+  });
+  double malloced = measureNanos(kCount, [&](int) {
+    void* data = allocator->AllocateUninitialized(256);
+    allocator->Free(data, 256);
+  });
+  delete allocator;
+
+  printf("256B buffer: pool %.1f ns, allocator %.1f ns\n", pooled, malloced);
+}
+
+TEST(bench_GlobalHandles) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+  auto globalHandles = IsolateWrap::fromV8(isolate)->global_handles();
+  auto object = v8::Object::New(isolate);
+
+  // like BaseObjects, the handles are created in batches and live a while.
+  // The table is used directly, as SetWeak() may be disabled in this build.
+  const int kBatch = 1000;
+  const int kRounds = kCount / kBatch;
+  std::vector<v8::Global<v8::Object>> handles(kBatch);
+  auto callback = [](const v8::WeakCallbackInfo<void>& info) {};
+
+  for (bool weaken : {false, true}) {
+    size_t before = GC_get_total_bytes();
+    double nanos = measureNanos(kRounds, [&](int) {
+      for (auto& handle : handles) {
+        handle.Reset(isolate, object);
+        if (weaken) {
+          globalHandles->makeWeak(
+              *reinterpret_cast<HandleWrap**>(&handle), &handle, callback);
+        }
+      }
+      for (auto& handle : handles) {
+        handle.Reset();
+      }
+    });
+    printf("%s: %.1f ns, %zu GC bytes per handle\n",
+           weaken ? "create/weaken/dispose" : "create/dispose",
+           nanos / kBatch,
+           (GC_get_total_bytes() - before) / kCount);
+  }
+}
+
+static void FunctionDispatchCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  info.GetReturnValue().Set(info.Length());
+}
+
+TEST(bench_FunctionDispatch) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+
+  auto base = v8::FunctionTemplate::New(isolate);
+  auto derived = v8::FunctionTemplate::New(isolate);
+  derived->Inherit(base);
+  base->PrototypeTemplate()->Set(
+      v8_str("m"),
+      v8::FunctionTemplate::New(isolate,
+                                FunctionDispatchCallback,
+                                v8::Local<v8::Value>(),
+                                v8::Signature::New(isolate, base)));
+
+  auto global = env->Global();
+  global
+      ->Set(env.local(),
+            v8_str("Derived"),
+            derived->GetFunction(env.local()).ToLocalChecked())
+      .FromJust();
+  global
+      ->Set(env.local(),
+            v8_str("f"),
+            v8::FunctionTemplate::New(isolate, FunctionDispatchCallback)
+                ->GetFunction(env.local())
+                .ToLocalChecked())
+      .FromJust();
+  CompileRun(
+      "var d = new Derived();"
+      "function callMethod(n) { for (let i = 0; i < n; i++) d.m(i); }"
+      "function callFunction(n) { for (let i = 0; i < n; i++) f(i); }");
+
+  for (auto source : {"callFunction(1000000)", "callMethod(1000000)"}) {
+    size_t before = GC_get_total_bytes();
+    double nanos = measureScriptNanos(kCount, source);
+    printf("%s: %.1f ns, %zu GC bytes per call\n",
+           source,
+           nanos,
+           (GC_get_total_bytes() - before) / kCount);
+  }
+}
+
+static void NestedApiCallsCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  auto context = info.GetIsolate()->GetCurrentContext();
+  auto object = info[0].As<v8::Object>();
+  const int count = info[1]->Int32Value(context).FromJust();
+  for (int i = 0; i < count; i++) {
+    object->Get(context, v8_str("value")).ToLocalChecked();
+  }
+}
+
+TEST(bench_NestedApiCalls) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+
+  auto function = v8::FunctionTemplate::New(isolate, NestedApiCallsCallback)
+                      ->GetFunction(env.local())
+                      .ToLocalChecked();
+  env->Global()->Set(env.local(), v8_str("f"), function).FromJust();
+  auto object = CompileRun("var o = { value: 1 }; o").As<v8::Object>();
+
+  // compare reading properties inside a callback with reading them outside
+  double nested = measureScriptNanos(kCount, "f(o, 1000000)");
+  double outside = measureNanos(kCount, [&](int) {
+    v8::HandleScope inner(isolate);
+    object->Get(env.local(), v8_str("value")).ToLocalChecked();
+  });
+  printf("Object::Get: %.1f ns (in a callback) %.1f ns (outside)\n",
+         nested,
+         outside);
+}
@@ -24,14 +24,21 @@
 #include "api/isolate.h"
 #include "internal-api.h"
 
+#include <algorithm>
 #include <codecvt>
 #include <fstream>
 #include <string>
+#include <thread>
+#include <vector>
 #include "api/error-message.h"
 #include "api/es-helper.h"
+#include "api/external-string.h"
+#include "api/function.h"
 #include "api/utils/gc-container.h"
+#include "api/utils/smaps.h"
 #include "lwnode-loader.h"
 #include "lwnode.h"
+#include "lwnode/lwnode-gc-strategy.h"
 
 using namespace Escargot;
 using namespace EscargotShim;
@@ -1160,4 +1167,1388 @@ TEST(InternalErrorMessage) {
               .FromJust());
   }
 }
+
+static void HandleArenaCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  auto isolate = info.GetIsolate();
+  v8::HandleScope scope(isolate);
+  for (int i = 0; i < 8; i++) {
+    v8::Integer::New(isolate, i);
+  }
+  info.GetReturnValue().Set(v8::Integer::New(isolate, info.Length()));
+}
+
+TEST(internal_HandleArena) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+  auto arena = IsolateWrap::fromV8(isolate)->handleArena();
+
+  // handles of a scope are released together when the scope is left
+  const size_t size = arena->size();
+  {
+    v8::HandleScope inner(isolate);
+    for (int i = 0; i < 3000; i++) {
+      v8::Integer::New(isolate, i);
+    }
+    CHECK_EQ(arena->size(), size + 3000);
+  }
+  CHECK_EQ(arena->size(), size);
+
+  v8::Local<v8::Value> escaped;
+  {
+    v8::EscapableHandleScope inner(isolate);
+    escaped = inner.Escape(v8::Integer::New(isolate, 7));
+  }
+  CHECK_EQ(escaped->Int32Value(env.local()).FromJust(), 7);
+
+  // the return value survives the handle scope it was created in
+  auto function = v8::FunctionTemplate::New(isolate, HandleArenaCallback)
+                      ->GetFunction(env.local())
+                      .ToLocalChecked();
+  env->Global()->Set(env.local(), v8_str("f"), function).FromJust();
+  CHECK_EQ(CompileRun("f(1, 2, 3)")->Int32Value(env.local()).FromJust(), 3);
+
+  // 8 locals per scope take less GC memory than 8 heap handles
+  const int kCount = 1000;
+  size_t before = GC_get_total_bytes();
+  for (int i = 0; i < kCount; i++) {
+    v8::HandleScope inner(isolate);
+    for (int j = 0; j < 8; j++) {
+      v8::Integer::New(isolate, j);
+    }
+  }
+  size_t arenaBytes = GC_get_total_bytes() - before;
+
+  before = GC_get_total_bytes();
+  for (int i = 0; i < kCount; i++) {
+    v8::HandleScope inner(isolate);
+    for (int j = 0; j < 8; j++) {
+      ValueWrap::createValue(ValueRef::create(j));
+    }
+  }
+  size_t heapBytes = GC_get_total_bytes() - before;
+
+  CHECK_LT(arenaBytes, heapBytes);
+}
+
+static void CallbackInfoCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  info.GetReturnValue().Set(info.Length());
+}
+
+TEST(internal_CallbackInfo) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+  auto lwIsolate = IsolateWrap::fromV8(isolate);
+
+  const int kMaxArgc = FunctionCallbackInfoWrap::kInlineArgsLength + 4;
+  ValueRef* argv[kMaxArgc];
+  for (int i = 0; i < kMaxArgc; i++) {
+    argv[i] = ValueRef::create(i);
+  }
+  auto esThis = reinterpret_cast<ValueWrap*>(*env->Global())->value();
+
+  auto createCallbackInfo = [&](int argc) {
+    HandleScopeWrapGuard handleScope(lwIsolate);
+    FunctionCallbackInfoWrap info(isolate,
+                                  esThis,
+                                  esThis,
+                                  OptionalRef<ObjectRef>(),
+                                  lwIsolate->undefined_value(),
+                                  argc,
+                                  argv);
+    CHECK_EQ(info.Length(), argc);
+    if (argc > 0) {
+      CHECK_EQ(reinterpret_cast<ValueWrap*>(*info[argc - 1])->value(),
+               argv[argc - 1]);
+    }
+  };
+
+  // the arguments that fit inline don't allocate on the GC heap
+  const int kCount = 1000;
+  const int kArgcs[] = {
+      0, 3, FunctionCallbackInfoWrap::kInlineArgsLength, kMaxArgc};
+  for (int argc : kArgcs) {
+    createCallbackInfo(argc);
+
+    size_t before = GC_get_total_bytes();
+    for (int i = 0; i < kCount; i++) {
+      createCallbackInfo(argc);
+    }
+    if (argc <= FunctionCallbackInfoWrap::kInlineArgsLength) {
+      CHECK_EQ(GC_get_total_bytes() - before, 0u);
+    }
+  }
+
+  auto function = v8::FunctionTemplate::New(isolate, CallbackInfoCallback)
+                      ->GetFunction(env.local())
+                      .ToLocalChecked();
+  env->Global()->Set(env.local(), v8_str("f"), function).FromJust();
+  CHECK_EQ(CompileRun("f(1, 2, 3)")->Int32Value(env.local()).FromJust(), 3);
+}
+
+TEST(internal_ApiSymbolRegistry) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+  auto& registry = IsolateWrap::fromV8(isolate)->apiPrivateSymbols();
+  auto stats = registry.stats();
+
+  auto symbol1 = v8::Private::ForApi(isolate, v8_str("registry:key"));
+  auto symbol2 = v8::Private::ForApi(isolate, v8_str("registry:key"));
+  // a two-byte string equal to the key hits the same entry
+  const uint16_t key[] = {'r', 'e', 'g', 'i', 's', 't', 'r', 'y', ':',
+                          'k', 'e', 'y', 0x0};
+  auto twoByteKey =
+      v8::String::NewFromTwoByte(isolate, key).ToLocalChecked();
+  auto symbol3 = v8::Private::ForApi(isolate, twoByteKey);
+
+  CHECK_EQ(reinterpret_cast<ValueWrap*>(*symbol1)->value(),
+           reinterpret_cast<ValueWrap*>(*symbol2)->value());
+  CHECK_EQ(reinterpret_cast<ValueWrap*>(*symbol1)->value(),
+           reinterpret_cast<ValueWrap*>(*symbol3)->value());
+
+  auto newStats = registry.stats();
+  CHECK_EQ(newStats.size, stats.size + 1);
+  CHECK_EQ(newStats.lookups, stats.lookups + 3);
+  CHECK_EQ(newStats.hits, stats.hits + 2);
+}
+
+TEST(internal_PrivateValues) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  auto context = env.local();
+  v8::HandleScope scope(isolate);
+
+  auto objectTemplate = v8::ObjectTemplate::New(isolate);
+  objectTemplate->SetInternalFieldCount(1);
+  // private values of a wrapper are kept in its extra data
+  auto wrapper = objectTemplate->NewInstance(context).ToLocalChecked();
+  // private values of a plain object are kept in a hidden object
+  auto plain = v8::Object::New(isolate);
+
+  auto key = v8::Private::ForApi(isolate, v8_str("private:key"));
+  auto other = v8::Private::New(isolate, v8_str("private:other"));
+
+  for (auto object : {wrapper, plain}) {
+    CHECK(!object->HasPrivate(context, key).FromJust());
+    CHECK(object->SetPrivate(context, key, v8_num(1)).FromJust());
+    CHECK(object->HasPrivate(context, key).FromJust());
+    CHECK(!object->HasPrivate(context, other).FromJust());
+    CHECK_EQ(object->GetPrivate(context, key)
+                 .ToLocalChecked()
+                 ->Int32Value(context)
+                 .FromJust(),
+             1);
+    // private values aren't visible from JavaScript
+    CHECK_EQ(object->GetOwnPropertyNames(context).ToLocalChecked()->Length(),
+             0u);
+    CHECK(object->DeletePrivate(context, key).FromJust());
+    CHECK(!object->HasPrivate(context, key).FromJust());
+    // deleting a missing private value fails
+    CHECK(!object->DeletePrivate(context, key).FromJust());
+    CHECK(!object->DeletePrivate(context, other).FromJust());
+  }
+
+  // private values set before an object gets its own extra data are moved
+  // from the hidden object into the new ObjectData
+  for (int i = 0; i < 2; i++) {
+    auto object = v8::Object::New(isolate);
+    auto esObject = reinterpret_cast<ValueWrap*>(*object)->value()->asObject();
+    CHECK(object->SetPrivate(context, key, v8_num(2)).FromJust());
+    if (i == 0) {
+      ObjectRefHelper::setExtraData(esObject, new ObjectData());
+    } else {
+      ExtraDataHelper::setExtraData(esObject, new ObjectData());
+    }
+    CHECK(object->HasPrivate(context, key).FromJust());
+    CHECK_EQ(object->GetPrivate(context, key)
+                 .ToLocalChecked()
+                 ->Int32Value(context)
+                 .FromJust(),
+             2);
+  }
+
+  // an exception keeps its private values when it gets new extra data, as
+  // when it is rethrown through the API
+  auto error = v8::Exception::Error(v8_str("error")).As<v8::Object>();
+  auto esError = reinterpret_cast<ValueWrap*>(*error)->value()->asObject();
+  CHECK(error->SetPrivate(context, key, v8_num(1)).FromJust());
+  for (int i = 0; i < 2; i++) {
+    ExtraDataHelper::setExtraData(
+        esError, new ExceptionObjectData(new GCVector<StackTraceData*>()));
+    CHECK_EQ(error->GetPrivate(context, key)
+                 .ToLocalChecked()
+                 ->Int32Value(context)
+                 .FromJust(),
+             1);
+  }
+}
+
+TEST(internal_IdentityHash) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  auto context = env.local();
+  v8::HandleScope scope(isolate);
+
+  const uint32_t kCount = 100000;
+  const int kBuckets = 1024;
+  auto array = CompileRun(
+                   "var objects = [];"
+                   "for (var i = 0; i < 100000; i++) objects.push({});"
+                   "objects")
+                   .As<v8::Array>();
+  CHECK_EQ(array->Length(), kCount);
+
+  std::vector<int> hashes(kCount);
+  std::vector<int> buckets(kBuckets, 0);
+  for (uint32_t i = 0; i < kCount; i++) {
+    v8::HandleScope inner(isolate);
+    auto object = array->Get(context, i)
+                      .ToLocalChecked()
+                      ->ToObject(context)
+                      .ToLocalChecked();
+    int hash = object->GetIdentityHash();
+    CHECK_GT(hash, 0);
+    CHECK_EQ(hash, object->GetIdentityHash());
+    hashes[i] = hash;
+    buckets[hash % kBuckets]++;
+  }
+
+  // hashes are stable across garbage collections
+  CcTest::CollectAllGarbage();
+  for (uint32_t i = 0; i < kCount; i += 97) {
+    v8::HandleScope inner(isolate);
+    auto object = array->Get(context, i)
+                      .ToLocalChecked()
+                      ->ToObject(context)
+                      .ToLocalChecked();
+    CHECK_EQ(hashes[i], object->GetIdentityHash());
+  }
+
+  const int expected = kCount / kBuckets;
+  for (int count : buckets) {
+    CHECK_GT(count, expected / 2);
+    CHECK_LT(count, expected * 2);
+  }
+
+  std::sort(hashes.begin(), hashes.end());
+  auto distinct = std::unique(hashes.begin(), hashes.end()) - hashes.begin();
+  CHECK_GT(distinct, kCount * 99 / 100);
+
+  // equal strings have the same hash
+  CHECK_EQ(v8_str("identity")->GetIdentityHash(),
+           v8_str("identity")->GetIdentityHash());
+  auto symbol = v8::Symbol::New(isolate);
+  CHECK_GT(symbol->GetIdentityHash(), 0);
+  CHECK_EQ(symbol->GetIdentityHash(), symbol->GetIdentityHash());
+}
+
+TEST(internal_Utf8Transcoding) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+
+  const char* sources[] = {
+      "'hello brendan!!! hello brendan!!!'",
+      "'caf\\xe9 cr\\xe8me br\\xfbl\\xe9e, d\\xe9j\\xe0 vu'",
+      "'\\u03b0\\u03b1\\u03b2 abc \\u03b3\\u03b4'",
+      "'\\u6320\\u6321\\u6322\\u6323 abcdefgh'",
+      "'\\ud841\\udf0e\\ud841\\udf31 abcd'",
+  };
+
+  for (auto source : sources) {
+    auto string = CompileRun(source).As<v8::String>();
+    auto esString = reinterpret_cast<ValueWrap*>(*string)->value()->asString();
+    std::string expected = esString->toStdUTF8String();
+
+    int length = string->Utf8Length(isolate);
+    CHECK_EQ(length, static_cast<int>(expected.length()));
+
+    char buffer[256];
+    int nchars = 0;
+    int nbytes = string->WriteUtf8(isolate, buffer, -1, &nchars);
+    CHECK_EQ(nbytes, length + 1);
+    CHECK_EQ(std::string(buffer, length), expected);
+    CHECK_EQ(buffer[length], '\0');
+
+    // only whole sequences are written to a short buffer
+    for (int capacity = 0; capacity < length; capacity++) {
+      memset(buffer, 'x', sizeof(buffer));
+      nbytes = string->WriteUtf8(isolate, buffer, capacity, &nchars);
+      CHECK_LE(nbytes, capacity);
+      CHECK_GT(nbytes + 4, capacity);
+      CHECK_EQ(std::string(buffer, nbytes), expected.substr(0, nbytes));
+      CHECK_EQ(buffer[nbytes], 'x');
+    }
+  }
+
+  // lone surrogates take 3 bytes
+  auto lone = CompileRun("'a\\ud800b'").As<v8::String>();
+  CHECK_EQ(lone->Utf8Length(isolate), 5);
+  char buffer[8];
+  int nbytes = lone->WriteUtf8(isolate,
+                               buffer,
+                               sizeof(buffer),
+                               nullptr,
+                               v8::String::REPLACE_INVALID_UTF8);
+  CHECK_EQ(nbytes, 6);
+  CHECK_EQ(std::string(buffer), "a\xef\xbf\xbd" "b");
+}
+
+TEST(internal_CodeCache) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+
+  v8::ScriptCompiler::Source original(v8_str("1 + 1"));
+  auto unbound =
+      v8::ScriptCompiler::CompileUnboundScript(isolate, &original)
+          .ToLocalChecked();
+
+  std::unique_ptr<v8::ScriptCompiler::CachedData> produced(
+      v8::ScriptCompiler::CreateCodeCache(unbound));
+  CHECK_GT(produced->length, 0);
+  CHECK_NE(v8::ScriptCompiler::CachedDataVersionTag(), 0u);
+
+  // consumers get a copy of the data, as node does
+  auto consume = [&](const char* code, const uint8_t* data) {
+    auto cache = new v8::ScriptCompiler::CachedData(data, produced->length);
+    v8::ScriptCompiler::Source source(v8_str(code), cache);
+    v8::ScriptCompiler::CompileUnboundScript(
+        isolate, &source, v8::ScriptCompiler::kConsumeCodeCache)
+        .ToLocalChecked();
+    return source.GetCachedData()->rejected;
+  };
+
+  CHECK(!consume("1 + 1", produced->data));
+  CHECK(consume("1 + 2", produced->data));
+
+  // the version tag follows the magic; a cache with another one is stale
+  std::vector<uint8_t> stale(produced->data,
+                             produced->data + produced->length);
+  stale[sizeof(uint32_t)] ^= 1;
+  CHECK(consume("1 + 1", stale.data()));
+}
+
+TEST(internal_HeapStatistics) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+
+  v8::HeapStatistics stats;
+  isolate->GetHeapStatistics(&stats);
+  CHECK_GT(stats.total_heap_size(), 0u);
+  CHECK_GT(stats.used_heap_size(), 0u);
+  CHECK_LE(stats.used_heap_size(), stats.total_heap_size());
+  CHECK_LE(stats.total_heap_size(), stats.heap_size_limit());
+
+  size_t externalMemory = stats.external_memory();
+  auto buffer = v8::ArrayBuffer::New(isolate, 1024 * 1024);
+  isolate->GetHeapStatistics(&stats);
+  CHECK_GE(stats.external_memory(), externalMemory + 1024 * 1024);
+
+  CHECK_EQ(isolate->NumberOfHeapSpaces(), 3u);
+  size_t spaceUsedSize = 0;
+  for (size_t i = 0; i < isolate->NumberOfHeapSpaces(); i++) {
+    v8::HeapSpaceStatistics space;
+    CHECK(isolate->GetHeapSpaceStatistics(&space, i));
+    CHECK_NOT_NULL(space.space_name());
+    CHECK_LE(space.space_used_size(), space.space_size());
+    spaceUsedSize += space.space_used_size();
+  }
+  CHECK_GE(spaceUsedSize, buffer->ByteLength());
+  v8::HeapSpaceStatistics space;
+  CHECK(!isolate->GetHeapSpaceStatistics(&space, 3));
+}
+
+TEST(internal_SmapsRollup) {
+  SmapsRollup rollup;
+  CHECK(readSmapsRollup("self", &rollup));
+  CHECK_GT(rollup.rss, 0u);
+  CHECK_GT(rollup.pss, 0u);
+  CHECK_LE(rollup.pss, rollup.rss);
+
+  // the full parse sums up the same mappings
+  CHECK_GT(calculateTotal(parseSmaps("self"), kPss), 0u);
+}
+
+TEST(internal_PressureAwareGC) {
+  class CountingGC : public LWNode::GCStrategyInterface {
+   public:
+    CountingGC(int* count) : count_(count) {}
+    bool canScheduleGC() override { return false; }
+    void handle(v8::Isolate* isolate) override { (*count_)++; }
+
+   private:
+    int* count_;
+  };
+
+  int count = 0;
+  LWNode::PressureAwareGC gc(std::make_unique<CountingGC>(&count));
+  CHECK(!gc.canScheduleGC());
+
+  // without pressure, the given strategy handles GC
+  gc.handle(nullptr);
+  CHECK_EQ(count, 1);
+  CHECK(gc.takeEvents().empty());
+
+  gc.notify(v8::MemoryPressureLevel::kModerate);
+  gc.notify(v8::MemoryPressureLevel::kCritical);
+  gc.notify(v8::MemoryPressureLevel::kModerate);
+  CHECK(gc.canScheduleGC());
+  gc.handle(nullptr);
+  CHECK_EQ(count, 1);
+
+  auto events = gc.takeEvents();
+  CHECK_EQ(events.size(), 1u);
+  CHECK(events[0].level == v8::MemoryPressureLevel::kCritical);
+  CHECK(gc.takeEvents().empty());
+
+  // a threshold below the used heap triggers GC once there are allocations
+  LWNode::PressureAwareGC::Thresholds thresholds;
+  thresholds.moderateHeapSize = 1;
+  thresholds.minHeapGCInterval = 0;
+  gc.setThresholds(thresholds);
+  auto allocateQuarterOfHeap = []() {
+    size_t used = GC_get_heap_size() - GC_get_free_bytes();
+    while (GC_get_bytes_since_gc() < used / 4 + 1024 * 1024) {
+      GC_MALLOC(4096);
+    }
+  };
+  allocateQuarterOfHeap();
+  gc.handle(nullptr);
+  events = gc.takeEvents();
+  CHECK_EQ(events.size(), 1u);
+  CHECK(events[0].level == v8::MemoryPressureLevel::kModerate);
+
+  // the heap stays above the threshold, but isn't collected again until it
+  // grows
+  gc.handle(nullptr);
+  CHECK(gc.takeEvents().empty());
+  CHECK_EQ(count, 2);
+  allocateQuarterOfHeap();
+  gc.handle(nullptr);
+  CHECK_EQ(gc.takeEvents().size(), 1u);
+
+  // nor until the interval passes
+  thresholds.minHeapGCInterval = 60 * 1000;
+  gc.setThresholds(thresholds);
+  allocateQuarterOfHeap();
+  gc.handle(nullptr);
+  CHECK(gc.takeEvents().empty());
+  CHECK_EQ(count, 3);
+
+  gc.setThresholds(LWNode::PressureAwareGC::Thresholds());
+  gc.handle(nullptr);
+  CHECK_EQ(count, 4);
+}
+
+static int stackTraceCallbackCount = 0;
+
+static v8::MaybeLocal<v8::Value> StackTraceCallback(
+    v8::Local<v8::Context> context,
+    v8::Local<v8::Value> error,
+    v8::Local<v8::Array> sites) {
+  stackTraceCallbackCount++;
+  // keep the CallSites so that the test can inspect them
+  context->Global()->Set(context, v8_str("sites"), sites).FromJust();
+  return v8_str("formatted");
+}
+
+TEST(internal_StackTrace) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+  isolate->SetPrepareStackTraceCallback(StackTraceCallback);
+  stackTraceCallbackCount = 0;
+
+  auto run = [&](const char* source) {
+    auto result = CompileRun(source);
+    CHECK(!result.IsEmpty());
+    return result;
+  };
+  auto checkTrue = [&](const char* source) {
+    CHECK(run(source)->BooleanValue(isolate));
+  };
+
+  // the CallSites are created on the first read of the stack
+  run("function inner(o) { Error.captureStackTrace(o, middle); }"
+      "function middle(o) { inner(o); }"
+      "function outer(o) { middle(o); }"
+      "var o = {};"
+      "outer(o);");
+  CHECK_EQ(stackTraceCallbackCount, 0);
+  checkTrue("o.stack === 'formatted'");
+  CHECK_EQ(stackTraceCallbackCount, 1);
+  checkTrue("typeof sites[0].getFunctionName === 'function'");
+
+  // captureStackTrace() drops the frames above the filter function and the
+  // filter function itself
+  checkTrue("sites[0].getFunctionName() === 'outer'");
+  checkTrue("sites.every((site) => site.getFunctionName() !== 'inner')");
+
+  // a second read returns the cached string
+  checkTrue("o.stack === 'formatted'");
+  CHECK_EQ(stackTraceCallbackCount, 1);
+
+  // Error.stackTraceLimit truncates the frames
+  run("function recurse(n) { return n > 0 ? recurse(n - 1) : new Error(); }"
+      "Error.stackTraceLimit = 2;"
+      "var e = recurse(5);"
+      "Error.stackTraceLimit = 20;");
+  checkTrue("e.stack === 'formatted'");
+  CHECK_EQ(stackTraceCallbackCount, 2);
+  checkTrue("sites.length === 2");
+  checkTrue("sites[0].getFunctionName() === 'recurse'");
+
+  isolate->SetPrepareStackTraceCallback(nullptr);
+}
+
+TEST(internal_StringEncoding) {
+  // place a wider code unit at every position so both the vector loops and
+  // their tails are covered
+  for (size_t length = 1; length < 40; length++) {
+    std::vector<uint8_t> latin1(length, 'a');
+    CHECK_EQ(StringEncoding::classify(latin1.data(), length),
+             StringEncoding::kAscii);
+    std::vector<char16_t> utf16(length, u'a');
+    CHECK_EQ(StringEncoding::classify(utf16.data(), length),
+             StringEncoding::kAscii);
+
+    for (size_t i = 0; i < length; i++) {
+      latin1[i] = 0xe9;
+      CHECK_EQ(StringEncoding::classify(latin1.data(), length),
+               StringEncoding::kLatin1);
+      latin1[i] = 'a';
+
+      utf16[i] = 0xe9;
+      CHECK_EQ(StringEncoding::classify(utf16.data(), length),
+               StringEncoding::kLatin1);
+      utf16[i] = 0x3b1;
+      CHECK_EQ(StringEncoding::classify(utf16.data(), length),
+               StringEncoding::kTwoByte);
+      utf16[i] = 0xdc00;
+      CHECK_EQ(StringEncoding::classify(utf16.data(), length),
+               StringEncoding::kHasSurrogates);
+      utf16[i] = u'a';
+    }
+  }
+  CHECK_EQ(StringEncoding::classify(static_cast<const uint8_t*>(nullptr), 0),
+           StringEncoding::kAscii);
+
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+
+  struct {
+    const char* source;
+    StringEncoding::Type type;
+  } cases[] = {
+      {"'abcd'.repeat(100)", StringEncoding::kAscii},
+      {"'abcd'.repeat(100) + '\\xe9'", StringEncoding::kLatin1},
+      {"'abcd'.repeat(100) + '\\u03b1'", StringEncoding::kTwoByte},
+      {"'abcd'.repeat(100) + '\\ud841\\udf0e'",
+       StringEncoding::kHasSurrogates},
+      {"'ab'", StringEncoding::kAscii},
+  };
+
+  for (auto& c : cases) {
+    auto string = CompileRun(c.source).As<v8::String>();
+    auto esString = reinterpret_cast<ValueWrap*>(*string)->value()->asString();
+    size_t expected = esString->toStdUTF8String().length();
+
+    // the second queries are answered from the cache for long strings
+    for (int i = 0; i < 2; i++) {
+      CHECK_EQ(StringRefHelper::encoding(esString), c.type);
+      CHECK_EQ(StringRefHelper::utf8Length(esString), expected);
+      CHECK_EQ(StringRefHelper::isOneByteString(esString),
+               StringEncoding::isOneByte(c.type));
+    }
+  }
+
+  // a collection invalidates the cache, and a string keeps its class
+  auto string = CompileRun("'\\u03b1'.repeat(300)").As<v8::String>();
+  auto esString = reinterpret_cast<ValueWrap*>(*string)->value()->asString();
+  CHECK_EQ(StringRefHelper::encoding(esString), StringEncoding::kTwoByte);
+  Escargot::Memory::gc();
+  CHECK_EQ(StringRefHelper::encoding(esString), StringEncoding::kTwoByte);
+  CHECK_EQ(string->Utf8Length(isolate), 600);
+}
+
+TEST(internal_ContextEmbedderData) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+  auto context = env.local();
+  auto lwContext = reinterpret_cast<ValueWrap*>(*context)->context();
+
+  // the indexes node uses (see ContextEmbedderIndex)
+  const int kEnvironment = 32;
+  const int kContextTag = 35;
+  static int tag;
+  int environment;
+
+  CHECK_NULL(context->GetAlignedPointerFromEmbedderData(kEnvironment));
+  context->SetAlignedPointerInEmbedderData(kEnvironment, &tag);
+  context->SetAlignedPointerInEmbedderData(kEnvironment, &environment);
+  context->SetAlignedPointerInEmbedderData(kContextTag, &tag);
+  CHECK_EQ(context->GetNumberOfEmbedderDataFields(), kContextTag + 1u);
+  CHECK_EQ(context->GetAlignedPointerFromEmbedderData(kEnvironment),
+           &environment);
+  CHECK_EQ(lwContext->GetAlignedPointerFromEmbedderData(kEnvironment),
+           &environment);
+  CHECK_EQ(context->GetAlignedPointerFromEmbedderData(kContextTag), &tag);
+  CHECK_NULL(context->GetAlignedPointerFromEmbedderData(kEnvironment + 1));
+  CHECK_NULL(context->GetAlignedPointerFromEmbedderData(100));
+  CHECK_NULL(context->GetAlignedPointerFromEmbedderData(-1));
+
+  // values set are kept alive by the context
+  {
+    v8::HandleScope scope(isolate);
+    context->SetEmbedderData(1, v8_str("embedder data"));
+  }
+  Escargot::Memory::gc();
+  CHECK(context->GetEmbedderData(1)->StrictEquals(v8_str("embedder data")));
+  CHECK_EQ(context->GetAlignedPointerFromEmbedderData(kContextTag), &tag);
+
+  // the lookup of Environment::GetCurrent(context)
+  auto getCurrent = [](v8::Local<v8::Context> context) -> void* {
+    if (context->GetNumberOfEmbedderDataFields() <= kContextTag) {
+      return nullptr;
+    }
+    if (context->GetAlignedPointerFromEmbedderData(kContextTag) != &tag) {
+      return nullptr;
+    }
+    return context->GetAlignedPointerFromEmbedderData(kEnvironment);
+  };
+  CHECK_EQ(getCurrent(context), &environment);
+}
+
+TEST(internal_InternalFieldWrappers) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+
+  const int kFieldCount = 2;
+  auto templ = v8::ObjectTemplate::New(isolate);
+  templ->SetInternalFieldCount(kFieldCount);
+
+  // the fields of an instance are allocated along with its ObjectData
+  auto object = templ->NewInstance(env.local()).ToLocalChecked();
+  auto data = ObjectRefHelper::getExtraData(
+      reinterpret_cast<ValueWrap*>(*object)->value()->asObject());
+  CHECK(data->isObjectData());
+  CHECK_EQ(data->internalFieldCount(), kFieldCount);
+  CHECK_NULL(object->GetAlignedPointerFromInternalField(1));
+  object->SetAlignedPointerInInternalField(1, data);
+  CHECK_EQ(data->internalField(1), data);
+  object->SetInternalField(0, v8_str("field"));
+  Escargot::Memory::gc();
+  CHECK(object->GetInternalField(0)->StrictEquals(v8_str("field")));
+  CHECK_EQ(object->GetAlignedPointerFromInternalField(1), data);
+
+  // wrapper objects created like BaseObject does keep their own fields
+  static int wrapped;
+  std::vector<v8::Local<v8::Object>> wrappers;
+  for (int i = 0; i < 100; i++) {
+    auto wrapper = templ->NewInstance(env.local()).ToLocalChecked();
+    wrapper->SetAlignedPointerInInternalField(0, &wrapped);
+    wrappers.push_back(wrapper);
+  }
+  Escargot::Memory::gc();
+  for (auto& wrapper : wrappers) {
+    CHECK_EQ(wrapper->GetAlignedPointerFromInternalField(0), &wrapped);
+  }
+}
+
+TEST(internal_ArrayBufferPool) {
+  ArrayBufferPool pool(ArrayBufferPool::kDefaultMaxPooledSize);
+  CHECK(!pool.isPooledSize(0));
+  CHECK(pool.isPooledSize(1));
+  CHECK(pool.isPooledSize(ArrayBufferPool::kDefaultMaxPooledSize));
+  CHECK(!pool.isPooledSize(ArrayBufferPool::kDefaultMaxPooledSize + 1));
+
+  // blocks of a size class are distinct and aligned like malloc's
+  std::vector<std::pair<void*, size_t>> blocks;
+  for (size_t length = 1; length <= 4096; length = length * 3 + 1) {
+    for (int i = 0; i < 100; i++) {
+      auto data = pool.allocate(length);
+      CHECK_NOT_NULL(data);
+      CHECK_EQ(reinterpret_cast<uintptr_t>(data) % 16, 0u);
+      memset(data, i, length);
+      blocks.push_back({data, length});
+    }
+  }
+  std::vector<void*> addresses;
+  for (auto& block : blocks) {
+    addresses.push_back(block.first);
+  }
+  std::sort(addresses.begin(), addresses.end());
+  CHECK(std::adjacent_find(addresses.begin(), addresses.end()) ==
+        addresses.end());
+
+  auto statistics = pool.statistics();
+  CHECK_GT(statistics.inUseBytes, 0u);
+  CHECK_GE(statistics.slabBytes, statistics.inUseBytes);
+
+  for (auto& block : blocks) {
+    pool.free(block.first, block.second);
+  }
+  statistics = pool.statistics();
+  CHECK_EQ(statistics.inUseBytes, 0u);
+
+  // empty slabs are kept for reuse until trimmed
+  CHECK_LE(statistics.slabBytes,
+           ArrayBufferPool::kMaxEmptySlabs * ArrayBufferPool::kSlabSize);
+  CHECK_EQ(pool.trim(), statistics.slabBytes);
+  CHECK_EQ(pool.statistics().slabBytes, 0u);
+
+  // a block may be freed by another thread
+  const int kThreads = 4;
+  const int kCount = 10000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&pool, t]() {
+      std::vector<void*> local;
+      for (int i = 0; i < kCount; i++) {
+        local.push_back(pool.allocate(64 + t));
+        if (i % 3 == 0) {
+          pool.free(local.back(), 64 + t);
+          local.pop_back();
+        }
+      }
+      for (auto data : local) {
+        pool.free(data, 64 + t);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  CHECK_EQ(pool.statistics().inUseBytes, 0u);
+}
+
+struct GCCallbackCounts {
+  int prologue = 0;
+  int epilogue = 0;
+  v8::GCCallbackFlags flags = v8::kNoGCCallbackFlags;
+};
+
+static GCCallbackCounts s_gcCallbackCounts;
+
+static void OnGCPrologue(v8::Isolate* isolate,
+                         v8::GCType type,
+                         v8::GCCallbackFlags flags,
+                         void* data) {
+  auto counts = reinterpret_cast<GCCallbackCounts*>(data);
+  CHECK_EQ(counts->prologue, counts->epilogue);
+  CHECK_EQ(type, v8::kGCTypeMarkSweepCompact);
+  counts->prologue++;
+  counts->flags = flags;
+}
+
+static void OnGCEpilogue(v8::Isolate* isolate,
+                         v8::GCType type,
+                         v8::GCCallbackFlags flags) {
+  s_gcCallbackCounts.epilogue++;
+  CHECK_EQ(s_gcCallbackCounts.prologue, s_gcCallbackCounts.epilogue);
+}
+
+TEST(internal_GCEventTracker) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  auto tracker = IsolateWrap::fromV8(isolate)->gcEventTracker();
+
+  CHECK_EQ(GCEventTracker::histogramBucket(0), 0u);
+  CHECK_EQ(GCEventTracker::histogramBucket(1), 1u);
+  CHECK_EQ(GCEventTracker::histogramBucket(1000), 10u);
+  CHECK_EQ(GCEventTracker::histogramBucket(UINT64_MAX),
+           GCEventTracker::kHistogramSize - 1);
+
+  s_gcCallbackCounts = GCCallbackCounts();
+  isolate->AddGCPrologueCallback(OnGCPrologue, &s_gcCallbackCounts);
+  isolate->AddGCEpilogueCallback(OnGCEpilogue);
+
+  const size_t count = tracker->stats().count;
+  {
+    GCEventTracker::ReasonScope scope(isolate,
+                                      GCEventTracker::Reason::kForced);
+    Escargot::Memory::gc();
+  }
+
+  CHECK_GE(s_gcCallbackCounts.prologue, 1);
+  CHECK_EQ(s_gcCallbackCounts.prologue, s_gcCallbackCounts.epilogue);
+  CHECK_EQ(s_gcCallbackCounts.flags, v8::kGCCallbackFlagForced);
+
+  const auto& stats = tracker->stats();
+  CHECK_EQ(stats.count - count,
+           static_cast<size_t>(s_gcCallbackCounts.epilogue));
+  CHECK(stats.lastReason == GCEventTracker::Reason::kForced);
+  CHECK_GE(stats.maxPauseMicros, stats.lastPauseMicros);
+  size_t pauses = 0;
+  for (size_t i = 0; i < GCEventTracker::kHistogramSize; i++) {
+    pauses += stats.histogram[i];
+  }
+  CHECK_EQ(pauses, stats.count);
+
+  // removed callbacks aren't called
+  isolate->RemoveGCPrologueCallback(OnGCPrologue, &s_gcCallbackCounts);
+  isolate->RemoveGCEpilogueCallback(OnGCEpilogue);
+  const int epilogue = s_gcCallbackCounts.epilogue;
+  const size_t countBeforeGC = stats.count;
+  Escargot::Memory::gc();
+  CHECK_EQ(s_gcCallbackCounts.epilogue, epilogue);
+  CHECK_GT(tracker->stats().count, countBeforeGC);
+}
+
+static HandleWrap* LocationOf(const v8::PersistentBase<v8::Object>& handle) {
+  return *reinterpret_cast<HandleWrap* const*>(&handle);
+}
+
+TEST(internal_GlobalHandles) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+  auto globalHandles = IsolateWrap::fromV8(isolate)->global_handles();
+  const size_t initialCount = globalHandles->handles_count();
+
+  // a global is a node of the table, and so is its copy
+  auto object = v8::Object::New(isolate);
+  v8::Global<v8::Object> global1(isolate, object);
+  v8::Global<v8::Object> global2(isolate, global1);
+  CHECK(global1 == object);
+  CHECK(global2 == global1);
+  CHECK(LocationOf(global1)->isGlobalHandleNode());
+  CHECK(LocationOf(global1) != LocationOf(global2));
+  CHECK_EQ(globalHandles->handles_count(), initialCount + 2);
+
+  // a local made from a global is a copy of the node
+  auto local = v8::Local<v8::Object>::New(isolate, global1);
+  CHECK(local == object);
+  CHECK(*reinterpret_cast<HandleWrap**>(&local) != LocationOf(global1));
+
+  // a disposed node is reused
+  auto location = LocationOf(global2);
+  global2.Reset();
+  CHECK_EQ(globalHandles->handles_count(), initialCount + 1);
+  v8::Global<v8::Object> global3(isolate, object);
+  CHECK(LocationOf(global3) == location);
+
+  // the state lives in the node, where v8.h reads it
+  static int s_parameter;
+  const auto strongNodes = globalHandles->statistics().strongNodes;
+  CHECK(!global3.IsWeak());
+  globalHandles->makeWeak(
+      location, &s_parameter, [](const v8::WeakCallbackInfo<void>& info) {});
+  CHECK(location->location() == HandleWrap::Location::Weak);
+  CHECK(global3.IsWeak());
+  CHECK_EQ(globalHandles->statistics().strongNodes, strongNodes - 1);
+  CHECK(globalHandles->clearWeakness(location) == &s_parameter);
+  CHECK(location->location() == HandleWrap::Location::Strong);
+  CHECK(!global3.IsWeak());
+  CHECK_EQ(globalHandles->statistics().strongNodes, strongNodes);
+
+  // contexts are kept by reference
+  v8::Global<v8::Context> context(isolate, env.local());
+  CHECK(!(*reinterpret_cast<HandleWrap**>(&context))->isGlobalHandleNode());
+  CHECK(context.Get(isolate) == env.local());
+  context.Reset();
+
+  // short-lived globals don't grow the table
+  const auto blocks = globalHandles->statistics().blocks;
+  for (size_t i = 0; i < 4 * GlobalHandles::kBlockSize; i++) {
+    v8::Global<v8::Object> global(isolate, object);
+  }
+  CHECK_EQ(globalHandles->statistics().blocks, blocks);
+
+  global1.Reset();
+  global3.Reset();
+  CHECK_EQ(globalHandles->handles_count(), initialCount);
+}
+
+TEST(internal_GlobalHandlesIsWeak) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+
+  static int s_parameter;
+  v8::Global<v8::Object> global(isolate, v8::Object::New(isolate));
+  v8::Global<v8::Object> copy(isolate, global);
+  CHECK(!global.IsWeak());
+  CHECK(!copy.IsWeak());
+
+  // SetWeak() is honoured only where weak handles are enabled
+  global.SetWeak(&s_parameter,
+                 [](const v8::WeakCallbackInfo<int>& info) {},
+                 v8::WeakCallbackType::kParameter);
+  CHECK_EQ(global.IsWeak(), GlobalHandles::IsWeakHandleEnabled());
+  CHECK(!copy.IsWeak());
+
+  global.ClearWeak();
+  CHECK(!global.IsWeak());
+  CHECK(!global.IsEmpty());
+
+  // a context is held by reference and is never weak
+  v8::Global<v8::Context> context(isolate, env.local());
+  CHECK(!context.IsWeak());
+}
+
+TEST(internal_GlobalHandlesIncrementalFinalizers) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+  auto globalHandles = IsolateWrap::fromV8(isolate)->global_handles();
+  globalHandles->processAllPendingFinalizers();
+
+  const int kCount = 100;
+  static int s_finalized;
+  s_finalized = 0;
+  auto callback = [](const v8::WeakCallbackInfo<void>& info) {
+    reinterpret_cast<v8::Global<v8::Object>*>(info.GetParameter())->Reset();
+    s_finalized++;
+  };
+
+  // the table is used directly, as SetWeak() may be disabled in this build
+  auto handles = new v8::Global<v8::Object>[kCount];
+  {
+    v8::HandleScope innerScope(isolate);
+    for (int i = 0; i < kCount; i++) {
+      handles[i].Reset(isolate, v8::Object::New(isolate));
+      globalHandles->makeWeak(LocationOf(handles[i]), &handles[i], callback);
+    }
+  }
+
+  // a handle made strong again isn't finalized
+  globalHandles->clearWeakness(LocationOf(handles[0]));
+
+  {
+    GlobalHandles::ProcessingHoldScope hold;
+    isolate->RequestGarbageCollectionForTesting(
+        v8::Isolate::kFullGarbageCollection);
+    CHECK_EQ(s_finalized, 0);
+    CHECK(globalHandles->hasPendingFinalizers());
+  }
+
+  // with no budget, a slice runs a few finalizers only
+  CHECK(globalHandles->processPendingFinalizers(0));
+  CHECK_GT(s_finalized, 0);
+  CHECK_LT(s_finalized, kCount - 1);
+
+  while (globalHandles->processPendingFinalizers(0)) {
+  }
+
+  // the collector is conservative, so a few values may survive
+  CHECK_GT(s_finalized, kCount / 2);
+  int emptyHandles = 0;
+  for (int i = 0; i < kCount; i++) {
+    emptyHandles += handles[i].IsEmpty() ? 1 : 0;
+  }
+  CHECK_EQ(emptyHandles, s_finalized);
+  CHECK(!handles[0].IsEmpty());
+
+  for (int i = 0; i < kCount; i++) {
+    handles[i].Reset();
+  }
+  delete[] handles;
+}
+
+TEST(internal_GlobalHandlesReuse) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+  auto object = v8::Object::New(isolate);
+
+  // like BaseObjects, the handles are created in batches and live a while;
+  // once the table has grown, its nodes are reused without allocation
+  const int kBatch = 1000;
+  std::vector<v8::Global<v8::Object>> handles(kBatch);
+  auto run = [&]() {
+    for (auto& handle : handles) {
+      handle.Reset(isolate, object);
+    }
+    for (auto& handle : handles) {
+      handle.Reset();
+    }
+  };
+
+  run();
+  size_t before = GC_get_total_bytes();
+  run();
+  CHECK_EQ(GC_get_total_bytes() - before, 0u);
+}
+
+class SharedArrayBufferDelegate : public v8::ValueSerializer::Delegate,
+                                  public v8::ValueDeserializer::Delegate {
+ public:
+  explicit SharedArrayBufferDelegate(v8::Isolate* isolate)
+      : isolate_(isolate) {}
+
+  void ThrowDataCloneError(v8::Local<v8::String> message) override {
+    isolate_->ThrowException(v8::Exception::Error(message));
+  }
+
+  v8::Maybe<uint32_t> GetSharedArrayBufferId(
+      v8::Isolate* isolate, v8::Local<v8::SharedArrayBuffer> sab) override {
+    buffers_.push_back(sab);
+    return v8::Just(static_cast<uint32_t>(buffers_.size() - 1));
+  }
+
+  v8::MaybeLocal<v8::SharedArrayBuffer> GetSharedArrayBufferFromId(
+      v8::Isolate* isolate, uint32_t id) override {
+    if (id >= buffers_.size()) {
+      return v8::MaybeLocal<v8::SharedArrayBuffer>();
+    }
+    return buffers_[id];
+  }
+
+ private:
+  v8::Isolate* isolate_;
+  std::vector<v8::Local<v8::SharedArrayBuffer>> buffers_;
+};
+
+TEST(internal_SharedArrayBuffer) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+  auto context = env.local();
+
+  auto sab = v8::SharedArrayBuffer::New(isolate, 8);
+  std::shared_ptr<v8::BackingStore> store = sab->GetBackingStore();
+  CHECK(store->IsShared());
+  CHECK_EQ(store->ByteLength(), 8u);
+
+  auto array = v8::Uint32Array::New(sab, 4, 1);
+  CHECK(!array.IsEmpty());
+  CHECK_EQ(array->ByteOffset(), 4u);
+  static_cast<uint32_t*>(store->Data())[1] = 42;
+  CHECK_EQ(
+      array->Get(context, 0).ToLocalChecked()->Uint32Value(context).FromJust(),
+      42u);
+
+  // a holder may be released on a thread without an isolate
+  {
+    std::shared_ptr<v8::BackingStore> copy = sab->GetBackingStore();
+    std::thread([&copy]() { copy.reset(); }).join();
+  }
+
+  // a store without external memory is allocated by the engine
+  auto empty = v8::SharedArrayBuffer::NewBackingStore(
+      nullptr, 4, [](void* data, size_t length, void* deleterData) {}, nullptr);
+  CHECK(empty->IsShared());
+  CHECK_EQ(empty->ByteLength(), 4u);
+  empty.reset();
+
+  // views of a SharedArrayBuffer are cloned on the same memory
+  SharedArrayBufferDelegate delegate(isolate);
+  v8::ValueSerializer serializer(isolate, &delegate);
+  serializer.WriteHeader();
+  CHECK(serializer.WriteValue(context, array).FromJust());
+  auto buffer = serializer.Release();
+
+  v8::ValueDeserializer deserializer(
+      isolate, buffer.first, buffer.second, &delegate);
+  CHECK(deserializer.ReadHeader(context).FromJust());
+  auto value = deserializer.ReadValue(context).ToLocalChecked();
+  free(buffer.first);
+
+  CHECK(value->IsUint32Array());
+  auto clone = value.As<v8::Uint32Array>();
+  CHECK_EQ(clone->ByteOffset(), 4u);
+  CHECK_EQ(clone->Length(), 1u);
+  static_cast<uint32_t*>(store->Data())[1] = 43;
+  CHECK_EQ(
+      clone->Get(context, 0).ToLocalChecked()->Uint32Value(context).FromJust(),
+      43u);
+}
+
+TEST(internal_SharedArrayBufferAcrossIsolates) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+  auto context = env.local();
+
+  auto sab = v8::SharedArrayBuffer::New(isolate, 8);
+  auto array = v8::Int32Array::New(sab, 0, 2);
+  CHECK(array->Set(context, 0, v8::Integer::New(isolate, 42)).FromJust());
+
+  // the store is attached in an isolate of another thread, as a worker does
+  std::shared_ptr<v8::BackingStore> store = sab->GetBackingStore();
+  int32_t seen = 0;
+  std::thread worker([&store, &seen]() {
+    v8::Isolate::CreateParams params;
+    params.array_buffer_allocator = CcTest::array_buffer_allocator();
+    auto workerIsolate = v8::Isolate::New(params);
+    {
+      v8::Isolate::Scope isolateScope(workerIsolate);
+      v8::HandleScope handleScope(workerIsolate);
+      auto workerContext = v8::Context::New(workerIsolate);
+      v8::Context::Scope contextScope(workerContext);
+
+      auto shared = v8::SharedArrayBuffer::New(workerIsolate, store);
+      CHECK(workerContext->Global()
+                ->Set(workerContext, v8_str(workerIsolate, "sab"), shared)
+                .FromJust());
+      auto source = v8_str(workerIsolate,
+                           "const view = new Int32Array(sab);"
+                           "Atomics.store(view, 1, 43);"
+                           "Atomics.load(view, 0);");
+      auto result = v8::Script::Compile(workerContext, source)
+                        .ToLocalChecked()
+                        ->Run(workerContext)
+                        .ToLocalChecked();
+      seen = result->Int32Value(workerContext).FromJust();
+    }
+    store.reset();
+    workerIsolate->Dispose();
+  });
+  worker.join();
+
+  // each side sees what the other wrote
+  CHECK_EQ(seen, 42);
+  CHECK_EQ(
+      array->Get(context, 1).ToLocalChecked()->Int32Value(context).FromJust(),
+      43);
+}
+
+class CountedOneByteResource
+    : public v8::String::ExternalOneByteStringResource {
+ public:
+  CountedOneByteResource(const char* data, int* disposed)
+      : data_(data), disposed_(disposed) {}
+  ~CountedOneByteResource() override { (*disposed_)++; }
+
+  const char* data() const override { return data_; }
+  size_t length() const override { return strlen(data_); }
+
+ private:
+  const char* data_;
+  int* disposed_;
+};
+
+static const char kExternalContent[] = "an external string for the test";
+
+static void NewDeadExternalStrings(v8::Isolate* isolate,
+                                   int count,
+                                   int* disposed) {
+  v8::HandleScope scope(isolate);
+  for (int i = 0; i < count; i++) {
+    auto resource = new CountedOneByteResource(kExternalContent, disposed);
+    CHECK(v8::String::NewExternalOneByte(isolate, resource)
+              .ToLocalChecked()
+              ->IsExternalOneByte());
+  }
+}
+
+TEST(internal_ExternalStrings) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+  auto lwIsolate = IsolateWrap::fromV8(isolate);
+  auto registry = ExternalStringRegistry::instance();
+  const size_t length = strlen(kExternalContent);
+
+  int disposed = 0;
+  auto resource = new CountedOneByteResource(kExternalContent, &disposed);
+  const size_t bytesBefore = registry->bytes(lwIsolate);
+  auto string =
+      v8::String::NewExternalOneByte(isolate, resource).ToLocalChecked();
+  CHECK(string->IsExternal());
+  CHECK(string->GetExternalOneByteStringResource() == resource);
+  CHECK(string->GetExternalStringResource() == nullptr);
+  CHECK_EQ(registry->bytes(lwIsolate), bytesBefore + length);
+
+  // only the handles made by NewExternal* are marked
+  env->Global()->Set(env.local(), v8_str("externalString"), string).Check();
+  auto value = CompileRun(env.local(), "externalString").ToLocalChecked();
+  CHECK(!value.As<v8::String>()->IsExternal());
+  CHECK(value.As<v8::String>()->StringEquals(string));
+
+  // the resources of dead strings are queued by the GC and disposed with the
+  // pending finalizers of the isolate
+  const int kCount = 100;
+  int deadDisposed = 0;
+  NewDeadExternalStrings(isolate, kCount, &deadDisposed);
+  for (int i = 0; i < 3 && deadDisposed == 0; i++) {
+    MemoryUtil::gcFull();
+    MemoryUtil::gcInvokeFinalizers();
+    CHECK_EQ(deadDisposed, 0);
+    lwIsolate->global_handles()->processPendingFinalizers();
+  }
+  CHECK_GT(deadDisposed, 0);
+  CHECK_EQ(disposed, 0);
+  CHECK_LE(registry->bytes(lwIsolate),
+           bytesBefore + length * (kCount - deadDisposed + 1));
+
+  // a heap string isn't externalized, and the caller keeps the resource
+  auto heapString = v8_str(kExternalContent);
+  CHECK(!heapString->IsExternal());
+  CHECK(!heapString->CanMakeExternal());
+  CountedOneByteResource kept(kExternalContent, &disposed);
+  CHECK(!heapString->MakeExternal(&kept));
+  CHECK(!heapString->IsExternal());
+  CHECK_EQ(disposed, 0);
+}
+
+TEST(internal_ExternalMemory) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+  auto lwIsolate = IsolateWrap::fromV8(isolate);
+  auto gcStrategy = LWNode::MessageLoop::GetInstance()->pressureAwareGC();
+  const int64_t kSoftLimit =
+      v8::internal::Internals::kExternalAllocationSoftLimit;
+
+  // the inline function of v8.h updates the counter of the isolate
+  const int64_t base = isolate->AdjustAmountOfExternalAllocatedMemory(0);
+  CHECK_EQ(base, lwIsolate->external_memory());
+  CHECK_EQ(isolate->AdjustAmountOfExternalAllocatedMemory(1024), base + 1024);
+  CHECK_EQ(lwIsolate->external_memory(), base + 1024);
+
+  v8::HeapStatistics statistics;
+  isolate->GetHeapStatistics(&statistics);
+  CHECK_GE(statistics.external_memory(), static_cast<size_t>(base + 1024));
+
+  // data slots are kept apart from the counter
+  static int data;
+  isolate->SetData(3, &data);
+  CHECK_EQ(isolate->GetData(3), &data);
+  CHECK_EQ(lwIsolate->external_memory(), base + 1024);
+  isolate->SetData(3, nullptr);
+
+  // crossing the soft limit nudges the collector on the main loop
+  lwIsolate->ResetExternalMemoryLimit();
+  gcStrategy->takeEvents();
+  isolate->AdjustAmountOfExternalAllocatedMemory(kSoftLimit + 1);
+  gcStrategy->handle(isolate);
+  auto events = gcStrategy->takeEvents();
+  CHECK_EQ(events.size(), 1u);
+  CHECK(events[0].level == v8::MemoryPressureLevel::kModerate);
+
+  isolate->AdjustAmountOfExternalAllocatedMemory(-(kSoftLimit + 1) - 1024);
+  CHECK_EQ(lwIsolate->external_memory(), base);
+}
+
+static void FunctionDispatchCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  info.GetReturnValue().Set(info.Length());
+}
+
+TEST(internal_FunctionDispatch) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+
+  auto base = v8::FunctionTemplate::New(isolate);
+  auto derived = v8::FunctionTemplate::New(isolate);
+  derived->Inherit(base);
+  auto other = v8::FunctionTemplate::New(isolate);
+  base->PrototypeTemplate()->Set(
+      v8_str("m"),
+      v8::FunctionTemplate::New(isolate,
+                                FunctionDispatchCallback,
+                                v8::Local<v8::Value>(),
+                                v8::Signature::New(isolate, base)));
+
+  auto global = env->Global();
+  auto setFunction = [&](const char* name,
+                         v8::Local<v8::FunctionTemplate> tpl) {
+    global
+        ->Set(env.local(),
+              v8_str(name),
+              tpl->GetFunction(env.local()).ToLocalChecked())
+        .FromJust();
+  };
+  setFunction("Base", base);
+  setFunction("Derived", derived);
+  setFunction("Other", other);
+  setFunction("f",
+              v8::FunctionTemplate::New(isolate, FunctionDispatchCallback));
+
+  CompileRun(
+      "var m = Base.prototype.m;"
+      "var b = new Base(); var d = new Derived(); var o = new Other();");
+
+  // a function instantiated by the engine gets its FunctionData on the
+  // first call, which is reused by the later calls
+  auto esMethod = reinterpret_cast<ValueWrap*>(*CompileRun("m"))->value();
+  auto methodData = ExtraDataHelper::getExtraData(esMethod->asObject());
+  CHECK(!methodData->isFunctionData());
+  CHECK_EQ(CompileRun("b.m(1)")->Int32Value(env.local()).FromJust(), 1);
+  methodData = ExtraDataHelper::getExtraData(esMethod->asObject());
+  CHECK(methodData->isFunctionData());
+  CHECK_EQ(CompileRun("d.m(1, 2)")->Int32Value(env.local()).FromJust(), 2);
+  CHECK_EQ(ExtraDataHelper::getExtraData(esMethod->asObject()), methodData);
+
+  // the receiver accepted last doesn't make other receivers pass
+  auto throws = [&](const char* source) {
+    v8::TryCatch tryCatch(isolate);
+    CompileRun(source);
+    return tryCatch.HasCaught();
+  };
+  CHECK(!throws("d.m()"));
+  CHECK(throws("m.call(o)"));
+  CHECK(throws("m.call({})"));
+  CHECK(!throws("m.call(b)"));
+  CHECK(!throws("d.m()"));
+  CHECK_EQ(CompileRun("f(1, 2, 3)")->Int32Value(env.local()).FromJust(), 3);
+}
+
+static void NestedApiCallsCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  auto isolate = info.GetIsolate();
+  auto context = isolate->GetCurrentContext();
+  auto lwIsolate = IsolateWrap::fromV8(isolate);
+  CHECK_NOT_NULL(lwIsolate->currentExecutionState());
+
+  // the exceptions of a nested call are caught by a TryCatch of the callback
+  auto object = info[0].As<v8::Object>();
+  {
+    v8::TryCatch tryCatch(isolate);
+    CHECK(object->Get(context, v8_str("thrower")).IsEmpty());
+    CHECK(tryCatch.HasCaught());
+    CHECK(tryCatch.Exception()->StrictEquals(v8_str("thrown")));
+  }
+
+  const int count = info[1]->Int32Value(context).FromJust();
+  int sum = 0;
+  for (int i = 0; i < count; i++) {
+    sum += object->Get(context, v8_str("value"))
+               .ToLocalChecked()
+               ->Int32Value(context)
+               .FromJust();
+  }
+  info.GetReturnValue().Set(sum);
+}
+
+TEST(internal_NestedApiCalls) {
+  LocalContext env;
+  auto isolate = env->GetIsolate();
+  v8::HandleScope scope(isolate);
+  auto lwIsolate = IsolateWrap::fromV8(isolate);
+
+  auto function = v8::FunctionTemplate::New(isolate, NestedApiCallsCallback)
+                      ->GetFunction(env.local())
+                      .ToLocalChecked();
+  env->Global()->Set(env.local(), v8_str("f"), function).FromJust();
+  auto object = CompileRun(
+                    "var o = { value: 1, get thrower() { throw 'thrown'; } };"
+                    "o")
+                    .As<v8::Object>();
+
+  CHECK(lwIsolate->currentExecutionState() == nullptr);
+  CHECK_EQ(CompileRun("f(o, 3)")->Int32Value(env.local()).FromJust(), 3);
+  CHECK(lwIsolate->currentExecutionState() == nullptr);
+
+  // the same calls outside of a callback run on the context
+  CHECK_EQ(object->Get(env.local(), v8_str("value"))
+               .ToLocalChecked()
+               ->Int32Value(env.local())
+               .FromJust(),
+           1);
+  CHECK(lwIsolate->currentExecutionState() == nullptr);
+}
+
 #endif